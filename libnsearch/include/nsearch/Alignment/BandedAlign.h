@@ -5,6 +5,7 @@
 
 #include <cassert>
 #include <iostream>
+#include <limits>
 #include <vector>
 
 typedef struct BandedAlignParams {
@@ -68,6 +69,7 @@ private:
 
   using Scores = std::vector< int >;
   using Gaps   = std::vector< Gap >;
+  using Slacks = std::vector< double >;
 
   void PrintRow( const size_t width ) {
     for( int i = 0; i < width; i++ ) {
@@ -81,20 +83,45 @@ private:
     printf( "\n" );
   }
 
+  // First column of the band in row y (the band follows the diagonal)
+  size_t BandStart( const size_t y, const size_t width ) const {
+    size_t bw = mParams.bandwidth;
+    return std::min( y > bw ? ( y - bw ) : 0, width - 1 );
+  }
+
+  // Slack of a cell: the highest differencesPerMatch * matches - differences
+  // of any path to it (terminal gaps aren't counted)
+  static double NoPath() {
+    return -std::numeric_limits< double >::infinity();
+  }
+
   Scores            mScores;
+  Slacks            mSlacks;
   Gaps              mVerticalGaps;
-  CigarOps          mOperations;
+  CigarOps          mOperations; // only cells within the band, row by row
   BandedAlignParams mParams;
 
 public:
   BandedAlign( const BandedAlignParams& params = BandedAlignParams() )
       : mParams( params ) {}
 
+  // Returned by Align if the alignment was given up on, see maxDifferences
+  static int Rejected() {
+    return MinInt();
+  }
+
+  // The alignment may have at most maxDifferences + differencesPerMatch *
+  // matches differences (mismatches and gap columns). It is given up on as
+  // soon as no path through the band can stay within that, even if all
+  // remaining columns were matches.
   int Align( const Sequence< Alphabet >& A, const Sequence< Alphabet >& B,
              Cigar*                   cigar = NULL,
              const AlignmentDirection dir   = AlignmentDirection::Forward,
              size_t startA = 0, size_t startB = 0, size_t endA = -1,
-             size_t endB = -1 ) {
+             size_t endB = -1,
+             const double maxDifferences =
+               std::numeric_limits< double >::infinity(),
+             const double differencesPerMatch = 0.0 ) {
     // Calculate matrix width, depending on alignment
     // direction and length of sequences
     // A will be on the X axis (width of matrix)
@@ -133,13 +160,25 @@ public:
       mVerticalGaps = Gaps( width * 1.5, mParams );
     }
 
-    if( mOperations.capacity() < width * height ) {
-      mOperations = CigarOps( width * height * 1.5 );
+    const bool trackDifferences =
+      ( maxDifferences < std::numeric_limits< double >::infinity() );
+    if( trackDifferences && mSlacks.size() < width ) {
+      mSlacks.resize( width * 1.5 );
     }
 
     // Initialize first row
     size_t bw = mParams.bandwidth;
 
+    // Store traceback information for the band only, so memory grows
+    // linearly with the length of the sequences. Since the band follows
+    // the diagonal, we never need more than width + bw rows.
+    // The first row consists of insertions only and is not stored.
+    size_t bandSize = 2 * bw + 1;
+    size_t numRows  = std::min( height, width + bw + 1 );
+    if( mOperations.size() < numRows * bandSize ) {
+      mOperations.resize( numRows * bandSize * 1.5 );
+    }
+
     bool fromBeginningA = ( startA == 0 || startA == lenA );
     bool fromBeginningB = ( startB == 0 || startB == lenB );
 
@@ -159,14 +198,21 @@ public:
         break;
 
       horizontalGap.OpenOrExtend( mScores[ x - 1 ], fromBeginningA );
-      mScores[ x ]     = horizontalGap.Score();
-      mOperations[ x ] = CigarOp::Insertion;
+      mScores[ x ] = horizontalGap.Score();
       mVerticalGaps[ x ].Reset();
     }
     if( x < width ) {
       mScores[ x ] = MinInt();
       mVerticalGaps[ x ].Reset();
     }
+    if( trackDifferences ) {
+      for( size_t i = 0; i < x; i++ ) {
+        mSlacks[ i ] = fromBeginningB ? 0.0 : -double( i );
+      }
+      if( x < width ) {
+        mSlacks[ x ] = NoPath();
+      }
+    }
     /* PrintRow( width ); */
 
     // Row by row...
@@ -176,20 +222,27 @@ public:
       int score = MinInt();
 
       // Calculate band bounds
-      size_t leftBound =
-        std::min( center > bw ? ( center - bw ) : 0, width - 1 );
+      size_t leftBound  = BandStart( center, width );
       size_t rightBound = std::min( center + bw, width - 1 );
 
       // Set diagonal score for first calculated cell in row
-      int diagScore = MinInt();
+      int    diagScore = MinInt();
+      double diagSlack = NoPath();
       if( leftBound > 0 ) {
         diagScore                = mScores[ leftBound - 1 ];
         mScores[ leftBound - 1 ] = MinInt();
         mVerticalGaps[ leftBound - 1 ].Reset();
+
+        if( trackDifferences ) {
+          diagSlack                = mSlacks[ leftBound - 1 ];
+          mSlacks[ leftBound - 1 ] = NoPath();
+        }
       }
 
       // Calculate row within the band bounds
       horizontalGap.Reset();
+      double leftSlack = NoPath();
+      double bestSlack = NoPath();
       for( x = leftBound; x <= rightBound; x++ ) {
         // Calculate diagonal score
         size_t aIdx = 0, bIdx = 0;
@@ -230,7 +283,7 @@ public:
         } else {
           op = match ? CigarOp::Match : CigarOp::Mismatch;
         }
-        mOperations[ y * width + x ] = op;
+        mOperations[ y * bandSize + x - leftBound ] = op;
 
         // Calculate potential gaps
         bool isTerminalA = ( x == 0 || x == width - 1 ) && fromEndA;
@@ -238,11 +291,42 @@ public:
 
         horizontalGap.OpenOrExtend( score, isTerminalB );
         verticalGap.OpenOrExtend( score, isTerminalA );
+
+        if( trackDifferences ) {
+          bool   freeLeft = ( y == height - 1 && fromEndB );
+          bool   freeUp   = ( x == 0 && fromBeginningA ) ||
+                        ( x == width - 1 && fromEndA );
+          double slack    = std::max( leftSlack - ( freeLeft ? 0.0 : 1.0 ),
+                                   mSlacks[ x ] - ( freeUp ? 0.0 : 1.0 ) );
+          if( x > 0 ) {
+            slack = std::max( slack, diagSlack + ( match ? differencesPerMatch
+                                                         : -1.0 ) );
+          }
+
+          diagSlack    = mSlacks[ x ];
+          mSlacks[ x ] = slack;
+          leftSlack    = slack;
+
+          // At best, the rest of the path is all matches
+          size_t remaining = std::min( width - 1 - x, height - 1 - y );
+          bestSlack =
+            std::max( bestSlack, slack + differencesPerMatch * remaining );
+        }
       }
 
       if( rightBound + 1 < width ) {
         mScores[ rightBound + 1 ] = MinInt();
         mVerticalGaps[ rightBound + 1 ].Reset();
+        if( trackDifferences ) {
+          mSlacks[ rightBound + 1 ] = NoPath();
+        }
+      }
+
+      if( trackDifferences && maxDifferences + bestSlack < 0.0 ) {
+        if( cigar ) {
+          cigar->Clear();
+        }
+        return Rejected();
       }
 
       hitEnd = ( rightBound == leftBound );
@@ -261,8 +345,17 @@ public:
       CigarEntry ce;
       cigar->Clear();
       while( bx != 0 || by != 0 ) {
-        CigarOp op = mOperations[ by * width + bx ];
-        cigar->Add( op );
+        CigarOp op = CigarOp::Insertion;
+        if( by > 0 ) {
+          size_t leftBound = BandStart( by, width );
+          assert( bx >= leftBound && bx - leftBound < bandSize );
+          op = mOperations[ by * bandSize + bx - leftBound ];
+        }
+        if( op != ce.op ) {
+          cigar->Add( ce );
+          ce = CigarEntry( 0, op );
+        }
+        ce.count++;
 
         switch( op ) {
           case CigarOp::Insertion:
@@ -284,6 +377,7 @@ public:
             break;
         }
       }
+      cigar->Add( ce );
 
       cigar->Reverse();
     }
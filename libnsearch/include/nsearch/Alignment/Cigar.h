@@ -2,7 +2,8 @@
 
 #include "nsearch/Utils.h"
 
-#include <deque>
+#include <cstdint>
+#include <cstring>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
@@ -31,8 +32,37 @@ public:
   }
 };
 
-class Cigar : public std::deque< CigarEntry > {
+// Entries are stored contiguously, packed like in BAM (count << 4 | op).
+// Short cigars (the common case for HSPs) live in an inline buffer.
+class Cigar {
 public:
+  using PackedEntry = uint32_t;
+
+  class const_iterator {
+  public:
+    const_iterator( const PackedEntry* entry ) : mEntry( entry ) {}
+
+    CigarEntry operator*() const {
+      return Unpack( *mEntry );
+    }
+
+    const_iterator& operator++() {
+      mEntry++;
+      return *this;
+    }
+
+    bool operator==( const const_iterator& other ) const {
+      return mEntry == other.mEntry;
+    }
+
+    bool operator!=( const const_iterator& other ) const {
+      return mEntry != other.mEntry;
+    }
+
+  private:
+    const PackedEntry* mEntry;
+  };
+
   Cigar() {}
 
   Cigar( const char* str ) : Cigar( std::string( str ) ) {}
@@ -66,25 +96,95 @@ public:
     }
   }
 
+  Cigar( const Cigar& other ) {
+    *this = other;
+  }
+
+  Cigar( Cigar&& other ) {
+    *this = std::move( other );
+  }
+
+  Cigar& operator=( const Cigar& other ) {
+    if( this == &other )
+      return *this;
+
+    mSize = 0;
+    Reserve( other.mSize );
+    memcpy( mData, other.mData, other.mSize * sizeof( PackedEntry ) );
+    mSize       = other.mSize;
+    mNumColumns = other.mNumColumns;
+    mNumMatches = other.mNumMatches;
+    return *this;
+  }
+
+  Cigar& operator=( Cigar&& other ) {
+    if( this == &other )
+      return *this;
+
+    if( other.mData == other.mInline ) {
+      *this = static_cast< const Cigar& >( other );
+    } else {
+      // Take over the heap buffer
+      mHeap.swap( other.mHeap );
+      mData       = mHeap.data();
+      mSize       = other.mSize;
+      mCapacity   = other.mCapacity;
+      mNumColumns = other.mNumColumns;
+      mNumMatches = other.mNumMatches;
+
+      other.mHeap.clear();
+      other.mData     = other.mInline;
+      other.mCapacity = InlineCapacity;
+    }
+
+    other.Clear();
+    return *this;
+  }
+
   Cigar operator+( const Cigar& other ) const {
     Cigar ce = *this;
-    for( auto& c : other )
-      ce.Add( c );
+    ce += other;
     return ce;
   }
 
   Cigar& operator+=( const Cigar& other ) {
-    for( auto& c : other )
-      Add( c );
+    if( other.empty() )
+      return *this;
+
+    // Add and Reserve would change (or free) the entries copied from
+    if( &other == this ) {
+      Cigar copy = other;
+      return *this += copy;
+    }
+
+    const PackedEntry* src   = other.mData;
+    size_t             count = other.mSize;
+
+    // The first entry might continue our last run
+    if( !empty() && ( mData[ mSize - 1 ] & 0xF ) == ( src[ 0 ] & 0xF ) ) {
+      Add( Unpack( src[ 0 ] ) );
+      src++;
+      count--;
+    }
+
+    Reserve( mSize + count );
+    memcpy( mData + mSize, src, count * sizeof( PackedEntry ) );
+    mSize += count;
+
+    for( size_t i = 0; i < count; i++ ) {
+      Count( Unpack( src[ i ] ) );
+    }
     return *this;
   }
 
   void Clear() {
-    clear();
+    mSize       = 0;
+    mNumColumns = 0;
+    mNumMatches = 0;
   }
 
   void Reverse() {
-    std::reverse( begin(), end() );
+    std::reverse( mData, mData + mSize );
   }
 
   void Add( const CigarOp& op ) {
@@ -92,53 +192,160 @@ public:
   }
 
   void Add( const CigarEntry& entry ) {
-    if( entry.count == 0 )
+    if( entry.count <= 0 )
       return;
 
     if( entry.op == CigarOp::Unknown )
       return;
 
-    if( empty() ) {
-      push_back( entry );
+    Count( entry );
+
+    PackedEntry packed = Pack( entry );
+    if( !empty() && ( mData[ mSize - 1 ] & 0xF ) == ( packed & 0xF ) ) {
+      // merge
+      mData[ mSize - 1 ] += packed & ~PackedEntry( 0xF );
     } else {
-      auto& last = *rbegin();
-      if( last.op == entry.op ) {
-        // merge
-        last.count += entry.count;
-      } else {
-        push_back( entry );
-      }
+      Reserve( mSize + 1 );
+      mData[ mSize++ ] = packed;
     }
   }
 
+  // Terminal gaps don't count towards identity
   float Identity() const {
-    size_t cols    = 0;
-    size_t matches = 0;
+    size_t cols = NumInteriorColumns();
+    return cols > 0 ? float( mNumMatches ) / float( cols ) : 0.0f;
+  }
 
-    for( const CigarEntry& c : *this ) {
-      // Don't count terminal gaps towards identity calculation
-      if( &c == &( *this->cbegin() ) &&
-          ( c.op == CigarOp::Insertion || c.op == CigarOp::Deletion ) )
-        continue;
-      if( &c == &( *this->crbegin() ) &&
-          ( c.op == CigarOp::Insertion || c.op == CigarOp::Deletion ) )
-        continue;
-
-      cols += c.count;
-      if( c.op == CigarOp::Match )
-        matches += c.count;
-    }
+  size_t NumMatches() const {
+    return mNumMatches;
+  }
 
-    return cols > 0 ? float( matches ) / float( cols ) : 0.0f;
+  // Mismatches and interior gap columns
+  size_t NumDifferences() const {
+    return NumInteriorColumns() - mNumMatches;
   }
 
   std::string ToString() const {
     std::stringstream ss;
-    for( auto& c : *this ) {
+    for( const CigarEntry& c : *this ) {
       ss << c.count << ( char ) c.op;
     }
     return ss.str();
   }
+
+  // Container access
+  bool empty() const {
+    return mSize == 0;
+  }
+
+  size_t size() const {
+    return mSize;
+  }
+
+  CigarEntry operator[]( const size_t index ) const {
+    return Unpack( mData[ index ] );
+  }
+
+  CigarEntry front() const {
+    return Unpack( mData[ 0 ] );
+  }
+
+  CigarEntry back() const {
+    return Unpack( mData[ mSize - 1 ] );
+  }
+
+  void pop_front() {
+    Uncount( front() );
+    memmove( mData, mData + 1, ( mSize - 1 ) * sizeof( PackedEntry ) );
+    mSize--;
+  }
+
+  void pop_back() {
+    Uncount( back() );
+    mSize--;
+  }
+
+  const_iterator begin() const {
+    return const_iterator( mData );
+  }
+
+  const_iterator end() const {
+    return const_iterator( mData + mSize );
+  }
+
+  // BAM encoding
+  const PackedEntry* data() const {
+    return mData;
+  }
+
+  static PackedEntry Pack( const CigarEntry& entry ) {
+    PackedEntry code;
+    switch( entry.op ) {
+      case CigarOp::Insertion: code = 1; break;
+      case CigarOp::Deletion: code = 2; break;
+      case CigarOp::Match: code = 7; break;
+      case CigarOp::Mismatch: code = 8; break;
+      default: code = 0; break;
+    }
+    return ( PackedEntry( entry.count ) << 4 ) | code;
+  }
+
+  static CigarEntry Unpack( const PackedEntry packed ) {
+    return CigarEntry( int( packed >> 4 ),
+                       ( CigarOp ) "MIDNSHP=X"[ packed & 0xF ] );
+  }
+
+private:
+  static const size_t InlineCapacity = 8;
+
+  PackedEntry                mInline[ InlineCapacity ];
+  std::vector< PackedEntry > mHeap;
+  PackedEntry*               mData     = mInline;
+  size_t                     mSize     = 0;
+  size_t                     mCapacity = InlineCapacity;
+
+  size_t mNumColumns = 0;
+  size_t mNumMatches = 0;
+
+  void Reserve( const size_t capacity ) {
+    if( capacity <= mCapacity )
+      return;
+
+    std::vector< PackedEntry > heap( std::max( capacity, mCapacity * 2 ) );
+    memcpy( heap.data(), mData, mSize * sizeof( PackedEntry ) );
+    mHeap.swap( heap );
+    mData     = mHeap.data();
+    mCapacity = mHeap.size();
+  }
+
+  size_t NumInteriorColumns() const {
+    if( empty() )
+      return 0;
+
+    size_t     cols  = mNumColumns;
+    CigarEntry first = front();
+    if( first.op == CigarOp::Insertion || first.op == CigarOp::Deletion )
+      cols -= first.count;
+
+    CigarEntry last = back();
+    if( mSize > 1 &&
+        ( last.op == CigarOp::Insertion || last.op == CigarOp::Deletion ) )
+      cols -= last.count;
+
+    return cols;
+  }
+
+  void Count( const CigarEntry& entry ) {
+    mNumColumns += entry.count;
+    if( entry.op == CigarOp::Match )
+      mNumMatches += entry.count;
+  }
+
+  void Uncount( const CigarEntry& entry ) {
+    mNumColumns -= entry.count;
+    if( entry.op == CigarOp::Match )
+      mNumMatches -= entry.count;
+  }
 };
 
 static std::ostream& operator<<( std::ostream& os, const Cigar& cigar ) {
@@ -28,6 +28,15 @@ private:
   };
   using Cells = std::vector< Cell >;
 
+  // Traceback information is only stored for the cells which passed the
+  // X-Drop bounds, so memory grows with the explored area of the matrix
+  // rather than width * height
+  struct OperationsRow {
+    size_t offset; // index of the first cell in mOperations
+    size_t firstX;
+  };
+  using OperationsRows = std::vector< OperationsRow >;
+
   void Print( const Cells& row ) {
     for( auto& c : row ) {
       if( c.score <= MinInt() ) {
@@ -42,6 +51,17 @@ private:
   ExtendAlignParams mAP;
   Cells             mRow;
   CigarOps          mOperations;
+  OperationsRows    mOperationsRows;
+
+  void BeginOperationsRow( const size_t firstX ) {
+    mOperationsRows.push_back( { mOperations.size(), firstX } );
+  }
+
+  CigarOp OperationAt( const size_t x, const size_t y ) const {
+    const OperationsRow& row = mOperationsRows[ y ];
+    assert( x >= row.firstX && row.offset + x - row.firstX < mOperations.size() );
+    return mOperations[ row.offset + x - row.firstX ];
+  }
 
 public:
   ExtendAlign( const ExtendAlignParams& ap = ExtendAlignParams() )
@@ -76,9 +96,8 @@ public:
       mRow = Cells( width * 1.5 );
     }
 
-    if( mOperations.capacity() < width * height ) {
-      mOperations = CigarOps( width * height * 1.5 );
-    }
+    mOperations.clear();
+    mOperationsRows.clear();
 
     bestX = 0;
     bestY = 0;
@@ -92,13 +111,16 @@ public:
     mRow[ 0 ].score    = 0;
     mRow[ 0 ].scoreGap = mAP.gapOpenScore + mAP.gapExtendScore;
 
+    BeginOperationsRow( 0 );
+    mOperations.push_back( CigarOp::Unknown );
+
     for( x = 1; x < width; x++ ) {
       score = mAP.gapOpenScore + x * mAP.gapExtendScore;
 
       if( score < -mAP.xDrop )
         break;
 
-      mOperations[ x ]   = CigarOp::Insertion;
+      mOperations.push_back( CigarOp::Insertion );
       mRow[ x ].score    = score;
       mRow[ x ].scoreGap = MinInt();
     }
@@ -115,6 +137,7 @@ public:
 
       size_t lastX = firstX;
 
+      BeginOperationsRow( firstX );
       for( x = firstX; x < rowSize; x++ ) {
         int colGap = mRow[ x ].scoreGap;
 
@@ -153,6 +176,7 @@ public:
         if( bestScore - score > mAP.xDrop ) {
           // X-Drop test failed
           mRow[ x ].score = MinInt();
+          mOperations.push_back( CigarOp::Unknown );
 
           if( x == firstX ) {
             // Tighten left bound
@@ -183,7 +207,7 @@ public:
           } else {
             op = match ? CigarOp::Match : CigarOp::Mismatch;
           }
-          mOperations[ y * width + x ] = op;
+          mOperations.push_back( op );
 
           mRow[ x ].score = score;
           mRow[ x ].scoreGap =
@@ -209,7 +233,7 @@ public:
           mRow[ rowSize ].score = rowGap;
           mRow[ rowSize ].scoreGap =
             rowGap + mAP.gapOpenScore + mAP.gapExtendScore;
-          mOperations[ y * width + rowSize ] = CigarOp::Insertion;
+          mOperations.push_back( CigarOp::Insertion );
           rowGap += mAP.gapExtendScore;
           rowSize++;
         }
@@ -228,11 +252,16 @@ public:
       size_t bx = bestX;
       size_t by = bestY;
 
+      // Collect runs, add each of them at once
       CigarEntry ce;
       cigar->Clear();
       while( bx != 0 || by != 0 ) {
-        CigarOp op = mOperations[ by * width + bx ];
-        cigar->Add( op );
+        CigarOp op = OperationAt( bx, by );
+        if( op != ce.op ) {
+          cigar->Add( ce );
+          ce = CigarEntry( 0, op );
+        }
+        ce.count++;
 
         switch( op ) {
           case CigarOp::Insertion:
@@ -254,6 +283,7 @@ public:
             break;
         }
       }
+      cigar->Add( ce );
 
       if( dir == AlignmentDirection::Forward ) {
         cigar->Reverse();
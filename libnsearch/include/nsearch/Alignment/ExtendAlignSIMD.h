@@ -0,0 +1,517 @@
+#pragma once
+
+#include "Cigar.h"
+#include "Common.h"
+#include "ExtendAlign.h"
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if defined( __SSE2__ ) || defined( _M_X64 )
+#define NSEARCH_EXTEND_ALIGN_SSE2 1
+#include <emmintrin.h>
+#ifdef __SSE4_1__
+#include <smmintrin.h>
+#endif
+#endif
+
+#ifdef NSEARCH_EXTEND_ALIGN_SSE2
+namespace ExtendAlignSSE2 {
+inline __m128i Max( const __m128i a, const __m128i b ) {
+#ifdef __SSE4_1__
+  return _mm_max_epi32( a, b );
+#else
+  __m128i mask = _mm_cmpgt_epi32( a, b );
+  return _mm_or_si128( _mm_and_si128( mask, a ), _mm_andnot_si128( mask, b ) );
+#endif
+}
+
+// mask ? a : b
+inline __m128i Select( const __m128i mask, const __m128i a, const __m128i b ) {
+  return _mm_or_si128( _mm_and_si128( mask, a ), _mm_andnot_si128( mask, b ) );
+}
+
+inline int32_t HorizontalMax( __m128i v ) {
+  v = Max( v, _mm_shuffle_epi32( v, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+  v = Max( v, _mm_shuffle_epi32( v, _MM_SHUFFLE( 2, 3, 0, 1 ) ) );
+  return _mm_cvtsi128_si32( v );
+}
+} // namespace ExtendAlignSSE2
+#endif
+
+// X-Drop extension computed along anti-diagonals (as done by libgaba
+// or ksw2's extension mode). Cells on the same anti-diagonal do not depend
+// on each other, so they are computed four at a time.
+//
+// Same interface as ExtendAlign (which remains the reference
+// implementation). Without any cells dropped, the returned score,
+// bestA/bestB and traceback are the same. The X-Drop test however is done
+// against the best score up to the current anti-diagonal rather than the
+// current cell in row-major order, so paths along the boundary ExtendAlign
+// cuts off may be followed, leading to a higher score and a different best
+// cell. Therefore not used by GlobalSearch yet.
+template < typename Alphabet >
+class ExtendAlignSIMD {
+private:
+  using Scores = std::vector< int32_t >;
+
+  // Traceback ops per cell, compact
+  enum Op : uint8_t { Diagonal = 0, Horizontal = 1, Vertical = 2 };
+
+  struct OperationsDiagonal {
+    size_t offset; // index of the first cell in mOperations
+    size_t firstX;
+  };
+  using OperationsDiagonals = std::vector< OperationsDiagonal >;
+
+  // Number of cells computed at once
+  static const size_t Lanes = 4;
+
+  // Scores of the last two anti-diagonals and the current one,
+  // indexed by x + 1 (x = -1 serves as sentinel)
+  Scores mH[ 3 ], mE[ 2 ], mF[ 2 ];
+  Scores mSubstitutionScores;
+
+  // A in alignment direction and B against it, so the characters of an
+  // anti-diagonal are contiguous in both
+  std::string mA, mB;
+
+  // If all letters occurring in A and B score either uniform match or
+  // mismatch scores against each other (e.g. DNA without ambiguous
+  // nucleotides), substitution scores are computed by comparing letters
+  bool    mUniformScores;
+  int32_t mMatchScore, mMismatchScore;
+
+  void DetermineUniformScores( const bool* seen ) {
+    std::vector< char > letters;
+    for( int ch = 0; ch < 256; ch++ ) {
+      if( seen[ ch ] )
+        letters.push_back( char( ch ) );
+    }
+
+    mUniformScores = !letters.empty();
+    mMatchScore    = 0;
+    mMismatchScore = MinInt();
+    for( size_t i = 0; i < letters.size() && mUniformScores; i++ ) {
+      for( size_t j = 0; j < letters.size() && mUniformScores; j++ ) {
+        int32_t score =
+          ScorePolicy< Alphabet >::Score( letters[ i ], letters[ j ] );
+        int32_t& uniformScore = ( i == j ) ? mMatchScore : mMismatchScore;
+        if( i == 0 && j <= 1 ) {
+          uniformScore = score;
+        } else if( score != uniformScore ) {
+          mUniformScores = false;
+        }
+      }
+    }
+  }
+
+  std::vector< uint8_t > mOperations;
+  OperationsDiagonals    mOperationsDiagonals;
+
+  ExtendAlignParams mAP;
+
+  void EnsureCapacity( const size_t width ) {
+    size_t size = width + 2 * Lanes + 2;
+    if( mSubstitutionScores.size() >= size )
+      return;
+
+    size = size * 1.5;
+    for( auto& s : mH )
+      s.assign( size, MinInt() );
+    for( auto& s : mE )
+      s.assign( size, MinInt() );
+    for( auto& s : mF )
+      s.assign( size, MinInt() );
+    mSubstitutionScores.assign( size, 0 );
+  }
+
+  // Computes cells [lo, hi] of the current anti-diagonal, cells scoring
+  // below threshold are cleared right away
+  void ComputeDiagonal( const size_t lo, const size_t hi, const ptrdiff_t offB,
+                        const int32_t* H0, const int32_t* H1, const int32_t* E1,
+                        const int32_t* F1, int32_t* H, int32_t* E, int32_t* F,
+                        uint8_t* ops, const int32_t threshold,
+                        int32_t* diagonalBest ) const {
+    const int32_t* S         = mSubstitutionScores.data();
+    const char*    seqA      = mA.data();
+    const char*    seqB      = mB.data();
+    const int32_t  gapOpen   = mAP.gapOpenScore + mAP.gapExtendScore;
+    const int32_t  gapExtend = mAP.gapExtendScore;
+
+    // Cell x lives at index x + 1:
+    //  - diagonal (x - 1, y - 1) at H0[ x ]
+    //  - left (x - 1, y) at H1[ x ], E1[ x ]
+    //  - up (x, y - 1) at H1[ x + 1 ], F1[ x + 1 ]
+    size_t x = lo;
+
+#ifdef NSEARCH_EXTEND_ALIGN_SSE2
+    using namespace ExtendAlignSSE2;
+
+    const __m128i vGapOpen   = _mm_set1_epi32( gapOpen );
+    const __m128i vGapExtend = _mm_set1_epi32( gapExtend );
+    const __m128i vMinInt    = _mm_set1_epi32( MinInt() );
+    const __m128i vOne       = _mm_set1_epi32( 1 );
+    const __m128i vTwo       = _mm_set1_epi32( 2 );
+    const __m128i vLaneIdx   = _mm_set_epi32( 3, 2, 1, 0 );
+    const __m128i vLast      = _mm_set1_epi32( int32_t( hi ) );
+    const __m128i vThreshold = _mm_set1_epi32( threshold );
+    const __m128i vMatch     = _mm_set1_epi32( mMatchScore );
+    const __m128i vMismatch  = _mm_set1_epi32( mMismatchScore );
+
+    __m128i vBest = vMinInt;
+    for( ; x <= hi; x += Lanes ) {
+      __m128i diag = _mm_loadu_si128( ( const __m128i* )( H0 + x ) );
+      __m128i left = _mm_loadu_si128( ( const __m128i* )( H1 + x ) );
+      __m128i leftE = _mm_loadu_si128( ( const __m128i* )( E1 + x ) );
+      __m128i up    = _mm_loadu_si128( ( const __m128i* )( H1 + x + 1 ) );
+      __m128i upF   = _mm_loadu_si128( ( const __m128i* )( F1 + x + 1 ) );
+
+      __m128i subst;
+      if( mUniformScores ) {
+        int32_t lettersA, lettersB;
+        memcpy( &lettersA, seqA + x, sizeof( lettersA ) );
+        memcpy( &lettersB, seqB + ptrdiff_t( x ) + offB, sizeof( lettersB ) );
+        __m128i same = _mm_cmpeq_epi8( _mm_cvtsi32_si128( lettersA ),
+                                       _mm_cvtsi32_si128( lettersB ) );
+        same  = _mm_unpacklo_epi8( same, same );
+        same  = _mm_unpacklo_epi16( same, same );
+        subst = Select( same, vMatch, vMismatch );
+      } else {
+        subst = _mm_loadu_si128( ( const __m128i* )( S + x + 1 ) );
+      }
+
+      __m128i e = Max( _mm_add_epi32( left, vGapOpen ),
+                       _mm_add_epi32( leftE, vGapExtend ) );
+      __m128i f = Max( _mm_add_epi32( up, vGapOpen ),
+                       _mm_add_epi32( upF, vGapExtend ) );
+      __m128i h = Max( _mm_add_epi32( diag, subst ), Max( e, f ) );
+
+      // Same priorities as ExtendAlign: horizontal, vertical, diagonal
+      __m128i isE = _mm_cmpeq_epi32( h, e );
+      __m128i isF = _mm_andnot_si128( isE, _mm_cmpeq_epi32( h, f ) );
+      __m128i op  = _mm_or_si128( _mm_and_si128( isE, vOne ),
+                                 _mm_and_si128( isF, vTwo ) );
+      op = _mm_packs_epi32( op, op );
+      op = _mm_packus_epi16( op, op );
+      int32_t packed = _mm_cvtsi128_si32( op );
+      memcpy( ops + x - lo, &packed, sizeof( packed ) );
+
+      // X-Drop test, also clear lanes beyond the anti-diagonal
+      __m128i drop = _mm_cmpgt_epi32( vThreshold, h );
+      if( x + Lanes - 1 > hi ) {
+        drop = _mm_or_si128(
+          drop, _mm_cmpgt_epi32( _mm_add_epi32( _mm_set1_epi32( int32_t( x ) ),
+                                                vLaneIdx ),
+                                 vLast ) );
+      }
+      h = Select( drop, vMinInt, h );
+      e = Select( drop, vMinInt, e );
+      f = Select( drop, vMinInt, f );
+
+      _mm_storeu_si128( ( __m128i* )( H + x + 1 ), h );
+      _mm_storeu_si128( ( __m128i* )( E + x + 1 ), e );
+      _mm_storeu_si128( ( __m128i* )( F + x + 1 ), f );
+
+      vBest = Max( vBest, h );
+    }
+
+    *diagonalBest = HorizontalMax( vBest );
+#else
+    int32_t best = MinInt();
+    for( ; x <= hi; x++ ) {
+      int32_t e = std::max( H1[ x ] + gapOpen, E1[ x ] + gapExtend );
+      int32_t f = std::max( H1[ x + 1 ] + gapOpen, F1[ x + 1 ] + gapExtend );
+      int32_t subst =
+        mUniformScores
+          ? ( seqA[ x ] == seqB[ ptrdiff_t( x ) + offB ] ? mMatchScore
+                                                         : mMismatchScore )
+          : S[ x + 1 ];
+      int32_t h = std::max( H0[ x ] + subst, std::max( e, f ) );
+
+      ops[ x - lo ] = h == e ? Horizontal : ( h == f ? Vertical : Diagonal );
+
+      if( h < threshold ) {
+        h = e = f = MinInt();
+      }
+
+      H[ x + 1 ] = h;
+      E[ x + 1 ] = e;
+      F[ x + 1 ] = f;
+
+      best = std::max( best, h );
+    }
+
+    *diagonalBest = best;
+#endif
+  }
+
+  // Clears cells which failed the X-Drop test
+  void Prune( const size_t lo, const size_t hi, const int32_t threshold,
+              int32_t* H, int32_t* E, int32_t* F ) const {
+    size_t x = lo;
+
+#ifdef NSEARCH_EXTEND_ALIGN_SSE2
+    using namespace ExtendAlignSSE2;
+
+    const __m128i vThreshold = _mm_set1_epi32( threshold );
+    const __m128i vMinInt    = _mm_set1_epi32( MinInt() );
+
+    // Lanes beyond hi are MinInt already
+    for( ; x <= hi; x += Lanes ) {
+      __m128i h    = _mm_loadu_si128( ( const __m128i* )( H + x + 1 ) );
+      __m128i drop = _mm_cmpgt_epi32( vThreshold, h );
+      if( _mm_movemask_epi8( drop ) == 0 )
+        continue;
+
+      __m128i e = _mm_loadu_si128( ( const __m128i* )( E + x + 1 ) );
+      __m128i f = _mm_loadu_si128( ( const __m128i* )( F + x + 1 ) );
+      _mm_storeu_si128( ( __m128i* )( H + x + 1 ), Select( drop, vMinInt, h ) );
+      _mm_storeu_si128( ( __m128i* )( E + x + 1 ), Select( drop, vMinInt, e ) );
+      _mm_storeu_si128( ( __m128i* )( F + x + 1 ), Select( drop, vMinInt, f ) );
+    }
+#else
+    for( ; x <= hi; x++ ) {
+      if( H[ x + 1 ] < threshold ) {
+        H[ x + 1 ] = E[ x + 1 ] = F[ x + 1 ] = MinInt();
+      }
+    }
+#endif
+  }
+
+public:
+  ExtendAlignSIMD( const ExtendAlignParams& ap = ExtendAlignParams() )
+      : mAP( ap ) {}
+
+  const ExtendAlignParams& AP() const {
+    return mAP;
+  }
+
+  int Extend( const Sequence< Alphabet >& A, const Sequence< Alphabet >& B,
+              size_t* bestA = NULL, size_t* bestB = NULL, Cigar* cigar = NULL,
+              const AlignmentDirection dir = AlignmentDirection::Forward,
+              size_t startA = 0, size_t startB = 0 ) {
+    const bool forward = ( dir == AlignmentDirection::Forward );
+
+    size_t width, height;
+    if( forward ) {
+      width  = A.Length() - startA + 1;
+      height = B.Length() - startB + 1;
+    } else {
+      width  = startA + 1;
+      height = startB + 1;
+    }
+
+    EnsureCapacity( width );
+    if( mOperationsDiagonals.size() < width + height ) {
+      mOperationsDiagonals.resize( ( width + height ) * 1.5 );
+    }
+    size_t numOperations = 0;
+
+    // Sequence characters for x, y >= 1: mA[ x ], mB[ height - 1 - y ]
+    // (padded, since letters are compared Lanes at a time)
+    bool seen[ 256 ] = { false };
+    mA.assign( width + Lanes, '\0' );
+    mB.assign( height + Lanes, '\0' );
+    for( size_t x = 1; x < width; x++ ) {
+      char ch = A[ forward ? startA + x - 1 : startA - x ];
+      mA[ x ] = ch;
+      seen[ ( unsigned char )ch ] = true;
+    }
+    for( size_t y = 1; y < height; y++ ) {
+      char ch = B[ forward ? startB + y - 1 : startB - y ];
+      mB[ height - 1 - y ] = ch;
+      seen[ ( unsigned char )ch ] = true;
+    }
+    DetermineUniformScores( seen );
+
+    const char* seqA = mA.data();
+    const char* seqB = mB.data();
+
+    // Anti-diagonal 0: just the origin
+    int32_t* H0 = mH[ 0 ].data();
+    int32_t* H1 = mH[ 1 ].data();
+    int32_t* H  = mH[ 2 ].data();
+    int32_t* E1 = mE[ 0 ].data();
+    int32_t* E  = mE[ 1 ].data();
+    int32_t* F1 = mF[ 0 ].data();
+    int32_t* F  = mF[ 1 ].data();
+
+    for( size_t i = 0; i < 3; i++ ) {
+      mH[ i ][ 0 ] = mH[ i ][ 1 ] = mH[ i ][ 2 ] = MinInt();
+    }
+    for( size_t i = 0; i < 2; i++ ) {
+      mE[ i ][ 0 ] = mE[ i ][ 1 ] = mE[ i ][ 2 ] = MinInt();
+      mF[ i ][ 0 ] = mF[ i ][ 1 ] = mF[ i ][ 2 ] = MinInt();
+    }
+    H1[ 1 ] = 0;
+
+    mOperationsDiagonals[ 0 ] = { 0, 0 };
+    numOperations             = 1;
+
+    int32_t bestScore = 0;
+    size_t  bestX = 0, bestY = 0;
+
+    // Cells which passed the X-Drop test on the previous two anti-diagonals
+    size_t lo1 = 0, hi1 = 0, lo2 = 0, hi2 = 0;
+    bool   any1 = true, any2 = false;
+
+    for( size_t d = 1; d < width + height - 1; d++ ) {
+      if( !any1 && !any2 ) {
+        // All cells failed the X-Drop test
+        break;
+      }
+
+      // Candidate cells: reachable from the previous anti-diagonal (gaps)
+      // or the one before (diagonal), within the matrix
+      size_t newLo = any1 ? lo1 : lo2 + 1;
+      size_t newHi = any1 ? hi1 + 1 : hi2 + 1;
+      if( any1 && any2 ) {
+        newLo = std::min( newLo, lo2 + 1 );
+        newHi = std::max( newHi, hi2 + 1 );
+      }
+      if( d >= height && newLo < d - height + 1 )
+        newLo = d - height + 1;
+      newHi = std::min( newHi, width - 1 );
+      if( newLo > newHi )
+        break;
+
+      // Sentinels around the candidate cells (cells of the previous
+      // anti-diagonals next to the ones which passed the X-Drop test were
+      // cleared by it or are sentinels themselves)
+      H[ newLo ] = E[ newLo ] = F[ newLo ] = MinInt();
+      H[ newHi + 2 ] = E[ newHi + 2 ] = F[ newHi + 2 ] = MinInt();
+
+      // Substitution scores (B is traversed backwards along the
+      // anti-diagonal). Cells in the first row/column have no diagonal
+      // predecessor, their scores are irrelevant.
+      const ptrdiff_t offB = ptrdiff_t( height - 1 ) - ptrdiff_t( d );
+      if( !mUniformScores ) {
+        int32_t* S      = mSubstitutionScores.data() + 1;
+        size_t   firstX = std::max< size_t >( newLo, 1 );
+        size_t   lastX  = std::min< size_t >( newHi, d - 1 );
+        for( size_t x = firstX; x <= lastX; x++ ) {
+          ptrdiff_t px = ptrdiff_t( x );
+          S[ x ]       = ScorePolicy< Alphabet >::Score(
+            seqA[ px ], seqB[ px + offB ] );
+        }
+      }
+
+      // Compute
+      size_t offset = numOperations;
+      numOperations += newHi - newLo + 1;
+      if( mOperations.size() < numOperations + Lanes ) {
+        mOperations.resize( ( numOperations + Lanes ) * 2 );
+      }
+      mOperationsDiagonals[ d ] = { offset, newLo };
+
+      int32_t diagonalBest;
+      ComputeDiagonal( newLo, newHi, offB, H0, H1, E1, F1, H, E, F,
+                       mOperations.data() + offset, bestScore - mAP.xDrop,
+                       &diagonalBest );
+
+      // New highscore? Pick the first cell in row-major order (like
+      // ExtendAlign) if there are multiple candidates
+      int32_t prevBestScore = bestScore;
+      if( diagonalBest >= bestScore ) {
+        for( size_t x = newHi + 1; x-- > newLo; ) {
+          if( H[ x + 1 ] != diagonalBest )
+            continue;
+
+          size_t y = d - x;
+          if( diagonalBest > bestScore || y < bestY ) {
+            bestScore = diagonalBest;
+            bestX     = x;
+            bestY     = y;
+          }
+          break;
+        }
+      }
+
+      // X-Drop (against the new highscore, the old one was tested already)
+      if( bestScore > prevBestScore ) {
+        Prune( newLo, newHi, bestScore - mAP.xDrop, H, E, F );
+      }
+      while( newLo <= newHi && H[ newLo + 1 ] <= MinInt() )
+        newLo++;
+
+      lo2  = lo1;
+      hi2  = hi1;
+      any2 = any1;
+      any1 = ( newLo <= newHi );
+      if( any1 ) {
+        while( H[ newHi + 1 ] <= MinInt() )
+          newHi--;
+        lo1 = newLo;
+        hi1 = newHi;
+      }
+
+      // Rotate anti-diagonals
+      int32_t* tmp = H0;
+      H0           = H1;
+      H1           = H;
+      H            = tmp;
+      std::swap( E, E1 );
+      std::swap( F, F1 );
+    }
+
+    if( bestA ) {
+      *bestA = ( bestX > 0 && bestY > 0 )
+                 ? ( forward ? startA + bestX - 1 : startA - bestX )
+                 : startA;
+    }
+    if( bestB ) {
+      *bestB = ( bestX > 0 && bestY > 0 )
+                 ? ( forward ? startB + bestY - 1 : startB - bestY )
+                 : startB;
+    }
+
+    if( cigar ) {
+      size_t bx = bestX;
+      size_t by = bestY;
+
+      // Collect runs, add each of them at once
+      CigarEntry ce;
+      cigar->Clear();
+      while( bx != 0 || by != 0 ) {
+        const OperationsDiagonal& diagonal = mOperationsDiagonals[ bx + by ];
+        assert( bx >= diagonal.firstX );
+
+        CigarOp op;
+        switch( mOperations[ diagonal.offset + bx - diagonal.firstX ] ) {
+          case Horizontal:
+            op = CigarOp::Insertion;
+            bx--;
+            break;
+          case Vertical:
+            op = CigarOp::Deletion;
+            by--;
+            break;
+          default:
+            op = MatchPolicy< Alphabet >::Match( seqA[ bx ],
+                                                 seqB[ height - 1 - by ] )
+                   ? CigarOp::Match
+                   : CigarOp::Mismatch;
+            bx--;
+            by--;
+            break;
+        }
+
+        if( op != ce.op ) {
+          cigar->Add( ce );
+          ce = CigarEntry( 0, op );
+        }
+        ce.count++;
+      }
+      cigar->Add( ce );
+
+      if( forward ) {
+        cigar->Reverse();
+      }
+    }
+
+    return bestScore;
+  }
+};
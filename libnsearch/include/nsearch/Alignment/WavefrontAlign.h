@@ -0,0 +1,390 @@
+#pragma once
+
+#include "Cigar.h"
+#include "Common.h"
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+typedef struct WavefrontAlignParams {
+  int matchScore    = 2;
+  int mismatchScore = -4;
+
+  int interiorGapOpenScore   = -20;
+  int interiorGapExtendScore = -2;
+
+  int terminalGapOpenScore   = -2;
+  int terminalGapExtendScore = -1;
+
+  // Give up once the alignment scores this much lower than a perfect match
+  // of both sequences would. The caller is expected to fall back to banded
+  // alignment then.
+  int maxScoreLoss = 256;
+} WavefrontAlignParams;
+
+// Gap-affine wavefront alignment (Marco-Sola et al., 2021) of two whole
+// sequences. Work and memory grow with the alignment score rather than the
+// sequence lengths, which makes it ideal for highly similar sequences.
+//
+// Scores are converted into penalties (score lost compared to a perfect
+// match), which requires uniform match/mismatch scores. Terminal gaps are
+// penalized with the (cheaper) terminal gap scores, just like BandedAlign
+// does when aligning whole sequences. The result is only guaranteed to be
+// optimal if terminal gaps are not more expensive than interior gaps.
+template < typename Alphabet >
+class WavefrontAlign {
+private:
+  static int NoOffset() {
+    return MinInt();
+  }
+
+  class Wavefront {
+  public:
+    int                lo = 0, hi = -1; // diagonal range, empty if lo > hi
+    std::vector< int > offsets;
+
+    void Reset( const int newLo, const int newHi ) {
+      lo = newLo;
+      hi = newHi;
+      if( hi >= lo ) {
+        offsets.assign( hi - lo + 1, NoOffset() );
+      }
+    }
+
+    bool Empty() const {
+      return lo > hi;
+    }
+
+    int Get( const int k ) const {
+      return ( k < lo || k > hi ) ? NoOffset() : offsets[ k - lo ];
+    }
+
+    int& operator[]( const int k ) {
+      assert( k >= lo && k <= hi );
+      return offsets[ k - lo ];
+    }
+  };
+
+  // Wavefronts ending in a (mis)match, an insertion and a deletion
+  struct Wavefronts {
+    Wavefront M, I, D;
+  };
+
+  enum class Component { M, I, D };
+
+  // Penalties are doubled so odd match scores convert without rounding
+  int mMismatch, mGapOpen, mGapExtend, mTerminalGapOpen, mTerminalGapExtend;
+
+  WavefrontAlignParams      mParams;
+  std::vector< Wavefronts > mWavefronts;
+
+  const Wavefront* WavefrontAt( const int s, const Component c ) const {
+    if( s < 0 )
+      return NULL;
+
+    const Wavefronts& wfs = mWavefronts[ s ];
+    switch( c ) {
+      case Component::M:
+        return &wfs.M;
+      case Component::I:
+        return &wfs.I;
+      default:
+        return &wfs.D;
+    }
+  }
+
+  int OffsetAt( const int s, const Component c, const int k ) const {
+    const Wavefront* wf = WavefrontAt( s, c );
+    return wf ? wf->Get( k ) : NoOffset();
+  }
+
+  // Leading terminal gap (or the origin for s = 0) reaching diagonal k at
+  // penalty s
+  int SeedOffset( const int s, const int k, const int lenA,
+                  const int lenB ) const {
+    if( k == 0 )
+      return s == 0 ? 0 : NoOffset();
+
+    int len = std::abs( k );
+    if( s != mTerminalGapOpen + len * mTerminalGapExtend )
+      return NoOffset();
+
+    if( k > 0 )
+      return k <= lenA ? k : NoOffset();
+
+    return len <= lenB ? 0 : NoOffset();
+  }
+
+  int MismatchOffset( const int s, const int k, const int lenA,
+                      const int lenB ) const {
+    int h = OffsetAt( s - mMismatch, Component::M, k );
+    if( h == NoOffset() || h + 1 > lenA || h + 1 - k > lenB )
+      return NoOffset();
+    return h + 1;
+  }
+
+  // Interior gaps only; gaps along the first or last row/column are terminal
+  // and handled by SeedOffset and CompletionPenalty
+  int InsertionOffset( const int s, const int k, const int lenA,
+                       const int lenB ) const {
+    int h = std::max( OffsetAt( s - mGapOpen - mGapExtend, Component::M, k - 1 ),
+                      OffsetAt( s - mGapExtend, Component::I, k - 1 ) );
+    if( h == NoOffset() || h + 1 > lenA )
+      return NoOffset();
+
+    int v = h + 1 - k;
+    if( v <= 0 || v >= lenB )
+      return NoOffset();
+    return h + 1;
+  }
+
+  int DeletionOffset( const int s, const int k, const int lenA,
+                      const int lenB ) const {
+    int h = std::max( OffsetAt( s - mGapOpen - mGapExtend, Component::M, k + 1 ),
+                      OffsetAt( s - mGapExtend, Component::D, k + 1 ) );
+    if( h == NoOffset() || h - k > lenB )
+      return NoOffset();
+
+    if( h <= 0 || h >= lenA )
+      return NoOffset();
+    return h;
+  }
+
+  bool Range( const Wavefront* wf, const int shift, int* lo, int* hi ) const {
+    if( !wf || wf->Empty() )
+      return false;
+
+    *lo = std::min( *lo, wf->lo + shift );
+    *hi = std::max( *hi, wf->hi + shift );
+    return true;
+  }
+
+  void Compute( const int s, const int lenA, const int lenB ) {
+    Wavefronts& wfs = mWavefronts[ s ];
+
+    const Wavefront* open     = s >= mGapOpen + mGapExtend
+                                  ? WavefrontAt( s - mGapOpen - mGapExtend,
+                                                 Component::M )
+                                  : NULL;
+    const Wavefront* mismatch = s >= mMismatch
+                                  ? WavefrontAt( s - mMismatch, Component::M )
+                                  : NULL;
+    const Wavefront* extendI =
+      s >= mGapExtend ? WavefrontAt( s - mGapExtend, Component::I ) : NULL;
+    const Wavefront* extendD =
+      s >= mGapExtend ? WavefrontAt( s - mGapExtend, Component::D ) : NULL;
+
+    // Insertions (consume A, move to the next diagonal)
+    int lo = lenA + 1, hi = -lenB - 1;
+    bool any = Range( open, 1, &lo, &hi );
+    any      = Range( extendI, 1, &lo, &hi ) || any;
+    wfs.I.Reset( any ? lo : 0, any ? std::min( hi, lenA ) : -1 );
+    for( int k = wfs.I.lo; k <= wfs.I.hi; k++ ) {
+      wfs.I[ k ] = InsertionOffset( s, k, lenA, lenB );
+    }
+
+    // Deletions (consume B, move to the previous diagonal)
+    lo  = lenA + 1;
+    hi  = -lenB - 1;
+    any = Range( open, -1, &lo, &hi );
+    any = Range( extendD, -1, &lo, &hi ) || any;
+    wfs.D.Reset( any ? std::max( lo, -lenB ) : 0, any ? hi : -1 );
+    for( int k = wfs.D.lo; k <= wfs.D.hi; k++ ) {
+      wfs.D[ k ] = DeletionOffset( s, k, lenA, lenB );
+    }
+
+    // (Mis)matches, closing gaps and leading terminal gaps
+    lo  = lenA + 1;
+    hi  = -lenB - 1;
+    any = Range( mismatch, 0, &lo, &hi );
+    any = Range( &wfs.I, 0, &lo, &hi ) || any;
+    any = Range( &wfs.D, 0, &lo, &hi ) || any;
+
+    if( s == 0 ) {
+      lo  = std::min( lo, 0 );
+      hi  = std::max( hi, 0 );
+      any = true;
+    } else if( s > mTerminalGapOpen &&
+               ( s - mTerminalGapOpen ) % mTerminalGapExtend == 0 ) {
+      int len = ( s - mTerminalGapOpen ) / mTerminalGapExtend;
+      if( len <= lenA ) {
+        lo  = std::min( lo, len );
+        hi  = std::max( hi, len );
+        any = true;
+      }
+      if( len <= lenB ) {
+        lo  = std::min( lo, -len );
+        hi  = std::max( hi, -len );
+        any = true;
+      }
+    }
+
+    wfs.M.Reset( any ? lo : 0, any ? hi : -1 );
+    for( int k = wfs.M.lo; k <= wfs.M.hi; k++ ) {
+      wfs.M[ k ] = std::max( { MismatchOffset( s, k, lenA, lenB ),
+                               wfs.I.Get( k ), wfs.D.Get( k ),
+                               SeedOffset( s, k, lenA, lenB ) } );
+    }
+  }
+
+  void Extend( const int s, const Sequence< Alphabet >& A,
+               const Sequence< Alphabet >& B ) {
+    Wavefront& M    = mWavefronts[ s ].M;
+    int        lenA = A.Length(), lenB = B.Length();
+
+    for( int k = M.lo; k <= M.hi; k++ ) {
+      int h = M[ k ];
+      if( h == NoOffset() )
+        continue;
+
+      int v = h - k;
+      while( h < lenA && v < lenB &&
+             MatchPolicy< Alphabet >::Match( A[ h ], B[ v ] ) ) {
+        h++;
+        v++;
+      }
+      M[ k ] = h;
+    }
+  }
+
+  // Penalty of the whole alignment if it ends in this cell (the rest is
+  // a trailing terminal gap)
+  int CompletionPenalty( const int s, const int h, const int v, const int lenA,
+                         const int lenB ) const {
+    if( h == lenA && v == lenB )
+      return s;
+    if( h == lenA )
+      return s + mTerminalGapOpen + ( lenB - v ) * mTerminalGapExtend;
+    if( v == lenB )
+      return s + mTerminalGapOpen + ( lenA - h ) * mTerminalGapExtend;
+    return -1;
+  }
+
+  void Backtrack( int s, int k, const int lenA, const int lenB,
+                  Cigar* cigar ) const {
+    cigar->Clear();
+
+    // Trailing terminal gap
+    int h = mWavefronts[ s ].M.Get( k );
+    int v = h - k;
+    cigar->Add( CigarEntry( lenA - h, CigarOp::Insertion ) );
+    cigar->Add( CigarEntry( lenB - v, CigarOp::Deletion ) );
+
+    Component c = Component::M;
+    while( true ) {
+      if( c == Component::M ) {
+        h = OffsetAt( s, Component::M, k );
+
+        int fromMismatch = MismatchOffset( s, k, lenA, lenB );
+        int fromI        = OffsetAt( s, Component::I, k );
+        int fromD        = OffsetAt( s, Component::D, k );
+        int fromSeed     = SeedOffset( s, k, lenA, lenB );
+        int from =
+          std::max( { fromMismatch, fromI, fromD, fromSeed } );
+
+        cigar->Add( CigarEntry( h - from, CigarOp::Match ) );
+
+        if( from == fromI ) {
+          c = Component::I;
+        } else if( from == fromD ) {
+          c = Component::D;
+        } else if( from == fromMismatch ) {
+          cigar->Add( CigarOp::Mismatch );
+          s -= mMismatch;
+        } else {
+          // Leading terminal gap (or origin)
+          cigar->Add( CigarEntry( std::abs( k ), k > 0 ? CigarOp::Insertion
+                                                       : CigarOp::Deletion ) );
+          break;
+        }
+      } else {
+        bool isInsertion = ( c == Component::I );
+        int  prevK       = isInsertion ? k - 1 : k + 1;
+
+        h         = OffsetAt( s, c, k );
+        int fromM = OffsetAt( s - mGapOpen - mGapExtend, Component::M, prevK );
+        cigar->Add( isInsertion ? CigarOp::Insertion : CigarOp::Deletion );
+
+        if( fromM != NoOffset() && fromM + ( isInsertion ? 1 : 0 ) == h ) {
+          c = Component::M;
+          s -= mGapOpen + mGapExtend;
+        } else {
+          s -= mGapExtend;
+        }
+        k = prevK;
+      }
+    }
+
+    cigar->Reverse();
+  }
+
+public:
+  WavefrontAlign( const WavefrontAlignParams& params = WavefrontAlignParams() )
+      : mParams( params ) {
+    mMismatch          = 2 * ( params.matchScore - params.mismatchScore );
+    mGapOpen           = -2 * params.interiorGapOpenScore;
+    mGapExtend         = params.matchScore - 2 * params.interiorGapExtendScore;
+    mTerminalGapOpen   = -2 * params.terminalGapOpenScore;
+    mTerminalGapExtend = params.matchScore - 2 * params.terminalGapExtendScore;
+
+    assert( mMismatch > 0 && mGapOpen >= 0 && mGapExtend > 0 &&
+            mTerminalGapOpen >= 0 && mTerminalGapExtend > 0 );
+  }
+
+  const WavefrontAlignParams& AP() const {
+    return mParams;
+  }
+
+  // Returns false if the alignment would score lower than allowed by
+  // maxScoreLoss (-1: use the value from the params)
+  bool Align( const Sequence< Alphabet >& A, const Sequence< Alphabet >& B,
+              Cigar* cigar = NULL, int* score = NULL, int maxScoreLoss = -1 ) {
+    const int lenA = A.Length();
+    const int lenB = B.Length();
+
+    if( maxScoreLoss < 0 )
+      maxScoreLoss = mParams.maxScoreLoss;
+    const int maxPenalty = 2 * maxScoreLoss;
+
+    if( mWavefronts.size() < size_t( maxPenalty + 1 ) ) {
+      mWavefronts.resize( maxPenalty + 1 );
+    }
+
+    int bestPenalty = maxPenalty + 1;
+    int bestS = 0, bestK = 0;
+
+    for( int s = 0; s <= maxPenalty && s < bestPenalty; s++ ) {
+      Compute( s, lenA, lenB );
+      Extend( s, A, B );
+
+      // Check if we (or a trailing terminal gap) reached the end
+      const Wavefront& M = mWavefronts[ s ].M;
+      for( int k = M.lo; k <= M.hi; k++ ) {
+        int h = M.Get( k );
+        if( h == NoOffset() )
+          continue;
+
+        int penalty = CompletionPenalty( s, h, h - k, lenA, lenB );
+        if( penalty >= 0 && penalty < bestPenalty ) {
+          bestPenalty = penalty;
+          bestS       = s;
+          bestK       = k;
+        }
+      }
+    }
+
+    if( bestPenalty > maxPenalty )
+      return false;
+
+    if( score ) {
+      *score = ( mParams.matchScore * ( lenA + lenB ) - bestPenalty ) / 2;
+    }
+
+    if( cigar ) {
+      Backtrack( bestS, bestK, lenA, lenB, cigar );
+    }
+
+    return true;
+  }
+};
@@ -5,6 +5,7 @@
 #include "../Alphabet/DNA.h"
 #include "../Alphabet/Protein.h"
 
+#include <deque>
 #include <fstream>
 
 namespace Alnout {
@@ -24,15 +25,15 @@ public:
     // Output with fixed precision (sticky)
     out << std::setiosflags( std::ios::fixed );
 
-    out << "Query >" << query.identifier << std::endl;
-    out << " %Id   TLen  Target" << std::endl;
+    out << "Query >" << query.identifier << '\n';
+    out << " %Id   TLen  Target" << '\n';
     for( auto& hit : hits ) {
       out << std::setprecision( 0 ) << std::setw( 3 )
               << ( hit.alignment.Identity() * 100.0 ) << '%' << std::setw( 7 )
               << hit.target.Length() << "  " << hit.target.identifier
-              << std::endl;
+              << '\n';
     }
-    out << std::endl;
+    out << '\n';
 
     for( const auto& hit : hits ) {
       auto queryLen  = std::to_string( query.Length() );
@@ -41,46 +42,47 @@ public:
 
       out << " Query" << std::setw( maxLen + 1 )
               << std::to_string( query.Length() ) << Unit() << " >"
-              << query.identifier << std::endl;
+              << query.identifier << '\n';
       out << "Target" << std::setw( maxLen + 1 )
               << std::to_string( hit.target.Length() ) << Unit() << " >"
-              << hit.target.identifier << std::endl;
+              << hit.target.identifier << '\n';
 
       size_t numCols, numMatches, numGaps;
       auto   lines = ExtractAlignmentLines(
         QueryForAlignment( hit, query ), TargetForAlignment( hit, query ), hit.alignment,
         &numCols, &numMatches, &numGaps );
 
-      out << std::endl;
-      for( auto& line : lines ) {
-        auto padLen = std::max( { std::to_string( lines.back().qs ).size(),
-                                  std::to_string( lines.back().ts ).size(),
-                                  std::to_string( lines.back().qe ).size(),
-                                  std::to_string( lines.back().te ).size() } );
+      out << '\n';
+
+      auto padLen = std::max( { std::to_string( lines.back().qs ).size(),
+                                std::to_string( lines.back().ts ).size(),
+                                std::to_string( lines.back().qe ).size(),
+                                std::to_string( lines.back().te ).size() } );
 
-        auto qstrand = QueryStrand( hit );
-        auto tstrand = TargetStrand( hit );
+      auto qstrand = QueryStrand( hit );
+      auto tstrand = TargetStrand( hit );
 
-        if( !qstrand.empty() )
-          qstrand += " ";
+      if( !qstrand.empty() )
+        qstrand += " ";
 
-        if( !tstrand.empty() )
-          tstrand += " ";
+      if( !tstrand.empty() )
+        tstrand += " ";
 
+      for( auto& line : lines ) {
         out << "Qry " << std::setw( padLen )
                 << QueryPos( line.qs, query, hit )
                 << " " << qstrand << line.q << " "
-                << QueryPos( line.qe, query, hit ) << std::endl;
+                << QueryPos( line.qe, query, hit ) << '\n';
 
         out << std::string( 5 + padLen + qstrand.size(), ' ' ) << line.a
-                << std::endl;
+                << '\n';
 
         out << "Tgt " << std::setw( padLen )
                 << TargetPos( line.ts, query, hit )
                 << " " << tstrand << line.t << " "
-                << TargetPos( line.te, query, hit ) << std::endl;
+                << TargetPos( line.te, query, hit ) << '\n';
 
-        out << std::endl;
+        out << '\n';
       }
 
       float identity  = float( numMatches ) / float( numCols );
@@ -88,9 +90,9 @@ public:
       out << numCols << " cols, " << numMatches << " ids ("
               << std::setprecision( 1 ) << ( 100.0f * identity ) << "%), "
               << numGaps << " gaps (" << std::setprecision( 1 )
-              << ( 100.0f * gapsRatio ) << "%)" << std::endl;
+              << ( 100.0f * gapsRatio ) << "%)" << '\n';
 
-      out << std::endl;
+      out << '\n';
     }
     return *this;
   }
@@ -143,6 +145,12 @@ private:
   };
   using AlignmentLines = std::deque< AlignmentLine >;
 
+  static void Reserve( AlignmentLine* line ) {
+    line->q.reserve( MaxLineLength );
+    line->t.reserve( MaxLineLength );
+    line->a.reserve( MaxLineLength );
+  }
+
   static AlignmentLines ExtractAlignmentLines(
     const Sequence< Alphabet >& query, const Sequence< Alphabet >& target,
     const Cigar& alignment, size_t* outNumCols = NULL,
@@ -185,10 +193,11 @@ private:
     AlignmentLine line;
     line.qs = queryStart + 1;
     line.ts = targetStart + 1;
+    Reserve( &line );
 
     AlignmentLines lines;
 
-    for( auto& c : cigar ) {
+    for( const CigarEntry& c : cigar ) {
       for( int i = 0; i < c.count; i++ ) {
         switch( c.op ) {
           case CigarOp::Insertion:
@@ -230,6 +239,7 @@ private:
           line    = AlignmentLine();
           line.qs = qcount + 1;
           line.ts = tcount + 1;
+          Reserve( &line );
         }
       }
     }
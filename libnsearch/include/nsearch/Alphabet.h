@@ -1,8 +1,15 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+
 template < typename Alphabet >
 struct BitMapPolicy {
   static const size_t NumBits = 0;
+
+  // Unambiguous letters map to the same bits if and only if they match
+  static const bool PreservesMatches = false;
+
   inline static int8_t BitMap( const char ch ) {
     return -1;
   }
@@ -12,7 +12,8 @@ using RNA = DNA;
 
 template <>
 struct BitMapPolicy< DNA > {
-  static const size_t NumBits = 2;
+  static const size_t NumBits          = 2;
+  static const bool   PreservesMatches = true;
 
   inline static int8_t BitMap( const char base ) {
     switch( base ) {
@@ -10,7 +10,8 @@ struct Protein {
 // Collapse AAs into 4 bits
 template <>
 struct BitMapPolicy< Protein > {
-  static const size_t NumBits = 4;
+  static const size_t NumBits          = 4;
+  static const bool   PreservesMatches = false;
 
   inline static int8_t BitMap( const char aa ) {
     static const uint8_t BitMapping[] = {
@@ -0,0 +1,177 @@
+#pragma once
+
+#include "../SAM/Writer.h"
+
+#include "../Alphabet/DNA.h"
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+
+namespace BAM {
+
+/*
+ * Binary SAM. Opened by path, the file is BGZF compressed on all cores.
+ * Hits on targets missing from the header (see WriteHeader) are stored
+ * without reference. Only nucleotides can be stored, protein queries are
+ * written without sequence.
+ */
+template < typename Alphabet >
+class Writer : public HitWriter< Alphabet > {
+public:
+  // Uncompressed, as in the BGZF blocks
+  Writer( std::ostream& output ) : HitWriter< Alphabet >( output ) {}
+
+#ifdef USE_ZLIB
+  Writer( const std::string& pathToFile )
+      : HitWriter< Alphabet >( std::unique_ptr< std::ostream >(
+          new BGZFOutputStream( pathToFile ) ) ) {}
+#endif
+
+  void WriteHeader( const SequenceList< Alphabet >& targets ) {
+    std::string text = SAM::Header( targets );
+
+    mRecord.assign( "BAM\1" );
+    PutInt32( text.size() );
+    mRecord += text;
+
+    PutInt32( targets.size() );
+    for( auto& target : targets ) {
+      std::string name = SAM::Name( target.identifier );
+      mReferenceIds.emplace( name, mReferenceIds.size() );
+
+      PutInt32( name.size() + 1 );
+      mRecord.append( name.c_str(), name.size() + 1 );
+      PutInt32( target.Length() );
+    }
+
+    this->mOutput.write( mRecord.data(), mRecord.size() );
+    mWroteHeader = true;
+  }
+
+  HitWriter< Alphabet >&
+  operator<<( const QueryHitsPair< Alphabet >& queryWithHits ) {
+    const auto& query = queryWithHits.first;
+    const auto& hits  = queryWithHits.second;
+
+    if( !mWroteHeader ) {
+      WriteHeader( {} );
+    }
+
+    auto queryName = SAM::Name( query.identifier ).substr( 0, 254 );
+    for( size_t i = 0; i < hits.size(); i++ ) {
+      const auto&             hit = hits[ i ];
+      SAM::Record< Alphabet > record( query, hit, i > 0 );
+
+      auto   it      = mReferenceIds.find( SAM::Name( hit.target.identifier ) );
+      bool   mapped  = it != mReferenceIds.end();
+      size_t seqSize = HasNucleotides() ? record.query.Length() : 0;
+      size_t numCigarOps =
+        record.cigar.size() + ( record.clipStart > 0 ) + ( record.clipEnd > 0 );
+
+      mRecord.clear();
+      PutInt32( 0 ); // block_size, set below
+      PutInt32( mapped ? it->second : -1 );
+      PutInt32( mapped ? int32_t( record.pos ) : -1 );
+      mRecord += char( queryName.size() + 1 );
+      mRecord += char( 255 ); // mapq
+      PutUint16( mapped ? RegionToBin( record.pos,
+                                       record.pos + record.TargetLength() )
+                        : 4680 );
+      PutUint16( numCigarOps );
+      PutUint16( record.flag );
+      PutInt32( seqSize );
+      PutInt32( -1 ); // next_refID
+      PutInt32( -1 ); // next_pos
+      PutInt32( 0 );  // tlen
+      mRecord.append( queryName.c_str(), queryName.size() + 1 );
+
+      // Cigar is packed like in BAM already
+      if( record.clipStart > 0 )
+        PutUint32( ( record.clipStart << 4 ) | SoftClip );
+      for( size_t j = 0; j < record.cigar.size(); j++ ) {
+        PutUint32( record.cigar.data()[ j ] );
+      }
+      if( record.clipEnd > 0 )
+        PutUint32( ( record.clipEnd << 4 ) | SoftClip );
+
+      // Two bases per byte
+      const auto& seq = record.query.sequence;
+      for( size_t j = 0; j < seqSize; j += 2 ) {
+        uint8_t hi = BaseCode( seq[ j ] );
+        uint8_t lo = j + 1 < seqSize ? BaseCode( seq[ j + 1 ] ) : 0;
+        mRecord += char( ( hi << 4 ) | lo );
+      }
+
+      // Phred scores, 0xFF if missing
+      const auto& qual = record.query.quality;
+      for( size_t j = 0; j < seqSize; j++ ) {
+        mRecord += j < qual.size() ? char( qual[ j ] - 33 ) : char( 0xFF );
+      }
+
+      mRecord += "NMi";
+      PutInt32( record.NumDifferences() );
+
+      int32_t blockSize = mRecord.size() - 4;
+      for( int k = 0; k < 4; k++ ) {
+        mRecord[ k ] = char( ( blockSize >> ( 8 * k ) ) & 0xFF );
+      }
+
+      this->mOutput.write( mRecord.data(), mRecord.size() );
+    }
+
+    return *this;
+  }
+
+private:
+  static const uint32_t SoftClip = 4;
+
+  static bool HasNucleotides() {
+    return std::is_same< Alphabet, DNA >::value;
+  }
+
+  static uint8_t BaseCode( const char base ) {
+    static const std::string codes = "=ACMGRSVTWYHKDBN";
+
+    auto code = codes.find( base );
+    return code != std::string::npos ? code : 15;
+  }
+
+  // UCSC binning scheme of the region [beg, end)
+  static uint16_t RegionToBin( const int beg, int end ) {
+    --end;
+    if( beg >> 14 == end >> 14 )
+      return ( ( 1 << 15 ) - 1 ) / 7 + ( beg >> 14 );
+    if( beg >> 17 == end >> 17 )
+      return ( ( 1 << 12 ) - 1 ) / 7 + ( beg >> 17 );
+    if( beg >> 20 == end >> 20 )
+      return ( ( 1 << 9 ) - 1 ) / 7 + ( beg >> 20 );
+    if( beg >> 23 == end >> 23 )
+      return ( ( 1 << 6 ) - 1 ) / 7 + ( beg >> 23 );
+    if( beg >> 26 == end >> 26 )
+      return ( ( 1 << 3 ) - 1 ) / 7 + ( beg >> 26 );
+    return 0;
+  }
+
+  // Little endian
+  void PutUint16( const uint16_t value ) {
+    mRecord += char( value & 0xFF );
+    mRecord += char( value >> 8 );
+  }
+
+  void PutUint32( const uint32_t value ) {
+    PutUint16( value & 0xFFFF );
+    PutUint16( value >> 16 );
+  }
+
+  void PutInt32( const int32_t value ) {
+    PutUint32( uint32_t( value ) );
+  }
+
+  bool                                       mWroteHeader = false;
+  std::string                                mRecord;
+  std::unordered_map< std::string, int32_t > mReferenceIds;
+};
+
+} // namespace BAM
@@ -0,0 +1,132 @@
+#pragma once
+
+#ifdef USE_ZLIB
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * BGZF (bgzip) files consist of independently compressed gzip members of
+ * at most 64 KB each, announced by a "BC" field in the gzip header.
+ * Blocks are inflated on several threads and handed out in order.
+ * Reading stops at the first gzip member without "BC" field (e.g. plain
+ * gzip appended to BGZF), the rest of the file is left to zlib.
+ */
+class BGZFDecompressor {
+public:
+  // Checks the header at the current position of fd (which is restored)
+  static bool IsBGZF( const int fd );
+
+  BGZFDecompressor( const int fd, const size_t numThreads );
+  ~BGZFDecompressor();
+
+  // Next non-empty block, valid until the next call. 0 at the end of the
+  // BGZF blocks, see Corrupt and PlainGzipOffset
+  size_t NextBlock( char** data );
+
+  // Whether reading stopped at a truncated or corrupt block
+  bool Corrupt() const;
+
+  // Offset of the gzip member without "BC" field reading stopped at, -1 if
+  // there is none
+  int64_t PlainGzipOffset() const;
+
+private:
+  static const size_t MaxBlockSize = 64 * 1024;
+
+  enum class ReadResult { Block, End, PlainGzip, Corrupt };
+
+  class Block {
+  public:
+    size_t                 seq   = 0;
+    bool                   ready = false;
+    bool                   valid = false;
+    std::vector< uint8_t > compressed;
+    std::vector< char >    data;
+    size_t                 size = 0;
+  };
+
+  // Reads the next compressed block from the file. End only if there are no
+  // bytes left at all
+  ReadResult ReadBlock( Block* block );
+  static bool Inflate( Block* block );
+
+  void WorkerLoop();
+
+  int                  mFd;
+  std::vector< Block > mBlocks; // ring, indexed by seq % size
+
+  mutable std::mutex      mMutex;
+  std::condition_variable mReadyCondition, mFreeCondition;
+  size_t                  mNumRead, mNumHandedOut;
+  bool                    mEnd, mTruncated, mCorrupt, mStop;
+  int64_t                 mPlainGzipOffset;
+
+  std::vector< std::thread > mWorkers;
+};
+
+/*
+ * Writes BGZF, which any gzip reader understands (as multi-member gzip).
+ * The data is cut into blocks which are compressed on several threads and
+ * written in order. Flushing doesn't cut blocks, the last block and the
+ * end-of-file marker are written on destruction.
+ */
+class BGZFOutputStream : public std::ostream {
+public:
+  BGZFOutputStream( const std::string& fileName,
+                    const size_t       numThreads = std::max(
+                      std::thread::hardware_concurrency(), 1u ) );
+
+private:
+  class Compressor : public std::streambuf {
+  public:
+    Compressor( const std::string& fileName, const size_t numThreads );
+    ~Compressor();
+
+  protected:
+    int_type        overflow( int_type ch );
+    std::streamsize xsputn( const char* data, std::streamsize count );
+
+  private:
+    // Uncompressed data per block, so the compressed block stays < 64 KB
+    static const size_t BlockSize = 0xFF00;
+
+    enum class State { Free, Filled, Compressed };
+
+    class Block {
+    public:
+      size_t                 seq   = 0;
+      State                  state = State::Free;
+      std::vector< char >    data;
+      std::vector< uint8_t > compressed;
+    };
+
+    // Hands the filled put area over to the workers
+    void Submit();
+    static void Compress( Block* block );
+
+    void WorkerLoop();
+
+    std::ofstream        mFile;
+    std::vector< char >  mPending; // put area
+    std::vector< Block > mBlocks;  // ring, indexed by seq % size
+
+    std::mutex              mMutex;
+    std::condition_variable mFilledCondition, mFreeCondition;
+    size_t                  mNumSubmitted, mNumTaken, mNumWritten;
+    bool                    mStop;
+
+    std::vector< std::thread > mWorkers;
+  };
+
+  Compressor mCompressor;
+};
+
+#endif
@@ -25,7 +25,7 @@ public:
     // Header
     static bool wroteHeader = false;
     if( !wroteHeader ) {
-      out << "QueryId,TargetId,QueryMatchStart,QueryMatchEnd,TargetMatchStart,TargetMatchEnd,QueryMatchSeq,TargetMatchSeq,NumColumns,NumMatches,NumMismatches,NumGaps,Identity,Alignment" << std::endl;
+      out << "QueryId,TargetId,QueryMatchStart,QueryMatchEnd,TargetMatchStart,TargetMatchEnd,QueryMatchSeq,TargetMatchSeq,NumColumns,NumMatches,NumMismatches,NumGaps,Identity,Alignment" << '\n';
       wroteHeader = true;
     }
 
@@ -78,7 +78,7 @@ public:
       }
 
       size_t numMatches = 0, numMismatches = 0, numColumns = 0, numGaps = 0;
-      for( auto& c : cigar ) {
+      for( const CigarEntry& c : cigar ) {
         for( int i = 0; i < c.count; i++ ) {
           numColumns++;
           switch( c.op ) {
@@ -130,7 +130,7 @@ public:
       // Alignment
       out << cigar.ToString();
 
-      out << std::endl;
+      out << '\n';
     }
 
     return *this;
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "RecordBatch.h"
+#include "RecordParser.h"
+#include "TextReader.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * Parses a file on several threads. Each worker takes the next raw chunk of
+ * the file, finds the first record starting in it and parses all complete
+ * records from there. Batches are handed out in file order; the record cut
+ * by two chunks is put together and parsed when its chunks are handed out.
+ */
+class ChunkParser {
+public:
+  ChunkParser( TextReader* textReader, const RecordParser* parser,
+               const size_t numThreads );
+  ~ChunkParser();
+
+  // Records of the next chunk(s), at least one unless at the end of the file
+  void Read( RecordBatch* batch );
+
+  bool   EndOfFile() const;
+  size_t NumBytesRead() const;
+
+private:
+  class Chunk {
+  public:
+    size_t      seq   = 0;
+    bool        ready = false;
+    bool        last  = false;
+    LineView    data;
+    std::string copy; // of data, unless the reader's chunks outlive reads
+    bool        startsLine   = false;
+    size_t      numBytesRead = 0;
+
+    // Complete records in [recordStart, recordEnd)
+    size_t      recordStart = 0, recordEnd = 0;
+    RecordBatch batch;
+  };
+
+  void WorkerLoop();
+
+  TextReader*          mTextReader;
+  const RecordParser*  mParser;
+  std::vector< Chunk > mChunks; // ring, indexed by seq % size
+
+  std::mutex              mMutex;
+  std::condition_variable mReadyCondition, mFreeCondition;
+  size_t                  mNumRead, mNumHandedOut;
+  bool                    mEnd, mStop;
+
+  // Held by the worker reading (and copying) the next chunk, taken before
+  // mMutex
+  std::mutex mReadMutex;
+  char       mLastByte; // of the chunk read last
+
+  // Only touched by the reading thread
+  std::string mPending; // record cut off by the end of the chunks so far
+  size_t      mNumBytesRead;
+  bool        mDone;
+
+  std::vector< std::thread > mWorkers;
+};
@@ -3,6 +3,7 @@
 #include <deque>
 #include <vector>
 
+#include "PackedSequence.h"
 #include "Sequence.h"
 #include "Utils.h"
 
@@ -31,6 +32,8 @@ public:
   size_t KmerLength() const;
 
   const Sequence< Alphabet >& GetSequenceById( const SequenceId& seqId ) const;
+  bool GetPackedSequenceById( const SequenceId&                seqId,
+                              const PackedSequence< Alphabet >** packed ) const;
 
   bool GetKmersForSequenceId( const SequenceId& seqId, const Kmer** kmers,
                               size_t* numKmers ) const;
@@ -43,6 +46,8 @@ private:
   SequenceList< Alphabet > mSequences;
   size_t                   mMaxUniqueKmers;
 
+  std::vector< PackedSequence< Alphabet > > mPackedSequences;
+
   std::vector< size_t >     mSequenceIdsOffsetByKmer;
   std::vector< size_t >     mSequenceIdsCountByKmer;
   std::vector< SequenceId > mSequenceIds;
@@ -122,6 +127,9 @@ void Database< A >::Initialize( const SequenceList< A >& sequences ) {
   mKmerCountBySequenceId  = std::vector< size_t >( mSequences.size() );
   mKmerOffsetBySequenceId = std::vector< size_t >( mSequences.size() );
 
+  mPackedSequences.clear();
+  mPackedSequences.reserve( mSequences.size() );
+
   uniqueIndex = std::vector< SequenceId >( mMaxUniqueKmers, -1 );
 
   auto   kmersData = mKmers.data();
@@ -131,6 +139,7 @@ void Database< A >::Initialize( const SequenceList< A >& sequences ) {
     const Sequence< A >& seq = mSequences[ seqId ];
 
     mKmerOffsetBySequenceId[ seqId ] = kmerCount;
+    mPackedSequences.emplace_back( seq );
 
     Kmers< A > kmers( seq, mKmerLength );
     kmers.ForEach( [&]( const Kmer kmer, const size_t pos ) {
@@ -165,6 +174,16 @@ Database< A >::GetSequenceById( const SequenceId& seqId ) const {
   return mSequences[ seqId ];
 }
 
+template < typename A >
+bool Database< A >::GetPackedSequenceById(
+  const SequenceId& seqId, const PackedSequence< A >** packed ) const {
+  if( seqId >= NumSequences() )
+    return false;
+
+  *packed = &mPackedSequences[ seqId ];
+  return ( *packed )->IsPacked();
+}
+
 template < typename A >
 size_t Database< A >::NumSequences() const {
   return mSequences.size();
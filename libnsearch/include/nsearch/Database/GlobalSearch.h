@@ -2,12 +2,16 @@
 
 #include "Search.h"
 
+#include "HSPChain.h"
+
 #include "../Alignment/BandedAlign.h"
 #include "../Alignment/Common.h"
 #include "../Alignment/ExtendAlign.h"
+#include "../Alignment/WavefrontAlign.h"
 #include "../Database.h"
+#include "../PackedSequence.h"
 
-#include <set>
+#include <limits>
 #include <cstring>
 
 using Counter = unsigned short;
@@ -17,6 +21,15 @@ class GlobalSearch : public Search< Alphabet > {
 public:
   GlobalSearch( const Database< Alphabet >& db, const SearchParams< Alphabet >& params );
 
+  // Seed extensions done and skipped since the seed was within a region
+  // extended before, over all queries so far
+  size_t NumExtensions() const {
+    return mNumExtensions;
+  }
+  size_t NumExtensionsSaved() const {
+    return mNumExtensionsSaved;
+  }
+
 protected:
   using Search< Alphabet >::mDB;
   using Search< Alphabet >::mParams;
@@ -24,9 +37,55 @@ protected:
   void SearchForHits( const Sequence< Alphabet >&              query,
                       const SearchForHitsCallback< Alphabet >& callback );
 
-  std::vector< Counter >  mHits;
-  ExtendAlign< Alphabet > mExtendAlign;
-  BandedAlign< Alphabet > mBandedAlign;
+  // The wavefront aligner requires uniform match/mismatch scores
+  static inline bool IsWavefrontAlignApplicable();
+
+  // Aligns query and candidate end-to-end without any gaps, if that is
+  // provably the optimal alignment (scored like the wavefront aligner)
+  bool AlignUngapped( const PackedSequence< Alphabet >& query,
+                      const size_t seqId, Cigar* alignment );
+
+  bool AlignWithHSPs( const Sequence< Alphabet >& query,
+                      const Sequence< Alphabet >& candidateSeq,
+                      const std::vector< Kmer >& kmers, const size_t seqId,
+                      Cigar* alignment );
+
+  // Region extended from a seed, see mExtendedRegions
+  struct ExtendedRegion {
+    size_t a1 = 0, a2 = 0;
+    size_t b1 = 0, b2 = 0;
+    size_t candidate = 0; // mNumCandidates at the time of the extension
+
+    bool Contains( const HSP& sp ) const {
+      return a1 <= sp.a1 && sp.a2 <= a2 && b1 <= sp.b1 && sp.b2 <= b2;
+    }
+  };
+
+  // Index into mExtendedRegions
+  size_t Diagonal( const size_t a, const size_t b ) const {
+    return a + mCandidateLength - b;
+  }
+  size_t Diagonal( const HSP& sp ) const {
+    return Diagonal( sp.a1, sp.b1 );
+  }
+
+  std::vector< Counter >      mHits;
+  std::vector< HSP >          mSeeds; // reused across candidates
+  std::vector< HSP >          mHSPs;
+  std::vector< HSP >          mChain;
+  HSPChain                    mHSPChain;
+
+  // Last region extended on each diagonal of the current candidate, so
+  // seeds within it aren't extended again
+  std::vector< ExtendedRegion > mExtendedRegions;
+  size_t                        mNumCandidates   = 0;
+  size_t                        mCandidateLength = 0;
+
+  size_t mNumExtensions      = 0;
+  size_t mNumExtensionsSaved = 0;
+  ExtendAlign< Alphabet >    mExtendAlign;
+  BandedAlign< Alphabet >    mBandedAlign;
+  WavefrontAlign< Alphabet > mWavefrontAlign;
 };
 
 template < typename A >
@@ -39,11 +98,6 @@ GlobalSearch< A >::GlobalSearch( const Database< A >&     db,
 template < typename A >
 void GlobalSearch< A >::SearchForHits( const Sequence< A >&              query,
                                   const SearchForHitsCallback< A >& callback ) {
-  const size_t defaultMinHSPLength = 16;
-  const size_t maxHSPJoinDistance  = 16;
-
-  size_t minHSPLength = std::min( defaultMinHSPLength, query.Length() / 2 );
-
   // Go through each kmer, find hits
   if( mHits.size() < mDB.NumSequences() ) {
     mHits.resize( mDB.NumSequences() );
@@ -82,192 +136,338 @@ void GlobalSearch< A >::SearchForHits( const Sequence< A >&              query,
     } );
 
   // For each candidate:
-  // - Get HSPs,
-  // - Check for good HSP (>= similarity threshold)
-  // - Join HSP together
-  // - Align
+  // - Try to align it directly if it is very similar
+  // - Otherwise:
+  //   - Get HSPs,
+  //   - Check for good HSP (>= similarity threshold)
+  //   - Join HSP together
+  //   - Align
   // - Check similarity
   int numHits    = 0;
   int numRejects = 0;
 
   auto highscores = highscore.EntriesFromTopToBottom();
 
-  HitList< A > hits;
+  // Wavefront alignment only pays off for highly similar sequences, stop
+  // early and fall back to the HSP based alignment otherwise
+  const int maxWavefrontScoreLoss =
+    std::min( mWavefrontAlign.AP().maxScoreLoss, int( query.Length() / 4 ) );
+
+  // Compared against the (packed) candidates for ungapped alignments
+  PackedSequence< A > packedQuery;
+  if( IsWavefrontAlignApplicable() ) {
+    packedQuery = PackedSequence< A >( query );
+  }
 
   for( auto it = highscores.cbegin(); it != highscores.cend(); ++it ) {
     const size_t         seqId        = it->id;
     const Sequence< A >& candidateSeq = mDB.GetSequenceById( seqId );
 
-    std::deque< HSP > sps;
+    Cigar alignment;
+    bool  aligned =
+      IsWavefrontAlignApplicable() &&
+      ( AlignUngapped( packedQuery, seqId, &alignment ) ||
+        mWavefrontAlign.Align( query, candidateSeq, &alignment, NULL,
+                               maxWavefrontScoreLoss ) );
 
-    for( size_t pos = 0; pos < kmers.size(); pos++ ) {
-      const Kmer* kmers2;
-      size_t      kmers2count;
-      if( !mDB.GetKmersForSequenceId( seqId, &kmers2, &kmers2count ) )
-        continue;
+    if( !aligned ) {
+      aligned = AlignWithHSPs( query, candidateSeq, kmers, seqId, &alignment );
+    }
 
-      for( size_t pos2 = 0; pos2 < kmers2count; pos2++ ) {
-        if( kmers2[ pos2 ] != kmers[ pos ] )
-          continue;
-
-        // Look for the start of a "diagonal" (alignment matrix), then follow it
-        if( pos == 0 || pos2 == 0 || kmers[ pos - 1 ] == AmbiguousKmer ||
-            kmers2[ pos2 - 1 ] == AmbiguousKmer ||
-            ( kmers[ pos - 1 ] != kmers2[ pos2 - 1 ] ) ) {
-          size_t length = mDB.KmerLength();
-
-          size_t cur  = pos + 1;
-          size_t cur2 = pos2 + 1;
-          while( cur < kmers.size() && cur2 < kmers2count &&
-                 kmers[ cur ] != AmbiguousKmer &&
-                 kmers2[ cur ] != AmbiguousKmer &&
-                 kmers[ cur ] == kmers2[ cur2 ] ) {
-            cur++;
-            cur2++;
-            length++;
-          }
-
-          sps.emplace_back( pos, cur - 1, pos2, cur2 - 1 );
-        }
-      }
-    };
-
-    // Find all HSP
-    // Sort by length
-    // Try to find best chain
-    // Fill space between with banded align
-    std::set< HSP > hsps;
-    for( auto& sp : sps ) {
-      size_t queryPos, candidatePos;
-
-      // check if we already have a HSP which this SP is part of
-      bool isContained = false;
-      for( auto it = hsps.cbegin(); it != hsps.cend(); ++it ) {
-        const HSP& hsp = *it;
-        if (sp.IsFullyContainedWithin(hsp)) {
-          isContained = true;
-          break;
-        }
+    bool accept = false;
+    if( aligned ) {
+      float identity = alignment.Identity();
+      if( identity >= mParams.minIdentity ) {
+        accept = true;
+        callback( candidateSeq, alignment );
       }
+    }
 
-      // do not extend this, since it's part of an HSP already
-      if (isContained)
-        continue;
+    if( accept ) {
+      numHits++;
+      if( numHits >= mParams.maxAccepts )
+        break;
+    } else {
+      numRejects++;
+      if( numRejects >= mParams.maxRejects )
+        break;
+    }
+  }
+}
 
-      size_t a1 = sp.a1, a2 = sp.a2, b1 = sp.b1, b2 = sp.b2;
+template < typename A >
+bool GlobalSearch< A >::AlignUngapped( const PackedSequence< A >& query,
+                                       const size_t seqId, Cigar* alignment ) {
+  const PackedSequence< A >* candidate;
+  if( !query.IsPacked() || !mDB.GetPackedSequenceById( seqId, &candidate ) )
+    return false;
+
+  const size_t length = query.Length();
+  if( length == 0 || candidate->Length() != length )
+    return false;
+
+  // Score lost compared to a perfect match
+  const WavefrontAlignParams& ap = mWavefrontAlign.AP();
+
+  const int mismatchLoss = ap.matchScore - ap.mismatchScore;
+  auto      terminalGapLoss = [&]( const size_t len ) {
+    return -( ap.terminalGapOpenScore + int( len ) * ap.terminalGapExtendScore );
+  };
+  const int interiorGapLoss =
+    -( ap.interiorGapOpenScore + ap.interiorGapExtendScore );
+
+  const int loss =
+    int( query.NumMismatches( *candidate, 0, 0, length ) ) * mismatchLoss;
+
+  // Both sequences have the same length, so every gapped alignment has an
+  // insertion and a deletion and leaves at least one letter unaligned.
+  // If one of the gaps is interior:
+  if( loss >= interiorGapLoss +
+                std::min( terminalGapLoss( 1 ), interiorGapLoss ) +
+                ap.matchScore )
+    return false;
+
+  // Otherwise both gaps are terminal, i.e. the diagonal is shifted
+  for( size_t shift = 1; shift <= length; shift++ ) {
+    int shiftLoss = 2 * terminalGapLoss( shift ) + int( shift ) * ap.matchScore;
+    if( shiftLoss > loss )
+      break;
+
+    size_t overlap       = length - shift;
+    size_t numMismatches = std::min(
+      query.NumMismatches( *candidate, shift, 0, overlap ),
+      query.NumMismatches( *candidate, 0, shift, overlap ) );
+    if( shiftLoss + int( numMismatches ) * mismatchLoss <= loss )
+      return false;
+  }
 
-      Cigar leftCigar;
-      int   leftScore =
-        mExtendAlign.Extend( query, candidateSeq, &queryPos, &candidatePos,
-                             &leftCigar, AlignmentDirection::Reverse, a1, b1 );
-      if( !leftCigar.empty() ) {
-        a1 = queryPos;
-        b1 = candidatePos;
-      }
+  alignment->Clear();
+  size_t pos = 0;
+  query.ForEachMismatch( *candidate, 0, 0, length, [&]( const size_t mismatch ) {
+    alignment->Add( CigarEntry( int( mismatch - pos ), CigarOp::Match ) );
+    alignment->Add( CigarOp::Mismatch );
+    pos = mismatch + 1;
+  } );
+  alignment->Add( CigarEntry( int( length - pos ), CigarOp::Match ) );
 
-      Cigar  rightCigar;
-      size_t rightQuery, rightCandidate;
-      int    rightScore = mExtendAlign.Extend(
-        query, candidateSeq, &queryPos, &candidatePos, &rightCigar,
-        AlignmentDirection::Forward, a2 + 1, b2 + 1 );
-      if( !rightCigar.empty() ) {
-        a2 = queryPos;
-        b2 = candidatePos;
-      }
+  return true;
+}
 
-      HSP hsp( a1, a2, b1, b2 );
-      if( hsp.Length() >= minHSPLength ) {
-        // Construct hsp cigar (spaced seeds so we cannot assume full match)
-        Cigar middleCigar;
-        int   middleScore = 0;
-        for( size_t a = sp.a1, b = sp.b1; a <= sp.a2 && b <= sp.b2; a++, b++ ) {
-          auto   chA = query[ a ], chB = candidateSeq[ b ];
-          bool   match = MatchPolicy< A >::Match( chA, chB );
-          int8_t score = ScorePolicy< A >::Score( chA, chB );
-          middleCigar.Add( match ? CigarOp::Match : CigarOp::Mismatch );
-          middleScore += score;
+template < typename A >
+bool GlobalSearch< A >::AlignWithHSPs( const Sequence< A >&       query,
+                                       const Sequence< A >&       candidateSeq,
+                                       const std::vector< Kmer >& kmers,
+                                       const size_t seqId, Cigar* alignment ) {
+  const size_t defaultMinHSPLength = 16;
+
+  size_t minHSPLength = std::min( defaultMinHSPLength, query.Length() / 2 );
+
+  auto& sps = mSeeds;
+  sps.clear();
+
+  for( size_t pos = 0; pos < kmers.size(); pos++ ) {
+    const Kmer* kmers2;
+    size_t      kmers2count;
+    if( !mDB.GetKmersForSequenceId( seqId, &kmers2, &kmers2count ) )
+      continue;
+
+    for( size_t pos2 = 0; pos2 < kmers2count; pos2++ ) {
+      if( kmers2[ pos2 ] != kmers[ pos ] )
+        continue;
+
+      // Look for the start of a "diagonal" (alignment matrix), then follow it
+      if( pos == 0 || pos2 == 0 || kmers[ pos - 1 ] == AmbiguousKmer ||
+          kmers2[ pos2 - 1 ] == AmbiguousKmer ||
+          ( kmers[ pos - 1 ] != kmers2[ pos2 - 1 ] ) ) {
+        size_t length = mDB.KmerLength();
+
+        size_t cur  = pos + 1;
+        size_t cur2 = pos2 + 1;
+        while( cur < kmers.size() && cur2 < kmers2count &&
+               kmers[ cur ] != AmbiguousKmer &&
+               kmers2[ cur ] != AmbiguousKmer &&
+               kmers[ cur ] == kmers2[ cur2 ] ) {
+          cur++;
+          cur2++;
+          length++;
         }
-        hsp.score = leftScore + middleScore + rightScore;
-        hsp.cigar = leftCigar + middleCigar + rightCigar;
 
-        // Save HSP
-        hsps.insert( hsp );
+        sps.emplace_back( pos, cur - 1, pos2, cur2 - 1 );
       }
     }
+  };
+
+  // Find all HSP
+  // Find best co-linear chain
+  // Fill space between with banded align
+  auto& hsps = mHSPs;
+  hsps.clear();
+
+  mNumCandidates++;
+  mCandidateLength = candidateSeq.Length();
+  if( mExtendedRegions.size() < query.Length() + mCandidateLength ) {
+    mExtendedRegions.resize( query.Length() + mCandidateLength );
+  }
+  for( auto& sp : sps ) {
+    size_t queryPos, candidatePos;
+
+    // Seeds come in query order, so a region extended from an earlier seed
+    // on this diagonal would contain this one
+    const ExtendedRegion& region = mExtendedRegions[ Diagonal( sp ) ];
+    if( region.candidate == mNumCandidates && region.Contains( sp ) ) {
+      mNumExtensionsSaved++;
+      continue;
+    }
 
-    // Greedy join HSPs if close
-    struct HSPChainOrdering {
-      bool operator()( const HSP& left, const HSP& right ) const {
-        return left.a1 < right.a1 && left.b1 < right.b1;
-      }
-    };
-
-    std::set< HSP, HSPChainOrdering > chain;
-    for( auto it = hsps.rbegin(); it != hsps.rend(); ++it ) {
+    // check if we already have a HSP which this SP is part of (seeds off
+    // the HSP's diagonals, e.g. in repeats)
+    bool isContained = false;
+    for( auto it = hsps.cbegin(); it != hsps.cend(); ++it ) {
       const HSP& hsp = *it;
-      bool       hasNoOverlaps =
-        std::none_of( chain.begin(), chain.end(), [&]( const HSP& existing ) {
-          return hsp.IsOverlapping( existing );
-        } );
-      if( hasNoOverlaps ) {
-        bool anyHSPJoinable =
-          std::any_of( chain.begin(), chain.end(), [&]( const HSP& existing ) {
-            return hsp.DistanceTo( existing ) <= maxHSPJoinDistance;
-          } );
-
-        if( chain.empty() || anyHSPJoinable ) {
-          chain.insert( hsp );
-        }
+      if (sp.IsFullyContainedWithin(hsp)) {
+        isContained = true;
+        break;
       }
     }
 
-    bool accept = false;
-    if( chain.size() > 0 ) {
-      Cigar alignment;
-      Cigar cigar;
-
-      // Align first HSP's start to whole sequences begin
-      auto& first = *chain.cbegin();
-      mBandedAlign.Align( query, candidateSeq, &cigar,
-                          AlignmentDirection::Reverse, first.a1, first.b1 );
-      alignment += cigar;
-
-      // Align in between the HSP's
-      for( auto it1 = chain.cbegin(), it2 = ++chain.cbegin();
-           it1 != chain.cend() && it2 != chain.cend(); ++it1, ++it2 ) {
-        auto& current = *it1;
-        auto& next    = *it2;
-
-        alignment += current.cigar;
-        mBandedAlign.Align( query, candidateSeq, &cigar,
-                            AlignmentDirection::Forward, current.a2 + 1,
-                            current.b2 + 1, next.a1, next.b1 );
-        alignment += cigar;
-      }
+    // do not extend this, since it's part of an HSP already
+    if (isContained)
+      continue;
 
-      // Align last HSP's end to whole sequences end
-      auto& last = *chain.crbegin();
-      alignment += last.cigar;
-      mBandedAlign.Align( query, candidateSeq, &cigar,
-                          AlignmentDirection::Forward, last.a2 + 1,
-                          last.b2 + 1 );
-      alignment += cigar;
+    size_t a1 = sp.a1, a2 = sp.a2, b1 = sp.b1, b2 = sp.b2;
 
-      float identity = alignment.Identity();
-      if( identity >= mParams.minIdentity ) {
-        accept = true;
-        callback( candidateSeq, alignment );
-      }
+    Cigar leftCigar;
+    int   leftScore =
+      mExtendAlign.Extend( query, candidateSeq, &queryPos, &candidatePos,
+                           &leftCigar, AlignmentDirection::Reverse, a1, b1 );
+    if( !leftCigar.empty() ) {
+      a1 = queryPos;
+      b1 = candidatePos;
     }
 
-    if( accept ) {
-      numHits++;
-      if( numHits >= mParams.maxAccepts )
-        break;
-    } else {
-      numRejects++;
-      if( numRejects >= mParams.maxRejects )
-        break;
+    Cigar  rightCigar;
+    size_t rightQuery, rightCandidate;
+    int    rightScore = mExtendAlign.Extend(
+      query, candidateSeq, &queryPos, &candidatePos, &rightCigar,
+      AlignmentDirection::Forward, a2 + 1, b2 + 1 );
+    if( !rightCigar.empty() ) {
+      a2 = queryPos;
+      b2 = candidatePos;
+    }
+
+    HSP hsp( a1, a2, b1, b2 );
+    mNumExtensions++;
+
+    // Remember the region on all diagonals it touches (more than one only
+    // if the extension introduced gaps)
+    size_t fromDiagonal = std::min( { Diagonal( sp ), Diagonal( a1, b1 ),
+                                      Diagonal( a2, b2 ) } );
+    size_t toDiagonal   = std::max( { Diagonal( sp ), Diagonal( a1, b1 ),
+                                    Diagonal( a2, b2 ) } );
+    for( size_t d = fromDiagonal; d <= toDiagonal; d++ ) {
+      ExtendedRegion& extended = mExtendedRegions[ d ];
+      extended.a1              = a1;
+      extended.a2              = a2;
+      extended.b1              = b1;
+      extended.b2              = b2;
+      extended.candidate       = mNumCandidates;
     }
+
+    if( hsp.Length() >= minHSPLength ) {
+      // Construct hsp cigar (spaced seeds so we cannot assume full match)
+      Cigar middleCigar;
+      int   middleScore = 0;
+      for( size_t a = sp.a1, b = sp.b1; a <= sp.a2 && b <= sp.b2; a++, b++ ) {
+        auto   chA = query[ a ], chB = candidateSeq[ b ];
+        bool   match = MatchPolicy< A >::Match( chA, chB );
+        int8_t score = ScorePolicy< A >::Score( chA, chB );
+        middleCigar.Add( match ? CigarOp::Match : CigarOp::Mismatch );
+        middleScore += score;
+      }
+      hsp.score = leftScore + middleScore + rightScore;
+      leftCigar += middleCigar;
+      leftCigar += rightCigar;
+      hsp.cigar = std::move( leftCigar );
+
+      // Save HSP
+      hsps.push_back( std::move( hsp ) );
+    }
+  }
+
+  auto& chain = mChain;
+  mHSPChain.Chain( &hsps, &chain );
+
+  if( chain.empty() )
+    return false;
+
+  // Give up on the candidate as soon as it can't reach minIdentity anymore:
+  // identity >= minIdentity if differences <= differencesPerMatch * matches.
+  // Matches beyond the banded alignment are bounded by the letters left in
+  // the shorter sequence after (endA, endB).
+  const bool   limitDifferences    = mParams.minIdentity > 0.0f;
+  const double differencesPerMatch = limitDifferences
+                                       ? ( 1.0 - mParams.minIdentity ) /
+                                           mParams.minIdentity
+                                       : 0.0;
+  auto maxDifferences = [&]( const size_t endA, const size_t endB ) {
+    if( !limitDifferences )
+      return std::numeric_limits< double >::infinity();
+
+    size_t maxMatches = alignment->NumMatches() +
+                        std::min( query.Length() - endA,
+                                  candidateSeq.Length() - endB );
+    return differencesPerMatch * maxMatches -
+           double( alignment->NumDifferences() ) + 1e-6;
+  };
+
+  Cigar cigar;
+
+  // Align first HSP's start to whole sequences begin
+  auto& first = chain.front();
+  if( mBandedAlign.Align( query, candidateSeq, &cigar,
+                          AlignmentDirection::Reverse, first.a1, first.b1, -1,
+                          -1, maxDifferences( first.a1, first.b1 ),
+                          differencesPerMatch ) == mBandedAlign.Rejected() )
+    return false;
+  *alignment += cigar;
+
+  // Align in between the HSP's
+  for( auto it1 = chain.cbegin(), it2 = ++chain.cbegin();
+       it1 != chain.cend() && it2 != chain.cend(); ++it1, ++it2 ) {
+    auto& current = *it1;
+    auto& next    = *it2;
+
+    *alignment += current.cigar;
+    if( mBandedAlign.Align( query, candidateSeq, &cigar,
+                            AlignmentDirection::Forward, current.a2 + 1,
+                            current.b2 + 1, next.a1, next.b1,
+                            maxDifferences( next.a1, next.b1 ),
+                            differencesPerMatch ) == mBandedAlign.Rejected() )
+      return false;
+    *alignment += cigar;
   }
+
+  // Align last HSP's end to whole sequences end
+  auto& last = chain.back();
+  *alignment += last.cigar;
+  if( mBandedAlign.Align( query, candidateSeq, &cigar,
+                          AlignmentDirection::Forward, last.a2 + 1,
+                          last.b2 + 1, -1, -1,
+                          maxDifferences( query.Length(),
+                                          candidateSeq.Length() ),
+                          differencesPerMatch ) == mBandedAlign.Rejected() )
+    return false;
+  *alignment += cigar;
+
+  return true;
+}
+
+template < typename A >
+inline bool GlobalSearch< A >::IsWavefrontAlignApplicable() {
+  return false;
+}
+
+template <>
+inline bool GlobalSearch< DNA >::IsWavefrontAlignApplicable() {
+  return true;
 }
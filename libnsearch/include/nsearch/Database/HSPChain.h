@@ -0,0 +1,93 @@
+#pragma once
+
+#include "HSP.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+typedef struct HSPChainParams {
+  // HSPs further apart are never joined
+  size_t maxJoinDistance = 16;
+
+  // Number of preceding HSPs tried as predecessor of each HSP
+  size_t maxPredecessors = 64;
+
+  // Joining HSPs on different diagonals is penalized like a gap
+  int gapOpenScore   = -20;
+  int gapExtendScore = -2;
+} HSPChainParams;
+
+// Co-linear chaining (like minimap2): finds the highest scoring chain of HSPs
+// which don't overlap and are ordered along both sequences.
+// Dynamic programming over the HSPs sorted by position, trying a bounded
+// number of predecessors each, i.e. O(n log n) for n HSPs.
+class HSPChain {
+public:
+  HSPChain( const HSPChainParams& params = HSPChainParams() )
+      : mParams( params ) {}
+
+  // Moves the best chain of hsps into chain, in sequence order.
+  // hsps is reordered, chained HSPs are left in a moved-from state.
+  void Chain( std::vector< HSP >* hsps, std::vector< HSP >* chain ) {
+    chain->clear();
+    if( hsps->empty() )
+      return;
+
+    std::sort( hsps->begin(), hsps->end(), []( const HSP& l, const HSP& r ) {
+      return l.a1 < r.a1 || ( l.a1 == r.a1 && l.b1 < r.b1 );
+    } );
+
+    const size_t n = hsps->size();
+    mScores.resize( n );
+    mPredecessors.resize( n );
+
+    size_t best = 0;
+    for( size_t i = 0; i < n; i++ ) {
+      const HSP& hsp = ( *hsps )[ i ];
+
+      mScores[ i ]       = hsp.Score();
+      mPredecessors[ i ] = NoPredecessor;
+
+      size_t first =
+        i > mParams.maxPredecessors ? i - mParams.maxPredecessors : 0;
+      for( size_t j = i; j-- > first; ) {
+        const HSP& pred = ( *hsps )[ j ];
+        if( pred.a2 >= hsp.a1 || pred.b2 >= hsp.b1 )
+          continue;
+
+        if( pred.DistanceTo( hsp ) > mParams.maxJoinDistance )
+          continue;
+
+        long score = mScores[ j ] + hsp.Score() + GapScore( pred, hsp );
+        if( score > mScores[ i ] ) {
+          mScores[ i ]       = score;
+          mPredecessors[ i ] = j;
+        }
+      }
+
+      if( mScores[ i ] > mScores[ best ] ) {
+        best = i;
+      }
+    }
+
+    for( size_t i = best; i != NoPredecessor; i = mPredecessors[ i ] ) {
+      chain->push_back( std::move( ( *hsps )[ i ] ) );
+    }
+    std::reverse( chain->begin(), chain->end() );
+  }
+
+private:
+  static const size_t NoPredecessor = -1;
+
+  // Penalty for the diagonal shift from pred to next
+  long GapScore( const HSP& pred, const HSP& next ) const {
+    long shift = labs( long( next.a1 - pred.a2 ) - long( next.b1 - pred.b2 ) );
+    return shift > 0 ? mParams.gapOpenScore + shift * mParams.gapExtendScore
+                     : 0;
+  }
+
+  HSPChainParams        mParams;
+  std::vector< long >   mScores;
+  std::vector< size_t > mPredecessors;
+};
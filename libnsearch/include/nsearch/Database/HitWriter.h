@@ -2,21 +2,30 @@
 
 #include "Search.h"
 
+#include "../OutputFile.h"
+
 #include <fstream>
+#include <memory>
 
 template < typename Alphabet >
 class HitWriter {
 public:
   HitWriter( std::ostream& output ) : mOutput( output ) {}
   HitWriter( const std::string& pathToFile )
-      : mFile( pathToFile ), mOutput( mFile ) {}
+      : mFile( OpenOutputFile( pathToFile ) ), mOutput( *mFile ) {}
 
   virtual HitWriter< Alphabet >&
   operator<<( const QueryHitsPair< Alphabet >& queryWithHits ) = 0;
 
+  // Called once before any hits, with all sequences hits can refer to
+  virtual void WriteHeader( const SequenceList< Alphabet >& /* targets */ ) {}
+
   virtual ~HitWriter() = default;
 
 protected:
-  std::ofstream mFile;
-  std::ostream& mOutput;
+  HitWriter( std::unique_ptr< std::ostream > file )
+      : mFile( std::move( file ) ), mOutput( *mFile ) {}
+
+  std::unique_ptr< std::ostream > mFile;
+  std::ostream&                   mOutput;
 };
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "../RecordParser.h"
+
+namespace FASTA {
+
+class Parser : public RecordParser {
+public:
+  size_t Parse( const char* data, const size_t size, const bool endOfFile,
+                RecordBatch* batch ) const {
+    size_t   pos = 0, numBytes = 0;
+    LineView header, line;
+
+    while( NextLine( data, size, &pos, endOfFile, &header ) ) {
+      // The record ends where the next one starts
+      size_t end = FindHeader( data, size, pos );
+      if( end == size && !endOfFile )
+        break;
+
+      // delete '>'
+      batch->BeginRecord( LineView( header.data + 1, header.length - 1 ) );
+      while( NextLine( data, end, &pos, true, &line ) ) {
+        batch->AppendSequence( line );
+      }
+      batch->EndRecord();
+
+      numBytes = pos;
+    }
+
+    return endOfFile ? size : numBytes;
+  }
+
+  size_t FindRecordStart( const char* data, const size_t size,
+                          const bool startsLine ) const {
+    return FindHeader( data, size, FirstLineStart( data, size, startsLine ) );
+  }
+
+private:
+  // Start of the first line beginning with '>' at or after pos (which has to
+  // be the start of a line). '>' is rare within records, memchr skips ahead
+  static size_t FindHeader( const char* data, const size_t size, size_t pos ) {
+    if( pos < size && data[ pos ] == '>' )
+      return pos;
+
+    while( pos < size ) {
+      const char* ch = ( const char* ) memchr( data + pos, '>', size - pos );
+      if( ch == NULL )
+        break;
+
+      if( ch[ -1 ] == '\n' )
+        return ch - data;
+
+      pos = ch - data + 1;
+    }
+    return size;
+  }
+};
+
+} // namespace FASTA
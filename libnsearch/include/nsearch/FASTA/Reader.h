@@ -1,44 +1,20 @@
 #pragma once
 
 #include "../SequenceReader.h"
+#include "Parser.h"
 
 namespace FASTA {
 
 template < typename Alphabet >
-class Reader : public SequenceReader< Alphabet > {
+class Reader : public TextSequenceReader< Alphabet > {
 public:
-  using SequenceReader< Alphabet >::SequenceReader;
+  using TextSequenceReader< Alphabet >::TextSequenceReader;
 
-  Reader< Alphabet >& operator>>( Sequence< Alphabet >& seq ) {
-    std::string identifier, sequence;
-    if( mLastLine.empty() ) {
-      ( *mTextReader ) >> identifier;
-    } else {
-      identifier = mLastLine;
-    }
-
-    std::string line;
-    while( !SequenceReader< Alphabet >::EndOfFile() ) {
-      ( *mTextReader ) >> line;
-
-      if( line[ 0 ] == '>' ) {
-        mLastLine = line;
-        break;
-      }
-
-      sequence += line;
-    }
-
-    UpcaseString( sequence );
-    seq = Sequence< Alphabet >( identifier.substr( 1 ), sequence );
-
-    return *this;
+protected:
+  const RecordParser& Parser() const {
+    static const FASTA::Parser parser;
+    return parser;
   }
-
-private:
-  using SequenceReader< Alphabet >::mTextReader;
-
-  std::string mLastLine;
 };
 
 } // namespace FASTA
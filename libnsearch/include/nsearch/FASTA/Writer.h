@@ -2,6 +2,8 @@
 
 #include "../SequenceWriter.h"
 
+#include <algorithm>
+
 namespace FASTA {
 
 template < typename Alphabet >
@@ -13,10 +15,11 @@ public:
 
   Writer< Alphabet >& operator<<( const Sequence< Alphabet >& seq ) {
     auto& out = this->mOutput;
-    out << '>' << seq.identifier << std::endl;
+    out << '>' << seq.identifier << '\n';
     for( size_t i = 0; i < seq.Length(); i += MaxLineLength ) {
-      auto sub = seq.Subsequence( i, MaxLineLength );
-      out << sub.sequence << std::endl;
+      out.write( seq.sequence.data() + i,
+                 std::min( size_t( MaxLineLength ), seq.Length() - i ) );
+      out << '\n';
     }
     return *this;
   }
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "../RecordParser.h"
+
+namespace FASTQ {
+
+class Parser : public RecordParser {
+public:
+  size_t Parse( const char* data, const size_t size, const bool endOfFile,
+                RecordBatch* batch ) const {
+    size_t   pos = 0, numBytes = 0;
+    LineView header, sequence, plus, quality;
+
+    while( NextLine( data, size, &pos, endOfFile, &header ) ) {
+      sequence = plus = quality = LineView();
+
+      bool complete = NextLine( data, size, &pos, endOfFile, &sequence ) &&
+                      NextLine( data, size, &pos, endOfFile, &plus ) &&
+                      NextLine( data, size, &pos, endOfFile, &quality );
+      if( !complete && !endOfFile )
+        break;
+
+      // delete '@'
+      batch->BeginRecord( LineView( header.data + 1, header.length - 1 ) );
+      batch->AppendSequence( sequence );
+      batch->AppendQuality( quality );
+      batch->EndRecord();
+
+      numBytes = pos;
+    }
+
+    return endOfFile ? size : numBytes;
+  }
+
+  // Quality lines can start with '@' too. A header is told apart by the
+  // '+' line two lines further down, two lines below a quality line is a
+  // sequence
+  size_t FindRecordStart( const char* data, const size_t size,
+                          const bool startsLine ) const {
+    size_t   pos = FirstLineStart( data, size, startsLine );
+    LineView line, sequence, plus;
+
+    while( true ) {
+      if( !NextLine( data, size, &pos, false, &line ) )
+        break;
+
+      if( line[ 0 ] != '@' )
+        continue;
+
+      size_t next = pos;
+      if( !NextLine( data, size, &next, false, &sequence ) ||
+          !NextLine( data, size, &next, false, &plus ) )
+        break; // can't tell
+
+      if( plus[ 0 ] == '+' )
+        return line.data - data;
+    }
+
+    return size;
+  }
+};
+
+} // namespace FASTQ
@@ -1,31 +1,20 @@
 #pragma once
 
 #include "../SequenceReader.h"
+#include "Parser.h"
 
 namespace FASTQ {
 
 template < typename Alphabet >
-class Reader : public SequenceReader< Alphabet > {
+class Reader : public TextSequenceReader< Alphabet > {
 public:
-  using SequenceReader< Alphabet >::SequenceReader;
+  using TextSequenceReader< Alphabet >::TextSequenceReader;
 
-  Reader< Alphabet >& operator>>( Sequence< Alphabet >& seq ) {
-    ( *mTextReader ) >> seq.identifier;
-    ( *mTextReader ) >> seq.sequence;
-    ( *mTextReader ) >> seq.quality; // skip plusline
-    ( *mTextReader ) >> seq.quality;
-
-    // delete '>'
-    seq.identifier.erase( seq.identifier.begin(), seq.identifier.begin() + 1 );
-
-    UpcaseString( seq.sequence ); // atc -> ATC
-    UpcaseString( seq.quality );
-
-    return *this;
+protected:
+  const RecordParser& Parser() const {
+    static const FASTQ::Parser parser;
+    return parser;
   }
-
-private:
-  using SequenceReader< Alphabet >::mTextReader;
 };
 
 } // namespace FASTQ
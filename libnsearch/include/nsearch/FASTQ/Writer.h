@@ -11,10 +11,10 @@ public:
 
   Writer< Alphabet >& operator<<( const Sequence< Alphabet >& seq ) {
     auto& out = this->mOutput;
-    out << '@' << seq.identifier << std::endl;
-    out << seq.sequence << std::endl;
-    out << '+' << std::endl;
-    out << seq.quality << std::endl;
+    out << '@' << seq.identifier << '\n';
+    out << seq.sequence << '\n';
+    out << '+' << '\n';
+    out << seq.quality << '\n';
     return *this;
   }
 };
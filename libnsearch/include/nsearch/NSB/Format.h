@@ -0,0 +1,103 @@
+#pragma once
+
+#include "../Alphabet.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * NSB: sequences stored the way they are used, so repeated runs skip
+ * parsing and upcasing.
+ *
+ * Header: "NSB\1", bits per letter (2, or 8 for alphabets which can't be
+ *         packed), 3 zero bytes
+ * Blocks: numRecords (u32), numExceptions (u32), identifiers size,
+ *         number of letters, qualities size (u64 each),
+ *         end offsets of each record's identifier, letters, quality and
+ *         exceptions within the block (u32 arrays),
+ *         identifiers, packed letters (first letter in the lowest bits),
+ *         exceptions (position (u32), count (u32), letter), qualities
+ * Index:  offset of each block (u64)
+ * Footer: number of blocks, number of records, index offset (u64), "NSBI"
+ *
+ * Letters which can't be packed (e.g. N) are stored as 0 bits plus a run in
+ * the exception list. All numbers are little endian.
+ */
+namespace NSB {
+
+static const char   Magic[]         = "NSB\1";
+static const char   FooterMagic[]   = "NSBI";
+static const size_t HeaderSize      = 8;
+static const size_t BlockHeaderSize = 32;
+static const size_t ExceptionSize   = 9;
+static const size_t FooterSize      = 3 * 8 + 4;
+
+static const size_t MaxBlockRecords = 4096;
+static const size_t MaxBlockLetters = 4 * 1024 * 1024;
+
+template < typename Alphabet >
+size_t BitsPerLetter() {
+  return BitMapPolicy< Alphabet >::NumBits == 2 &&
+             BitMapPolicy< Alphabet >::PreservesMatches
+           ? 2
+           : 8;
+}
+
+// Letter each of the 4 bit patterns is decoded to
+template < typename Alphabet >
+const char* PackedLetters() {
+  static const std::string letters = []() {
+    std::string letters( 4, '\0' );
+    for( char letter : std::string( "ACGT" ) ) {
+      int8_t bits = BitMapPolicy< Alphabet >::BitMap( letter );
+      if( bits >= 0 && bits < 4 && !letters[ bits ] )
+        letters[ bits ] = letter;
+    }
+    return letters;
+  }();
+  return letters.data();
+}
+
+inline void PutUint32( std::string* out, const uint32_t value ) {
+  for( int i = 0; i < 4; i++ )
+    *out += char( ( value >> ( 8 * i ) ) & 0xFF );
+}
+
+inline void PutUint64( std::string* out, const uint64_t value ) {
+  PutUint32( out, uint32_t( value ) );
+  PutUint32( out, uint32_t( value >> 32 ) );
+}
+
+inline uint32_t GetUint32( const uint8_t* bytes ) {
+  return bytes[ 0 ] | ( bytes[ 1 ] << 8 ) | ( bytes[ 2 ] << 16 ) |
+         ( uint32_t( bytes[ 3 ] ) << 24 );
+}
+
+inline uint64_t GetUint64( const uint8_t* bytes ) {
+  return GetUint32( bytes ) | ( uint64_t( GetUint32( bytes + 4 ) ) << 32 );
+}
+
+// Mapped into memory if possible, read completely otherwise (e.g. "-" or
+// compressed)
+class MappedFile {
+public:
+  MappedFile( const std::string& fileName );
+  ~MappedFile();
+
+  const uint8_t* Data() const {
+    return mData;
+  }
+
+  size_t Size() const {
+    return mSize;
+  }
+
+private:
+  const uint8_t*         mData;
+  size_t                 mSize;
+  bool                   mIsMapped;
+  std::vector< uint8_t > mContents;
+};
+
+} // namespace NSB
@@ -0,0 +1,257 @@
+#pragma once
+
+#include "../SequenceReader.h"
+#include "Format.h"
+
+#include <cstring>
+#include <memory>
+
+namespace NSB {
+
+/*
+ * Decodes one block per batch straight from the mapped file, four letters
+ * per table lookup. Files which aren't valid NSB (for this alphabet) read
+ * as empty and are reported by IsValid, the layout of all blocks is checked
+ * up front so corrupt or truncated files are never read out of bounds.
+ */
+template < typename Alphabet >
+class Reader : public SequenceReader< Alphabet > {
+public:
+  Reader( const std::string& pathToFile )
+      : mFile( new MappedFile( pathToFile ) ), mNumBlocks( 0 ),
+        mNumRecords( 0 ), mIndex( NULL ), mNextBlock( 0 ), mValid( false ) {
+    const uint8_t* data = mFile->Data();
+    size_t         size = mFile->Size();
+    if( size < HeaderSize + FooterSize || memcmp( data, Magic, 4 ) != 0 ||
+        data[ 4 ] != BitsPerLetter< Alphabet >() )
+      return;
+
+    const uint8_t* footer = data + size - FooterSize;
+    if( memcmp( footer + 24, FooterMagic, 4 ) != 0 )
+      return;
+
+    uint64_t numBlocks   = GetUint64( footer );
+    uint64_t numRecords  = GetUint64( footer + 8 );
+    uint64_t indexOffset = GetUint64( footer + 16 );
+    if( indexOffset < HeaderSize || indexOffset > size - FooterSize ||
+        numBlocks != ( size - FooterSize - indexOffset ) / 8 ||
+        indexOffset + numBlocks * 8 + FooterSize != size )
+      return;
+
+    // Blocks follow each other between the header and the index
+    const uint8_t* index       = data + indexOffset;
+    uint64_t       blockEnd    = indexOffset;
+    uint64_t       numInBlocks = 0;
+    for( uint64_t i = numBlocks; i-- > 0; ) {
+      uint64_t blockOffset = GetUint64( index + i * 8 );
+      if( blockOffset < HeaderSize || blockOffset >= blockEnd ||
+          !IsValidBlock( data + blockOffset, blockEnd - blockOffset,
+                         &numInBlocks ) )
+        return;
+      blockEnd = blockOffset;
+    }
+    if( numInBlocks != numRecords )
+      return;
+
+    mNumBlocks  = numBlocks;
+    mNumRecords = numRecords;
+    mIndex      = index;
+    mValid      = true;
+  }
+
+  // False if the file isn't NSB, is corrupt or truncated, or stores
+  // another alphabet
+  bool IsValid() const {
+    return mValid;
+  }
+
+  // From the footer, without reading the records
+  size_t NumRecords() const {
+    return mNumRecords;
+  }
+
+  size_t NumBytesRead() const {
+    return mNextBlock < mNumBlocks ? GetUint64( mIndex + mNextBlock * 8 )
+                                   : mFile->Size();
+  }
+
+  size_t NumBytesTotal() const {
+    return mFile->Size();
+  }
+
+protected:
+  bool EndOfInput() const {
+    return mNextBlock >= mNumBlocks;
+  }
+
+  void ReadBatch( RecordBatch* batch ) {
+    if( EndOfInput() )
+      return;
+
+    const uint8_t* block =
+      mFile->Data() + GetUint64( mIndex + mNextBlock * 8 );
+    mNextBlock++;
+
+    size_t   numRecords      = GetUint32( block );
+    size_t   numExceptions   = GetUint32( block + 4 );
+    uint64_t identifiersSize = GetUint64( block + 8 );
+    uint64_t numLetters      = GetUint64( block + 16 );
+
+    const uint8_t* identifierEnds = block + BlockHeaderSize;
+    const uint8_t* sequenceEnds   = identifierEnds + numRecords * 4;
+    const uint8_t* qualityEnds    = sequenceEnds + numRecords * 4;
+    const uint8_t* exceptionEnds  = qualityEnds + numRecords * 4;
+
+    const uint8_t* identifiers = exceptionEnds + numRecords * 4;
+    const uint8_t* letters     = identifiers + identifiersSize;
+    const uint8_t* exceptions =
+      letters + ( numLetters * BitsPerLetter< Alphabet >() + 7 ) / 8;
+    const uint8_t* qualities = exceptions + numExceptions * ExceptionSize;
+
+    size_t identifierStart = 0, sequenceStart = 0, qualityStart = 0,
+           exceptionStart = 0;
+    for( size_t i = 0; i < numRecords; i++ ) {
+      size_t identifierEnd = GetUint32( identifierEnds + i * 4 );
+      size_t sequenceEnd   = GetUint32( sequenceEnds + i * 4 );
+      size_t qualityEnd    = GetUint32( qualityEnds + i * 4 );
+      size_t exceptionEnd  = GetUint32( exceptionEnds + i * 4 );
+
+      char* sequence = batch->AddRecord(
+        LineView( ( const char* ) identifiers + identifierStart,
+                  identifierEnd - identifierStart ),
+        sequenceEnd - sequenceStart,
+        LineView( ( const char* ) qualities + qualityStart,
+                  qualityEnd - qualityStart ) );
+
+      if( BitsPerLetter< Alphabet >() == 8 ) {
+        memcpy( sequence, letters + sequenceStart,
+                sequenceEnd - sequenceStart );
+      } else {
+        Unpack( letters, sequenceStart, sequenceEnd, sequence );
+      }
+
+      for( size_t e = exceptionStart; e < exceptionEnd; e++ ) {
+        const uint8_t* exception = exceptions + e * ExceptionSize;
+        memset( sequence + GetUint32( exception ) - sequenceStart,
+                exception[ 8 ], GetUint32( exception + 4 ) );
+      }
+
+      identifierStart = identifierEnd;
+      sequenceStart   = sequenceEnd;
+      qualityStart    = qualityEnd;
+      exceptionStart  = exceptionEnd;
+    }
+  }
+
+private:
+  // Sections within size, ends ascending within their section and
+  // exceptions within their record. Adds the records to numRecords
+  static bool IsValidBlock( const uint8_t* block, uint64_t size,
+                            uint64_t* numRecords ) {
+    auto take = [&size]( const uint64_t numBytes ) {
+      if( numBytes > size )
+        return false;
+      size -= numBytes;
+      return true;
+    };
+
+    if( !take( BlockHeaderSize ) )
+      return false;
+
+    uint64_t numBlockRecords = GetUint32( block );
+    uint64_t numExceptions   = GetUint32( block + 4 );
+    uint64_t identifiersSize = GetUint64( block + 8 );
+    uint64_t numLetters      = GetUint64( block + 16 );
+    uint64_t qualitiesSize   = GetUint64( block + 24 );
+    uint64_t lettersSize     = BitsPerLetter< Alphabet >() == 8
+                             ? numLetters
+                             : numLetters / 4 + ( numLetters % 4 != 0 );
+    if( !take( numBlockRecords * 16 ) || !take( identifiersSize ) ||
+        !take( lettersSize ) || !take( numExceptions * ExceptionSize ) ||
+        !take( qualitiesSize ) )
+      return false;
+
+    const uint8_t* identifierEnds = block + BlockHeaderSize;
+    const uint8_t* sequenceEnds   = identifierEnds + numBlockRecords * 4;
+    const uint8_t* qualityEnds    = sequenceEnds + numBlockRecords * 4;
+    const uint8_t* exceptionEnds  = qualityEnds + numBlockRecords * 4;
+    const uint8_t* exceptions     = exceptionEnds + numBlockRecords * 4 +
+                                identifiersSize + lettersSize;
+
+    uint64_t identifierStart = 0, sequenceStart = 0, qualityStart = 0,
+             exceptionStart = 0;
+    for( uint64_t i = 0; i < numBlockRecords; i++ ) {
+      uint64_t identifierEnd = GetUint32( identifierEnds + i * 4 );
+      uint64_t sequenceEnd   = GetUint32( sequenceEnds + i * 4 );
+      uint64_t qualityEnd    = GetUint32( qualityEnds + i * 4 );
+      uint64_t exceptionEnd  = GetUint32( exceptionEnds + i * 4 );
+      if( identifierEnd < identifierStart || identifierEnd > identifiersSize ||
+          sequenceEnd < sequenceStart || sequenceEnd > numLetters ||
+          qualityEnd < qualityStart || qualityEnd > qualitiesSize ||
+          exceptionEnd < exceptionStart || exceptionEnd > numExceptions )
+        return false;
+
+      for( uint64_t e = exceptionStart; e < exceptionEnd; e++ ) {
+        const uint8_t* exception = exceptions + e * ExceptionSize;
+        uint64_t       pos       = GetUint32( exception );
+        uint64_t       count     = GetUint32( exception + 4 );
+        if( pos < sequenceStart || pos > sequenceEnd ||
+            count > sequenceEnd - pos )
+          return false;
+      }
+
+      identifierStart = identifierEnd;
+      sequenceStart   = sequenceEnd;
+      qualityStart    = qualityEnd;
+      exceptionStart  = exceptionEnd;
+    }
+
+    *numRecords += numBlockRecords;
+    return true;
+  }
+
+  // Letters [start, end) of the packed block
+  static void Unpack( const uint8_t* packed, size_t start, const size_t end,
+                      char* out ) {
+    // Up to the next full byte
+    for( ; start < end && start % 4 != 0; start++ ) {
+      *out++ = LetterAt( packed, start );
+    }
+
+    const char* table = ByteTable();
+    for( ; start + 4 <= end; start += 4 ) {
+      memcpy( out, table + packed[ start / 4 ] * 4, 4 );
+      out += 4;
+    }
+
+    for( ; start < end; start++ ) {
+      *out++ = LetterAt( packed, start );
+    }
+  }
+
+  static char LetterAt( const uint8_t* packed, const size_t pos ) {
+    uint8_t bits = ( packed[ pos / 4 ] >> ( pos % 4 * 2 ) ) & 3;
+    return PackedLetters< Alphabet >()[ bits ];
+  }
+
+  // The 4 letters of each byte
+  static const char* ByteTable() {
+    static const std::string table = []() {
+      const char* packedLetters = PackedLetters< Alphabet >();
+
+      std::string table( 256 * 4, '\0' );
+      for( size_t i = 0; i < table.size(); i++ )
+        table[ i ] = packedLetters[ ( ( i / 4 ) >> ( i % 4 * 2 ) ) & 3 ];
+      return table;
+    }();
+    return table.data();
+  }
+
+  std::unique_ptr< MappedFile > mFile;
+  size_t                        mNumBlocks, mNumRecords;
+  const uint8_t*                mIndex;
+  size_t                        mNextBlock;
+  bool                          mValid;
+};
+
+} // namespace NSB
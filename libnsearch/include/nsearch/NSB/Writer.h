@@ -0,0 +1,149 @@
+#pragma once
+
+#include "../SequenceWriter.h"
+#include "Format.h"
+
+#include <string>
+#include <vector>
+
+namespace NSB {
+
+// Records are collected per block, the index is written on destruction
+template < typename Alphabet >
+class Writer : public SequenceWriter< Alphabet > {
+public:
+  Writer( std::ostream& output ) : SequenceWriter< Alphabet >( output ) {
+    WriteHeader();
+  }
+
+  Writer( const std::string& pathToFile )
+      : SequenceWriter< Alphabet >( pathToFile ) {
+    WriteHeader();
+  }
+
+  ~Writer() {
+    WriteBlock();
+
+    std::string index;
+    for( auto offset : mBlockOffsets )
+      PutUint64( &index, offset );
+
+    PutUint64( &index, mBlockOffsets.size() );
+    PutUint64( &index, mNumRecords );
+    PutUint64( &index, mNumBytesWritten );
+    index.append( FooterMagic, 4 );
+    this->mOutput.write( index.data(), index.size() );
+  }
+
+  Writer< Alphabet >& operator<<( const Sequence< Alphabet >& seq ) {
+    if( mSequenceEnds.size() >= MaxBlockRecords ||
+        ( !mSequenceEnds.empty() &&
+          mNumLetters + seq.Length() > MaxBlockLetters ) ) {
+      WriteBlock();
+    }
+
+    mIdentifiers += seq.identifier;
+    mQualities += seq.quality;
+
+    if( BitsPerLetter< Alphabet >() == 8 ) {
+      mLetters += seq.sequence;
+      mNumLetters += seq.Length();
+    } else {
+      const char* packedLetters = PackedLetters< Alphabet >();
+
+      mLetters.resize( ( mNumLetters + seq.Length() + 3 ) / 4, 0 );
+      for( char letter : seq.sequence ) {
+        // Whatever isn't decoded to itself (e.g. N or U)
+        int8_t bits = BitMapPolicy< Alphabet >::BitMap( letter );
+        if( bits < 0 || packedLetters[ bits ] != letter ) {
+          AddException( letter );
+          bits = 0;
+        }
+        mLetters[ mNumLetters / 4 ] |= char( bits << ( mNumLetters % 4 * 2 ) );
+        mNumLetters++;
+      }
+    }
+
+    mIdentifierEnds.push_back( mIdentifiers.size() );
+    mSequenceEnds.push_back( mNumLetters );
+    mQualityEnds.push_back( mQualities.size() );
+    mExceptionEnds.push_back( mExceptions.size() );
+    mNumRecords++;
+    return *this;
+  }
+
+private:
+  // Runs of the same letter are merged
+  void AddException( const char letter ) {
+    size_t recordStart = mSequenceEnds.empty() ? 0 : mSequenceEnds.back();
+    if( !mExceptions.empty() ) {
+      Exception& last = mExceptions.back();
+      if( last.letter == letter && last.pos >= recordStart &&
+          last.pos + last.count == mNumLetters ) {
+        last.count++;
+        return;
+      }
+    }
+
+    mExceptions.push_back( { uint32_t( mNumLetters ), 1, letter } );
+  }
+
+  void WriteHeader() {
+    std::string header( Magic, 4 );
+    header += char( BitsPerLetter< Alphabet >() );
+    header.append( 3, '\0' );
+    this->mOutput.write( header.data(), header.size() );
+    mNumBytesWritten = header.size();
+  }
+
+  void WriteBlock() {
+    if( mSequenceEnds.empty() )
+      return;
+
+    std::string block;
+    PutUint32( &block, mSequenceEnds.size() );
+    PutUint32( &block, mExceptions.size() );
+    PutUint64( &block, mIdentifiers.size() );
+    PutUint64( &block, mNumLetters );
+    PutUint64( &block, mQualities.size() );
+    for( auto ends : { &mIdentifierEnds, &mSequenceEnds, &mQualityEnds,
+                       &mExceptionEnds } ) {
+      for( auto end : *ends )
+        PutUint32( &block, end );
+      ends->clear();
+    }
+
+    std::string exceptions;
+    for( auto& exception : mExceptions ) {
+      PutUint32( &exceptions, exception.pos );
+      PutUint32( &exceptions, exception.count );
+      exceptions += exception.letter;
+    }
+    mExceptions.clear();
+
+    mBlockOffsets.push_back( mNumBytesWritten );
+    for( auto data : { &block, &mIdentifiers, &mLetters, &exceptions,
+                       &mQualities } ) {
+      this->mOutput.write( data->data(), data->size() );
+      mNumBytesWritten += data->size();
+      data->clear();
+    }
+    mNumLetters = 0;
+  }
+
+  struct Exception {
+    uint32_t pos, count;
+    char     letter;
+  };
+
+  std::string             mIdentifiers, mLetters, mQualities;
+  std::vector< uint32_t > mIdentifierEnds, mSequenceEnds, mQualityEnds,
+    mExceptionEnds;
+  std::vector< Exception > mExceptions;
+  size_t                   mNumLetters = 0;
+
+  std::vector< uint64_t > mBlockOffsets;
+  uint64_t                mNumRecords = 0, mNumBytesWritten = 0;
+};
+
+} // namespace NSB
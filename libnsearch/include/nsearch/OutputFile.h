@@ -0,0 +1,62 @@
+#pragma once
+
+#include "BGZF.h"
+
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/*
+ * Writes to a file through a large buffer. Flushing (e.g. std::endl) is
+ * ignored: the buffer is written when it is full and on destruction. Data
+ * which doesn't fit anymore goes out together with the buffer in a single
+ * writev. "-" writes to stdout.
+ */
+class BufferedOutputStream : public std::ostream {
+public:
+  BufferedOutputStream( const std::string& fileName,
+                        const size_t       bufferSize = 1024 * 1024 );
+
+private:
+  class Buffer : public std::streambuf {
+  public:
+    Buffer( const std::string& fileName, const size_t bufferSize );
+    ~Buffer();
+
+    bool IsOpen() const;
+
+  protected:
+    int_type        overflow( int_type ch );
+    std::streamsize xsputn( const char* data, std::streamsize count );
+    int             sync();
+
+  private:
+    // Writes the buffered bytes followed by data
+    bool Write( const char* data, const size_t size );
+
+    int                 mFd;
+    std::vector< char > mBuffer; // put area
+  };
+
+  Buffer mBuffer;
+};
+
+inline bool IsGzipFileName( const std::string& fileName ) {
+  const std::string suffix = ".gz";
+  return fileName.size() >= suffix.size() &&
+         fileName.compare( fileName.size() - suffix.size(), suffix.size(),
+                           suffix ) == 0;
+}
+
+// Files ending in .gz are compressed (BGZF, on all cores)
+inline std::unique_ptr< std::ostream >
+OpenOutputFile( const std::string& fileName ) {
+#ifdef USE_ZLIB
+  if( IsGzipFileName( fileName ) )
+    return std::unique_ptr< std::ostream >( new BGZFOutputStream( fileName ) );
+#endif
+
+  return std::unique_ptr< std::ostream >(
+    new BufferedOutputStream( fileName ) );
+}
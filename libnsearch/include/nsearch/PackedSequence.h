@@ -0,0 +1,195 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Alphabet.h"
+#include "Sequence.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Sequence packed into 64-bit words via BitMapPolicy, so many letters can be
+// compared at once (XOR + popcount).
+// Only alphabets whose bit mapping preserves matches are packed, and only
+// sequences without ambiguous letters. Check IsPacked().
+template < typename Alphabet >
+class PackedSequence {
+public:
+  using Word = uint64_t;
+
+  static const size_t NumBits = BitMapPolicy< Alphabet >::NumBits;
+  static const size_t LettersPerWord =
+    NumBits > 0 ? sizeof( Word ) * 8 / NumBits : 0;
+
+  PackedSequence();
+  PackedSequence( const Sequence< Alphabet >& sequence );
+
+  bool   IsPacked() const;
+  size_t Length() const;
+
+  // Number of letters in [pos, pos + length) which differ from the letters
+  // in [otherPos, otherPos + length) of other
+  size_t NumMismatches( const PackedSequence< Alphabet >& other,
+                        const size_t pos, const size_t otherPos,
+                        const size_t length ) const;
+
+  // Calls callback( offset ) for each of these mismatches, in order
+  template < typename Callback >
+  void ForEachMismatch( const PackedSequence< Alphabet >& other,
+                        const size_t pos, const size_t otherPos,
+                        const size_t length, const Callback& callback ) const;
+
+private:
+  // Letters starting at pos, first letter in the lowest bits
+  inline Word WordAt( const size_t pos ) const;
+
+  // Lowest bit of each of the first n letter slots
+  static constexpr Word LowBits( const size_t n ) {
+    return n == 0 ? 0 : ( LowBits( n - 1 ) << NumBits ) | 1;
+  }
+
+  // One bit per differing letter (the lowest bit of its slot)
+  inline static Word MismatchBits( const Word a, const Word b,
+                                   const size_t numLetters );
+
+  inline static size_t PopCount( const Word word );
+  inline static size_t TrailingZeros( const Word word );
+
+  std::vector< Word > mWords;
+  size_t              mLength;
+  bool                mIsPacked;
+};
+
+/*
+ * Implementation
+ */
+template < typename A >
+const size_t PackedSequence< A >::NumBits;
+
+template < typename A >
+const size_t PackedSequence< A >::LettersPerWord;
+
+template < typename A >
+PackedSequence< A >::PackedSequence() : mLength( 0 ), mIsPacked( false ) {}
+
+template < typename A >
+PackedSequence< A >::PackedSequence( const Sequence< A >& sequence )
+    : mLength( sequence.Length() ),
+      mIsPacked( NumBits > 0 && BitMapPolicy< A >::PreservesMatches ) {
+  if( !mIsPacked )
+    return;
+
+  // One extra word, so WordAt never reads beyond the end
+  mWords.resize( mLength / LettersPerWord + 2, 0 );
+  for( size_t i = 0; i < mLength; i++ ) {
+    int8_t bits = BitMapPolicy< A >::BitMap( sequence[ i ] );
+    if( bits < 0 ) {
+      // Ambiguous letter
+      mIsPacked = false;
+      mWords.clear();
+      return;
+    }
+
+    mWords[ i / LettersPerWord ] |= Word( bits )
+                                    << ( ( i % LettersPerWord ) * NumBits );
+  }
+}
+
+template < typename A >
+bool PackedSequence< A >::IsPacked() const {
+  return mIsPacked;
+}
+
+template < typename A >
+size_t PackedSequence< A >::Length() const {
+  return mLength;
+}
+
+template < typename A >
+size_t PackedSequence< A >::NumMismatches( const PackedSequence< A >& other,
+                                           const size_t               pos,
+                                           const size_t otherPos,
+                                           const size_t length ) const {
+  assert( IsPacked() && other.IsPacked() );
+  assert( pos + length <= Length() && otherPos + length <= other.Length() );
+
+  size_t numMismatches = 0;
+  for( size_t i = 0; i < length; i += LettersPerWord ) {
+    size_t numLetters = std::min( LettersPerWord, length - i );
+    numMismatches += PopCount( MismatchBits(
+      WordAt( pos + i ), other.WordAt( otherPos + i ), numLetters ) );
+  }
+  return numMismatches;
+}
+
+template < typename A >
+template < typename Callback >
+void PackedSequence< A >::ForEachMismatch( const PackedSequence< A >& other,
+                                           const size_t               pos,
+                                           const size_t otherPos,
+                                           const size_t length,
+                                           const Callback& callback ) const {
+  assert( IsPacked() && other.IsPacked() );
+  assert( pos + length <= Length() && otherPos + length <= other.Length() );
+
+  for( size_t i = 0; i < length; i += LettersPerWord ) {
+    size_t numLetters = std::min( LettersPerWord, length - i );
+    Word   bits       = MismatchBits( WordAt( pos + i ),
+                              other.WordAt( otherPos + i ), numLetters );
+    while( bits ) {
+      callback( i + TrailingZeros( bits ) / NumBits );
+      bits &= bits - 1;
+    }
+  }
+}
+
+template < typename A >
+typename PackedSequence< A >::Word
+PackedSequence< A >::WordAt( const size_t pos ) const {
+  size_t index = pos / LettersPerWord;
+  size_t shift = ( pos % LettersPerWord ) * NumBits;
+
+  Word word = mWords[ index ] >> shift;
+  if( shift > 0 ) {
+    word |= mWords[ index + 1 ] << ( LettersPerWord * NumBits - shift );
+  }
+  return word;
+}
+
+template < typename A >
+typename PackedSequence< A >::Word
+PackedSequence< A >::MismatchBits( const Word a, const Word b,
+                                   const size_t numLetters ) {
+  Word diff = a ^ b;
+  for( size_t shift = 1; shift < NumBits; shift++ ) {
+    diff |= diff >> shift;
+  }
+  diff &= LowBits( LettersPerWord );
+
+  if( numLetters < LettersPerWord ) {
+    diff &= ( Word( 1 ) << ( numLetters * NumBits ) ) - 1;
+  }
+  return diff;
+}
+
+template < typename A >
+size_t PackedSequence< A >::PopCount( const Word word ) {
+#ifdef _MSC_VER
+  return __popcnt64( word );
+#else
+  return __builtin_popcountll( word );
+#endif
+}
+
+template < typename A >
+size_t PackedSequence< A >::TrailingZeros( const Word word ) {
+#ifdef _MSC_VER
+  unsigned long index;
+  _BitScanForward64( &index, word );
+  return index;
+#else
+  return __builtin_ctzll( word );
+#endif
+}
@@ -1,42 +1,189 @@
 #pragma once
 
 #include "../Sequence.h"
+#include "../Database/Kmers.h"
 #include "../FASTQ/QScore.h"
 #include "../Utils.h"
 
+#include <algorithm>
 #include <cassert>
-#include <cfloat>
+#include <cmath>
+#include <cstdint>
 #include <iostream>
+#include <vector>
+
+#if defined( __SSE2__ ) || defined( _M_X64 )
+#define NSEARCH_MERGER_SSE2 1
+#include <emmintrin.h>
+#endif
 
 namespace PairedEnd {
 // TODO: Find good defaults! Seem to stringent
 static const int    MERGER_DEFAULT_MIN_OVERLAP  = 16; // bases
 static const double MERGER_DEFAULT_MIN_IDENTITY = 0.9;
 
+// Overlaps are looked for where the reads share kmers of this length first
+static const int MERGER_SEED_LENGTH = 8; // bases
+
+// With a prior, the most common overlap lengths of the first pairs are tried
+// before anything else
+static const size_t MERGER_DEFAULT_PRIOR_PAIRS = 0; // none, no prior
+static const size_t MERGER_PRIOR_LENGTHS       = 4;
+
+/*
+ * What a base of an overlap adds to its score: the probability that the
+ * merged base is right (see FASTQ::QScore) for a match, minus that for a
+ * mismatch. In fixed point, indexed by match and the two phred scores
+ */
+class OverlapScores {
+public:
+  static const int Scale = 1 << 16;
+
+  int32_t Score( const bool match, const uint8_t q1, const uint8_t q2 ) const {
+    return mScores[ match ][ q1 ][ q2 ];
+  }
+
+  // Of a base, no overlap scores more than its length times this
+  int32_t MaxScore() const {
+    return mMaxScore;
+  }
+
+  static const OverlapScores& Instance() {
+    static const OverlapScores instance;
+    return instance;
+  }
+
+private:
+  OverlapScores() : mMaxScore( 0 ) {
+    using FASTQ::QScore;
+
+    const QScore& qscore = QScore::Instance();
+    for( int q1 = 0; q1 <= FASTQ::Q_MAX_SCORE; q1++ ) {
+      for( int q2 = 0; q2 <= FASTQ::Q_MAX_SCORE; q2++ ) {
+        double pm =
+          qscore.CalculatePosteriorErrorProbabilityForMatch( q1, q2 );
+        double pmm =
+          qscore.CalculatePosteriorErrorProbabilityForMismatch( q1, q2 );
+        mScores[ true ][ q1 ][ q2 ]  = lround( ( 1.0 - pm ) * Scale );
+        mScores[ false ][ q1 ][ q2 ] = -lround( ( 1.0 - pmm ) * Scale );
+        mMaxScore = std::max( mMaxScore, mScores[ true ][ q1 ][ q2 ] );
+      }
+    }
+  }
+
+  int32_t mScores[ 2 ][ FASTQ::Q_MAX_SCORE + 1 ][ FASTQ::Q_MAX_SCORE + 1 ];
+  int32_t mMaxScore;
+};
+
+// The reverse complement of a read, letter by letter without a copy
+template < typename Alphabet >
+class ReverseComplement {
+public:
+  ReverseComplement( const Sequence< Alphabet >& seq ) : mSeq( seq ) {}
+
+  size_t Length() const {
+    return mSeq.Length();
+  }
+
+  char Letter( const size_t index ) const {
+    return ComplementPolicy< Alphabet >::Complement(
+      mSeq.sequence[ Length() - 1 - index ] );
+  }
+
+  char Quality( const size_t index ) const {
+    return mSeq.quality[ Length() - 1 - index ];
+  }
+
+private:
+  const Sequence< Alphabet >& mSeq;
+};
+
+/*
+ * Keeps its buffers from pair to pair, so merging doesn't allocate once they
+ * have grown to the read length. Use one merger per thread.
+ *
+ * Amplicon pairs mostly overlap by the same few lengths. Given a number of
+ * prior pairs, the most common overlap lengths of those are tried first for
+ * the pairs after. If one of them overlaps, only the offsets which could
+ * still score higher (judged by their length) are scored on top, instead of
+ * seeding. The result is the best overlap of the full slide.
+ */
 template < typename Alphabet >
 class Merger {
 public:
-  Merger( const int    minOverlap  = MERGER_DEFAULT_MIN_OVERLAP,
-          const double minIdentity = MERGER_DEFAULT_MIN_IDENTITY );
+  Merger( const int    minOverlap    = MERGER_DEFAULT_MIN_OVERLAP,
+          const double minIdentity   = MERGER_DEFAULT_MIN_IDENTITY,
+          const size_t numPriorPairs = MERGER_DEFAULT_PRIOR_PAIRS );
+
+  // The merged read is written to merged, reusing its memory
   bool Merge( const Sequence< Alphabet >& fwd, const Sequence< Alphabet >& rev,
-              Sequence< Alphabet >* merged ) const;
+              Sequence< Alphabet >* merged );
+
+  // Number of merged pairs by overlap length
+  const std::vector< size_t >& OverlapLengths() const {
+    return mOverlapLengths;
+  }
+
+  // Most common first, empty until the prior pairs are merged
+  const std::vector< int >& PriorLengths() const {
+    return mPriorLengths;
+  }
 
 private:
   int    mMinOverlap;
   double mMinIdentity;
 
+  size_t                mNumPriorPairs, mNumPairs;
+  std::vector< size_t > mOverlapLengths;
+  std::vector< int >    mPriorLengths;
+
   typedef struct {
     size_t length;
     size_t pos1;
     size_t pos2;
   } OverlapInfo;
 
-  double ComputeOverlapScore( const char* sequence1, const char* sequence2,
-                              const char* quality1, const char* quality2,
-                              const size_t len ) const;
-  bool FindBestOverlap( const Sequence< Alphabet >& sequence1,
-                        const Sequence< Alphabet >& sequence2,
-                        OverlapInfo*                overlap ) const;
+  // A read prepared for scoring, see Prepare
+  struct ScoringInput {
+    const char*    sequence;
+    const uint8_t* letters;
+    const uint8_t* phred;
+  };
+
+  // Per pair, fwd as is and rev reverse complemented
+  std::basic_string< typename Alphabet::CharType > mSequence2;
+  std::vector< uint8_t > mLetters1, mLetters2, mPhred1, mPhred2;
+
+  // Seeding
+  std::vector< std::pair< Kmer, int > > mKmers2;
+  std::vector< bool >                   mVoted;
+  std::vector< int >                    mOffsets;
+
+  void    Prepare( const Sequence< Alphabet >& fwd,
+                   const Sequence< Alphabet >& rev );
+  int64_t ComputeOverlapScore( const ScoringInput& input1,
+                               const ScoringInput& input2,
+                               const size_t        len ) const;
+  bool    FindBestOverlap( const Sequence< Alphabet >& fwd,
+                           OverlapInfo*                overlap );
+  bool    FindSeededOffsets();
+  bool    FindPriorOverlap( const ScoringInput& input1,
+                            const ScoringInput& input2, int64_t* bestScore,
+                            OverlapInfo* overlap ) const;
+  void    LearnPrior();
+  void    ScoreOffset( const ScoringInput& input1, const int len1,
+                       const ScoringInput& input2, const int len2,
+                       const int offset, int64_t* bestScore,
+                       OverlapInfo* overlap ) const;
+
+  static int OverlapLength( const int len1, const int len2, const int offset );
+
+  template < typename Callback >
+  static void ForEachKmer( const std::vector< uint8_t >& letters,
+                           const size_t length, const Callback& callback );
+
+  static uint8_t LetterCode( const char letter );
+  static uint8_t PhredScore( const char quality );
   bool IsStaggered( const OverlapInfo& overlap ) const;
   void PrintOverlap( const Sequence< Alphabet >& seq1,
                      const Sequence< Alphabet >& seq2,
@@ -47,12 +194,14 @@ private:
  * Implementation
  */
 template < typename A >
-Merger< A >::Merger( const int minOverlap, const double minIdentity )
-    : mMinOverlap( minOverlap ), mMinIdentity( minIdentity ) {}
+Merger< A >::Merger( const int minOverlap, const double minIdentity,
+                     const size_t numPriorPairs )
+    : mMinOverlap( minOverlap ), mMinIdentity( minIdentity ),
+      mNumPriorPairs( numPriorPairs ), mNumPairs( 0 ) {}
 
 template < typename A >
 bool Merger< A >::Merge( const Sequence< A >& fwd, const Sequence< A >& rev,
-                         Sequence< A >* mergedOut ) const {
+                         Sequence< A >* merged ) {
 
   using FASTQ::QScore;
 
@@ -61,96 +210,186 @@ bool Merger< A >::Merge( const Sequence< A >& fwd, const Sequence< A >& rev,
   assert( fwd.quality.length() == fwd.sequence.length() );
   assert( rev.quality.length() == rev.sequence.length() );
 
-  Sequence< A > seq1 = fwd;
-  Sequence< A > seq2 = rev.Reverse().Complement();
+  Prepare( fwd, rev );
+
+  mNumPairs++;
+  bool found = FindBestOverlap( fwd, &overlap );
+  if( found ) {
+    if( overlap.length >= mOverlapLengths.size() )
+      mOverlapLengths.resize( overlap.length + 1, 0 );
+    mOverlapLengths[ overlap.length ]++;
+  }
 
-  if( !FindBestOverlap( seq1, seq2, &overlap ) )
+  if( mNumPairs == mNumPriorPairs )
+    LearnPrior();
+
+  if( !found )
     return false;
 
-  Sequence< A > merged = seq1.Subsequence( 0, overlap.length );
+  // AAA
+  //  BBB -> AMMB (nonstaggered)
+  //
+  //  AAA
+  // BBB  -> MM (staggered)
+  size_t left = 0, right = 0;
+  if( !IsStaggered( overlap ) ) {
+    left  = overlap.pos1;
+    right = mSequence2.size() - overlap.length;
+  }
+
+  merged->identifier = fwd.identifier;
+  merged->sequence.resize( left + overlap.length + right );
+  merged->quality.resize( left + overlap.length + right );
 
-  for( int i = 0; i < overlap.length; i++ ) {
-    char s1 = seq1.sequence[ overlap.pos1 + i ];
-    char s2 = seq2.sequence[ overlap.pos2 + i ];
+  std::copy( fwd.sequence.begin(), fwd.sequence.begin() + left,
+             merged->sequence.begin() );
+  std::copy( fwd.quality.begin(), fwd.quality.begin() + left,
+             merged->quality.begin() );
+
+  for( size_t i = 0; i < overlap.length; i++ ) {
+    char s1 = fwd.sequence[ overlap.pos1 + i ];
+    char s2 = mSequence2[ overlap.pos2 + i ];
 
-    int q1 = seq1.quality[ overlap.pos1 + i ] - FASTQ::Q_MIN_ASCII_BASE;
-    int q2 = seq2.quality[ overlap.pos2 + i ] - FASTQ::Q_MIN_ASCII_BASE;
+    int q1 = mPhred1[ overlap.pos1 + i ];
+    int q2 = mPhred2[ overlap.pos2 + i ];
 
     if( q1 >= q2 ) {
       // Call X as merged base
-      merged.sequence[ i ] = s1;
+      merged->sequence[ left + i ] = s1;
     } else {
       // Call Y as merged base
-      merged.sequence[ i ] = s2;
+      merged->sequence[ left + i ] = s2;
     }
 
     if( MatchPolicy< A >::Match( s1, s2 ) ) {
-      merged.quality[ i ] =
+      merged->quality[ left + i ] =
         FASTQ::Q_MIN_ASCII_BASE +
         QScore::Instance().CalculatePosteriorScoreForMatch( q1, q2 );
     } else {
-      merged.quality[ i ] =
+      merged->quality[ left + i ] =
         FASTQ::Q_MIN_ASCII_BASE +
         QScore::Instance().CalculatePosteriorScoreForMismatch( q1, q2 );
     }
   }
 
-  // AAA
-  //  BBB -> AMMB (nonstaggered)
-  //
-  //  AAA
-  // BBB  -> MM (staggered)
-  if( !IsStaggered( overlap ) ) {
-    Sequence< A > leftOverhang  = seq1.Subsequence( 0, overlap.pos1 );
-    Sequence< A > rightOverhang = seq2.Subsequence( overlap.length );
-
-    merged = leftOverhang + merged + rightOverhang;
+  ReverseComplement< A > seq2( rev );
+  for( size_t i = 0; i < right; i++ ) {
+    merged->sequence[ left + overlap.length + i ] =
+      mSequence2[ overlap.length + i ];
+    merged->quality[ left + overlap.length + i ] =
+      seq2.Quality( overlap.length + i );
   }
 
-  /* std::cout << seq1.identifier << std::endl; */
-  /* PrintOverlap( seq1, seq2, overlap ); */
+  /* std::cout << fwd.identifier << std::endl; */
+  /* PrintOverlap( fwd, rev.Reverse().Complement(), overlap ); */
 
-  /* std::cout << merged.sequence << std::endl; */
-  /* std::cout << merged.quality << std::endl; */
-  /* std::cout << string( merged.sequence.length(), '-' ) << std::endl; */
+  /* std::cout << merged->sequence << std::endl; */
+  /* std::cout << merged->quality << std::endl; */
+  /* std::cout << string( merged->sequence.length(), '-' ) << std::endl; */
 
-  *mergedOut = std::move( merged );
   return true;
 }
 
 template < typename A >
-double Merger< A >::ComputeOverlapScore( const char*  sequence1,
-                                         const char*  sequence2,
-                                         const char*  quality1,
-                                         const char*  quality2,
-                                         const size_t len ) const {
-  using FASTQ::QScore;
+void Merger< A >::Prepare( const Sequence< A >& fwd,
+                           const Sequence< A >& rev ) {
+  size_t len1 = fwd.Length();
+  mLetters1.resize( len1 );
+  mPhred1.resize( len1 );
+  for( size_t i = 0; i < len1; i++ ) {
+    mLetters1[ i ] = LetterCode( fwd.sequence[ i ] );
+    mPhred1[ i ]   = PhredScore( fwd.quality[ i ] );
+  }
+
+  ReverseComplement< A > seq2( rev );
+  size_t                 len2 = seq2.Length();
+  mSequence2.resize( len2 );
+  mLetters2.resize( len2 );
+  mPhred2.resize( len2 );
+  for( size_t i = 0; i < len2; i++ ) {
+    mSequence2[ i ] = seq2.Letter( i );
+    mLetters2[ i ]  = LetterCode( mSequence2[ i ] );
+    mPhred2[ i ]    = PhredScore( seq2.Quality( i ) );
+  }
+}
 
-  double score = 0.0;
+// The letter as bits (see BitMapPolicy), which are equal if and only if the
+// letters match (given PreservesMatches). Other letters get the high bit and
+// are matched one by one
+template < typename A >
+uint8_t Merger< A >::LetterCode( const char letter ) {
+  int8_t bits = BitMapPolicy< A >::BitMap( letter );
+  return bits < 0 ? 0x80 : bits;
+}
+
+// Clamped to the range QScore knows
+template < typename A >
+uint8_t Merger< A >::PhredScore( const char quality ) {
+  int q = quality - FASTQ::Q_MIN_ASCII_BASE;
+  return std::min( std::max( q, 0 ), FASTQ::Q_MAX_SCORE );
+}
+
+#ifdef NSEARCH_MERGER_SSE2
+inline int PopCount16( const int bits ) {
+#ifdef _MSC_VER
+  return __popcnt( bits );
+#else
+  return __builtin_popcount( bits );
+#endif
+}
+#endif
+
+/*
+ * Sum of OverlapScores, 0 once the mismatches exceed the identity
+ * threshold. Letters are compared 16 at a time and the mismatches of those
+ * counted before their scores are looked up, so most offsets are given up
+ * after a few comparisons.
+ */
+template < typename A >
+int64_t Merger< A >::ComputeOverlapScore( const ScoringInput& input1,
+                                          const ScoringInput& input2,
+                                          const size_t        len ) const {
+  const OverlapScores& scores = OverlapScores::Instance();
+
+  int64_t score = 0;
 
   size_t numMismatches = 0;
   size_t maxMismatches = len - size_t( len * mMinIdentity );
 
-  for( int i = 0; i < len; i++ ) {
-    if( MatchPolicy< A >::Match( sequence1[ i ], sequence2[ i ] ) ) {
-      score +=
-        ( 1.0 - QScore::Instance().CalculatePosteriorErrorProbabilityForMatch(
-                  quality1[ i ], quality2[ i ] ) );
-    } else {
-      score -=
-        ( 1.0 -
-          QScore::Instance().CalculatePosteriorErrorProbabilityForMismatch(
-            quality1[ i ], quality2[ i ] ) );
-
-      numMismatches++;
-      if( numMismatches > maxMismatches ) {
-        score = DBL_MIN;
-        break;
-      }
+  size_t i = 0;
+#ifdef NSEARCH_MERGER_SSE2
+  for( ; BitMapPolicy< A >::PreservesMatches && i + 16 <= len; i += 16 ) {
+    __m128i a = _mm_loadu_si128( ( const __m128i* ) ( input1.letters + i ) );
+    __m128i b = _mm_loadu_si128( ( const __m128i* ) ( input2.letters + i ) );
+
+    int ambiguous = _mm_movemask_epi8( _mm_or_si128( a, b ) );
+    int matches   = _mm_movemask_epi8( _mm_cmpeq_epi8( a, b ) ) & ~ambiguous;
+    for( int j = 0; ambiguous != 0 && j < 16; j++ ) {
+      if( ( ambiguous >> j ) & 1 &&
+          MatchPolicy< A >::Match( input1.sequence[ i + j ],
+                                   input2.sequence[ i + j ] ) )
+        matches |= 1 << j;
+    }
+
+    numMismatches += 16 - PopCount16( matches );
+    if( numMismatches > maxMismatches )
+      return 0;
+
+    for( int j = 0; j < 16; j++ ) {
+      score += scores.Score( ( matches >> j ) & 1, input1.phred[ i + j ],
+                             input2.phred[ i + j ] );
     }
   }
+#endif
+
+  for( ; i < len; i++ ) {
+    bool match =
+      MatchPolicy< A >::Match( input1.sequence[ i ], input2.sequence[ i ] );
+    score += scores.Score( match, input1.phred[ i ], input2.phred[ i ] );
+    numMismatches += !match;
+  }
 
-  return score;
+  return numMismatches > maxMismatches ? 0 : score;
 }
 
 /*
@@ -176,42 +415,215 @@ double Merger< A >::ComputeOverlapScore( const char*  sequence1,
  * i = 5 AAA
  * BB
  *
+ * Only the offsets seeded by shared kmers are scored. The full slide is
+ * the fallback if none of them overlaps well enough.
  */
 template < typename A >
-bool Merger< A >::FindBestOverlap( const Sequence< A >& seq1,
-                                   const Sequence< A >& seq2,
-                                   OverlapInfo*         overlap ) const {
-  int len1 = seq1.Length();
-  int len2 = seq2.Length();
+bool Merger< A >::FindBestOverlap( const Sequence< A >& fwd,
+                                   OverlapInfo*         overlap ) {
+  int len1 = mLetters1.size();
+  int len2 = mLetters2.size();
 
   overlap->length = 0;
   overlap->pos1   = 0;
   overlap->pos2   = 0;
 
-  double bestScore = DBL_MIN;
+  // Only positive scores count
+  int64_t bestScore = 0;
+
+  ScoringInput input1 = { fwd.sequence.data(), mLetters1.data(),
+                          mPhred1.data() };
+  ScoringInput input2 = { mSequence2.data(), mLetters2.data(),
+                          mPhred2.data() };
+
+  if( FindPriorOverlap( input1, input2, &bestScore, overlap ) )
+    return true;
+
+  if( FindSeededOffsets() ) {
+    for( int i : mOffsets ) {
+      ScoreOffset( input1, len1, input2, len2, i, &bestScore, overlap );
+    }
+  }
 
   // Slide base by base, finding best overlap
+  if( bestScore <= 0 ) {
+    for( int i = 0; i <= len1 + len2; i++ ) {
+      ScoreOffset( input1, len1, input2, len2, i, &bestScore, overlap );
+    }
+  }
+
+  return ( bestScore > 0 );
+}
+
+/*
+ * Scores the offsets of the prior lengths, either way the reads can overlap
+ * by them. Given an overlap, the other offsets are scored only if they are
+ * long enough to score as high
+ */
+template < typename A >
+bool Merger< A >::FindPriorOverlap( const ScoringInput& input1,
+                                    const ScoringInput& input2,
+                                    int64_t*            bestScore,
+                                    OverlapInfo*        overlap ) const {
+  int len1 = mLetters1.size();
+  int len2 = mLetters2.size();
+
+  for( int length : mPriorLengths ) {
+    // fwd ends within rev, or rev starts before fwd (staggered)
+    ScoreOffset( input1, len1, input2, len2, length, bestScore, overlap );
+    if( len1 + len2 - length != length ) {
+      ScoreOffset( input1, len1, input2, len2, len1 + len2 - length,
+                   bestScore, overlap );
+    }
+  }
+
+  if( *bestScore <= 0 )
+    return false;
+
+  const int64_t maxScore = OverlapScores::Instance().MaxScore();
   for( int i = 0; i <= len1 + len2; i++ ) {
-    int pos1 = std::max( len1 - i, 0 );
-    int pos2 = std::max( i - len1, 0 );
-
-    int length = std::min( len2 - pos2, i );
-    if( length < mMinOverlap )
-      continue;
-
-    double score = ComputeOverlapScore(
-      seq1.sequence.c_str() + pos1, seq2.sequence.c_str() + pos2,
-      seq1.quality.c_str() + pos1, seq2.quality.c_str() + pos2, length );
-
-    if( score > bestScore ) {
-      bestScore       = score;
-      overlap->length = length;
-      overlap->pos1   = pos1;
-      overlap->pos2   = pos2;
+    if( OverlapLength( len1, len2, i ) * maxScore >= *bestScore )
+      ScoreOffset( input1, len1, input2, len2, i, bestScore, overlap );
+  }
+
+  return true;
+}
+
+// The prior lengths, once the prior pairs are merged
+template < typename A >
+void Merger< A >::LearnPrior() {
+  mPriorLengths.clear();
+  for( size_t length = 0; length < mOverlapLengths.size(); length++ ) {
+    if( mOverlapLengths[ length ] > 0 )
+      mPriorLengths.push_back( length );
+  }
+
+  std::stable_sort( mPriorLengths.begin(), mPriorLengths.end(),
+                    [this]( const int a, const int b ) {
+                      return mOverlapLengths[ a ] > mOverlapLengths[ b ];
+                    } );
+  if( mPriorLengths.size() > MERGER_PRIOR_LENGTHS )
+    mPriorLengths.resize( MERGER_PRIOR_LENGTHS );
+}
+
+/*
+ * Kmers of letter codes, like Kmers but without a Sequence. Windows with a
+ * letter without code give AmbiguousKmer
+ */
+template < typename A >
+template < typename Callback >
+void Merger< A >::ForEachKmer( const std::vector< uint8_t >& letters,
+                               const size_t                  length,
+                               const Callback&               callback ) {
+  const size_t numBits = BitMapPolicy< A >::NumBits;
+  const Kmer   mask    = length * numBits >= sizeof( Kmer ) * 8
+                      ? AmbiguousKmer
+                      : ( Kmer( 1 ) << ( length * numBits ) ) - 1;
+
+  Kmer   kmer  = 0;
+  size_t clear = 0; // first position of a window without ambiguous letters
+  for( size_t i = 0; i < letters.size(); i++ ) {
+    uint8_t code = letters[ i ];
+    if( code & 0x80 ) {
+      clear = i + 1;
+      code  = 0;
+    }
+    kmer = ( ( kmer << numBits ) | code ) & mask;
+
+    if( i + 1 >= length ) {
+      size_t pos = i + 1 - length;
+      callback( pos >= clear ? kmer : AmbiguousKmer, pos );
     }
   }
+}
 
-  return ( bestScore > DBL_MIN );
+/*
+ * Votes for the offsets (diagonals) on which the reads share a kmer.
+ * Offset i aligns position p of seq1 with position q of seq2 if
+ * i = len1 - p + q. The offsets voted for are sorted ascending, like the
+ * slide visits them
+ */
+template < typename A >
+bool Merger< A >::FindSeededOffsets() {
+  const int numBits    = BitMapPolicy< A >::NumBits;
+  const int seedLength = std::min(
+    { MERGER_SEED_LENGTH, std::max( mMinOverlap, 1 ),
+      numBits > 0 ? int( sizeof( Kmer ) * 8 ) / numBits : 0 } );
+
+  int len1 = mLetters1.size();
+  int len2 = mLetters2.size();
+
+  if( seedLength == 0 || len1 < seedLength || len2 < seedLength )
+    return false;
+
+  // Kmers of seq2, sorted by kmer and then position
+  mKmers2.clear();
+  ForEachKmer( mLetters2, seedLength,
+               [this]( const Kmer kmer, const size_t pos ) {
+                 if( kmer != AmbiguousKmer )
+                   mKmers2.emplace_back( kmer, pos );
+               } );
+  std::sort( mKmers2.begin(), mKmers2.end() );
+
+  mVoted.assign( len1 + len2 + 1, false );
+  bool any = false;
+  ForEachKmer( mLetters1, seedLength,
+               [&]( const Kmer kmer, const size_t pos ) {
+                 if( kmer == AmbiguousKmer )
+                   return;
+
+                 auto it = std::lower_bound( mKmers2.begin(), mKmers2.end(),
+                                             std::make_pair( kmer, 0 ) );
+                 for( ; it != mKmers2.end() && it->first == kmer; ++it ) {
+                   mVoted[ len1 - int( pos ) + it->second ] = true;
+                   any = true;
+                 }
+               } );
+
+  mOffsets.clear();
+  for( int i = 0; any && i <= len1 + len2; i++ ) {
+    if( mVoted[ i ] )
+      mOffsets.push_back( i );
+  }
+
+  return any;
+}
+
+template < typename A >
+void Merger< A >::ScoreOffset( const ScoringInput& input1, const int len1,
+                               const ScoringInput& input2, const int len2,
+                               const int i, int64_t* bestScore,
+                               OverlapInfo* overlap ) const {
+  int pos1   = std::max( len1 - i, 0 );
+  int pos2   = std::max( i - len1, 0 );
+  int length = OverlapLength( len1, len2, i );
+  if( length < mMinOverlap )
+    return;
+
+  ScoringInput at1 = { input1.sequence + pos1, input1.letters + pos1,
+                       input1.phred + pos1 };
+  ScoringInput at2 = { input2.sequence + pos2, input2.letters + pos2,
+                       input2.phred + pos2 };
+
+  // Ties go to the lower offset, the one the slide visits first
+  int64_t score = ComputeOverlapScore( at1, at2, length );
+  int     best  = len1 - int( overlap->pos1 ) + int( overlap->pos2 );
+  if( score > *bestScore ||
+      ( score > 0 && score == *bestScore && i < best ) ) {
+    *bestScore      = score;
+    overlap->length = length;
+    overlap->pos1   = pos1;
+    overlap->pos2   = pos2;
+  }
+}
+
+// Within both reads, also if rev is the longer one
+template < typename A >
+int Merger< A >::OverlapLength( const int len1, const int len2,
+                                const int offset ) {
+  int pos1 = std::max( len1 - offset, 0 );
+  int pos2 = std::max( offset - len1, 0 );
+  return std::min( len2 - pos2, len1 - pos1 );
 }
 
 template < typename A >
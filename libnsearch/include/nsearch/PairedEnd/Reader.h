@@ -3,20 +3,30 @@
 #include "../FASTQ/Reader.h"
 #include "../Sequence.h"
 
+#include <memory>
+
 namespace PairedEnd {
 
 template < typename Alphabet >
 class Reader {
 private:
-  FASTQ::Reader< Alphabet > mFwdReader;
-  FASTQ::Reader< Alphabet > mRevReader;
+  using SequenceReaderPtr = std::unique_ptr< SequenceReader< Alphabet > >;
+
+  SequenceReaderPtr mFwdReader;
+  SequenceReaderPtr mRevReader;
 
 public:
   Reader( const std::string& pathToFwdFile, const std::string& pathToRevFile )
-      : mFwdReader( pathToFwdFile ), mRevReader( pathToRevFile ) {}
+      : mFwdReader( new FASTQ::Reader< Alphabet >( pathToFwdFile ) ),
+        mRevReader( new FASTQ::Reader< Alphabet >( pathToRevFile ) ) {}
 
   Reader( std::istream& fwd, std::istream& rev )
-      : mFwdReader( fwd ), mRevReader( rev ) {}
+      : mFwdReader( new FASTQ::Reader< Alphabet >( fwd ) ),
+        mRevReader( new FASTQ::Reader< Alphabet >( rev ) ) {}
+
+  // Any format, e.g. NSB
+  Reader( SequenceReaderPtr fwd, SequenceReaderPtr rev )
+      : mFwdReader( std::move( fwd ) ), mRevReader( std::move( rev ) ) {}
 
   void Read( const int count, SequenceList< Alphabet >* fwds,
              SequenceList< Alphabet >* revs ) {
@@ -32,25 +42,19 @@ public:
   }
 
   bool Read( Sequence< Alphabet >* fwd, Sequence< Alphabet >* rev ) {
-    if( EndOfFile() )
-      return false;
-
-    mFwdReader >> *fwd;
-    mRevReader >> *rev;
-
-    return true;
+    return mFwdReader->Read( fwd ) && mRevReader->Read( rev );
   }
 
   bool EndOfFile() const {
-    return mFwdReader.EndOfFile() || mRevReader.EndOfFile();
+    return mFwdReader->EndOfFile() || mRevReader->EndOfFile();
   }
 
   std::streampos NumBytesRead() const {
-    return mFwdReader.NumBytesRead() + mRevReader.NumBytesRead();
+    return mFwdReader->NumBytesRead() + mRevReader->NumBytesRead();
   }
 
   std::streampos NumBytesTotal() const {
-    return mFwdReader.NumBytesTotal() + mRevReader.NumBytesTotal();
+    return mFwdReader->NumBytesTotal() + mRevReader->NumBytesTotal();
   }
 };
 
@@ -0,0 +1,140 @@
+#pragma once
+
+#include "Sequence.h"
+#include "TextReader.h"
+#include "Utils.h"
+
+#include <string>
+#include <vector>
+
+/*
+ * Records parsed in bulk. Identifiers, sequences and qualities of all records
+ * live in three contiguous arenas, record i spans [offsets[i], offsets[i+1]).
+ * Clearing keeps the memory, so a reused batch stops allocating.
+ */
+class RecordBatch {
+public:
+  RecordBatch() {
+    Clear();
+  }
+
+  size_t Size() const {
+    return mSequenceOffsets.size() - 1;
+  }
+
+  bool Empty() const {
+    return Size() == 0;
+  }
+
+  void Clear() {
+    mIdentifiers.clear();
+    mSequences.clear();
+    mQualities.clear();
+
+    mIdentifierOffsets.assign( 1, 0 );
+    mSequenceOffsets.assign( 1, 0 );
+    mQualityOffsets.assign( 1, 0 );
+  }
+
+  // A record is built by BeginRecord, Append* (line by line) and EndRecord
+  void BeginRecord( const LineView& identifier ) {
+    mIdentifiers.append( identifier.data, identifier.length );
+    mIdentifierOffsets.push_back( mIdentifiers.size() );
+  }
+
+  void AppendSequence( const LineView& line ) {
+    mSequences.append( line.data, line.length );
+  }
+
+  void AppendQuality( const LineView& line ) {
+    mQualities.append( line.data, line.length );
+  }
+
+  // Upcases the whole record at once (atc -> ATC)
+  void EndRecord() {
+    size_t sequenceStart = mSequenceOffsets.back();
+    Upcase( &mSequences[ 0 ] + sequenceStart,
+            mSequences.size() - sequenceStart );
+    mSequenceOffsets.push_back( mSequences.size() );
+
+    size_t qualityStart = mQualityOffsets.back();
+    Upcase( &mQualities[ 0 ] + qualityStart, mQualities.size() - qualityStart );
+    mQualityOffsets.push_back( mQualities.size() );
+  }
+
+  // Record with a sequence of length letters, which the caller writes
+  // (upcased) into the returned buffer before changing the batch again
+  char* AddRecord( const LineView& identifier, const size_t length,
+                   const LineView& quality ) {
+    BeginRecord( identifier );
+    size_t sequenceStart = mSequences.size();
+    mSequences.resize( sequenceStart + length );
+    mSequenceOffsets.push_back( mSequences.size() );
+    AppendQuality( quality );
+    mQualityOffsets.push_back( mQualities.size() );
+    return &mSequences[ 0 ] + sequenceStart;
+  }
+
+  // Copies record index of other
+  void Add( const RecordBatch& other, const size_t index ) {
+    BeginRecord( other.IdentifierAt( index ) );
+    AppendSequence( other.SequenceAt( index ) );
+    AppendQuality( other.QualityAt( index ) );
+    mSequenceOffsets.push_back( mSequences.size() );
+    mQualityOffsets.push_back( mQualities.size() );
+  }
+
+  // Copies all records of other
+  void Append( const RecordBatch& other ) {
+    Append( &mIdentifiers, &mIdentifierOffsets, other.mIdentifiers,
+            other.mIdentifierOffsets );
+    Append( &mSequences, &mSequenceOffsets, other.mSequences,
+            other.mSequenceOffsets );
+    Append( &mQualities, &mQualityOffsets, other.mQualities,
+            other.mQualityOffsets );
+  }
+
+  // Views into the arenas, valid until the batch is changed
+  LineView IdentifierAt( const size_t index ) const {
+    return View( mIdentifiers, mIdentifierOffsets, index );
+  }
+
+  LineView SequenceAt( const size_t index ) const {
+    return View( mSequences, mSequenceOffsets, index );
+  }
+
+  LineView QualityAt( const size_t index ) const {
+    return View( mQualities, mQualityOffsets, index );
+  }
+
+  template < typename Alphabet >
+  void Get( const size_t index, Sequence< Alphabet >* seq ) const {
+    LineView view = IdentifierAt( index );
+    seq->identifier.assign( view.data, view.length );
+    view = SequenceAt( index );
+    seq->sequence.assign( view.data, view.length );
+    view = QualityAt( index );
+    seq->quality.assign( view.data, view.length );
+  }
+
+private:
+  static LineView View( const std::string&           arena,
+                        const std::vector< size_t >& offsets,
+                        const size_t                 index ) {
+    return LineView( arena.data() + offsets[ index ],
+                     offsets[ index + 1 ] - offsets[ index ] );
+  }
+
+  static void Append( std::string* arena, std::vector< size_t >* offsets,
+                      const std::string&           otherArena,
+                      const std::vector< size_t >& otherOffsets ) {
+    size_t shift = arena->size();
+    arena->append( otherArena );
+    for( size_t i = 1; i < otherOffsets.size(); i++ ) {
+      offsets->push_back( otherOffsets[ i ] + shift );
+    }
+  }
+
+  std::string           mIdentifiers, mSequences, mQualities;
+  std::vector< size_t > mIdentifierOffsets, mSequenceOffsets, mQualityOffsets;
+};
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "RecordBatch.h"
+#include "TextReader.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+/*
+ * Format specific parsing of raw text into records. Parsers are stateless, so
+ * one parser can be used by several threads at once.
+ */
+class RecordParser {
+public:
+  // Parses the complete records at the beginning of data into batch and
+  // returns the number of bytes consumed. At the end of the file, all of data
+  // is consumed
+  virtual size_t Parse( const char* data, const size_t size,
+                        const bool endOfFile, RecordBatch* batch ) const = 0;
+
+  // Start of the first record in data, which is a chunk cut anywhere out of
+  // a file (startsLine tells whether a line begins right at data). size if
+  // there is none (or it can't be told from data alone)
+  virtual size_t FindRecordStart( const char* data, const size_t size,
+                                  const bool startsLine ) const = 0;
+
+  virtual ~RecordParser() = default;
+
+protected:
+  // Next non-blank line starting at *pos. False if there is none, or if it is
+  // cut off (no '\n' yet and not at the end of the file)
+  static bool NextLine( const char* data, const size_t size, size_t* pos,
+                        const bool endOfFile, LineView* line ) {
+    while( *pos < size ) {
+      const char* start = data + *pos;
+      const char* end   = ( const char* ) memchr( start, '\n', size - *pos );
+      if( end == NULL ) {
+        if( !endOfFile )
+          return false;
+
+        end = data + size;
+      }
+
+      *pos = std::min( size_t( end - data ) + 1, size ); // skip '\n'
+      bool blank = std::all_of( start, end, []( const char ch ) {
+        return isspace( ( unsigned char ) ch );
+      } );
+      if( !blank ) {
+        *line = LineView( start, end - start );
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Start of the first full line in data
+  static size_t FirstLineStart( const char* data, const size_t size,
+                                const bool startsLine ) {
+    if( startsLine )
+      return 0;
+
+    const char* end = ( const char* ) memchr( data, '\n', size );
+    return end ? end - data + 1 : size;
+  }
+};
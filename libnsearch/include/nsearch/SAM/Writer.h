@@ -0,0 +1,163 @@
+#pragma once
+
+#include "../Database/HitWriter.h"
+
+#include "../Alphabet/DNA.h"
+
+#include <cstdint>
+#include <string>
+
+namespace SAM {
+
+// QNAME and RNAME end at the first whitespace
+inline std::string Name( const std::string& identifier ) {
+  auto name = identifier.substr( 0, identifier.find_first_of( " \t" ) );
+  return name.empty() ? "*" : name;
+}
+
+template < typename Alphabet >
+std::string Header( const SequenceList< Alphabet >& targets ) {
+  std::string header = "@HD\tVN:1.6\tSO:unsorted\n";
+  for( auto& target : targets ) {
+    header += "@SQ\tSN:" + Name( target.identifier ) +
+              "\tLN:" + std::to_string( target.Length() ) + "\n";
+  }
+  header += "@PG\tID:nsearch\tPN:nsearch\n";
+  return header;
+}
+
+/*
+ * A hit in SAM terms. Terminal gaps in the target are left out (shifting
+ * pos), terminal gaps in the query become soft clips. On the minus strand,
+ * the reverse complemented query is stored, like the alignment refers to.
+ */
+template < typename Alphabet >
+class Record {
+public:
+  static const uint16_t FlagReverse   = 0x10;
+  static const uint16_t FlagSecondary = 0x100;
+
+  uint16_t             flag      = 0;
+  size_t               pos       = 0; // 0-based, on the target
+  size_t               clipStart = 0, clipEnd = 0;
+  Cigar                cigar; // between the clips, starts and ends with =/X
+  Sequence< Alphabet > query;
+
+  Record( const Sequence< Alphabet >& query, const Hit< Alphabet >& hit,
+          const bool secondary )
+      : cigar( hit.alignment ) {
+    if( IsMinusStrand( hit ) ) {
+      flag |= FlagReverse;
+      this->query = query.Reverse().Complement();
+    } else {
+      this->query = query;
+    }
+
+    if( secondary )
+      flag |= FlagSecondary;
+
+    while( !cigar.empty() && IsGap( cigar.front() ) ) {
+      if( cigar.front().op == CigarOp::Insertion ) {
+        clipStart += cigar.front().count;
+      } else {
+        pos += cigar.front().count;
+      }
+      cigar.pop_front();
+    }
+
+    while( !cigar.empty() && IsGap( cigar.back() ) ) {
+      if( cigar.back().op == CigarOp::Insertion ) {
+        clipEnd += cigar.back().count;
+      }
+      cigar.pop_back();
+    }
+  }
+
+  // Edit distance (NM tag)
+  size_t NumDifferences() const {
+    return cigar.NumDifferences();
+  }
+
+  // Number of target letters covered
+  size_t TargetLength() const {
+    size_t length = 0;
+    for( const CigarEntry& c : cigar ) {
+      if( c.op != CigarOp::Insertion )
+        length += c.count;
+    }
+    return length;
+  }
+
+private:
+  static bool IsGap( const CigarEntry& entry ) {
+    return entry.op == CigarOp::Insertion || entry.op == CigarOp::Deletion;
+  }
+
+  static inline bool IsMinusStrand( const Hit< Alphabet >& hit ) {
+    return false;
+  }
+};
+
+template <>
+inline bool Record< DNA >::IsMinusStrand( const Hit< DNA >& hit ) {
+  return hit.strand == DNA::Strand::Minus;
+}
+
+/*
+ * One line per hit, the best hit of a query is the primary alignment.
+ * The header lists the targets if given (see WriteHeader).
+ */
+template < typename Alphabet >
+class Writer : public HitWriter< Alphabet > {
+public:
+  using HitWriter< Alphabet >::HitWriter;
+
+  void WriteHeader( const SequenceList< Alphabet >& targets ) {
+    this->mOutput << Header( targets );
+    mWroteHeader = true;
+  }
+
+  HitWriter< Alphabet >&
+  operator<<( const QueryHitsPair< Alphabet >& queryWithHits ) {
+    const auto& query = queryWithHits.first;
+    const auto& hits  = queryWithHits.second;
+
+    auto& out = this->mOutput;
+
+    if( !mWroteHeader ) {
+      WriteHeader( {} );
+    }
+
+    auto queryName = Name( query.identifier );
+    for( size_t i = 0; i < hits.size(); i++ ) {
+      const auto&        hit = hits[ i ];
+      Record< Alphabet > record( query, hit, i > 0 );
+
+      out << queryName << '\t' << record.flag << '\t'
+          << Name( hit.target.identifier ) << '\t' << record.pos + 1 << '\t'
+          << "255" << '\t';
+
+      // CIGAR
+      if( record.clipStart > 0 )
+        out << record.clipStart << 'S';
+      out << record.cigar;
+      if( record.clipEnd > 0 )
+        out << record.clipEnd << 'S';
+
+      // RNEXT, PNEXT, TLEN
+      out << "\t*\t0\t0\t";
+
+      out << ( record.query.sequence.empty() ? "*" : record.query.sequence )
+          << '\t'
+          << ( record.query.quality.empty() ? "*" : record.query.quality )
+          << '\t' << "NM:i:" << record.NumDifferences() << '\n';
+    }
+
+    return *this;
+  }
+
+private:
+  bool mWroteHeader = false;
+};
+
+} // namespace SAM
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * Where each record of a FASTA/FASTQ file starts, like faidx (.fai) but with
+ * the offset of the record itself, so a range of records can be read (and
+ * parsed) without touching the rest of the file (see TextSequenceReader).
+ * Offsets are in the uncompressed text, compressed files are inflated up to
+ * the range.
+ *
+ * The sidecar file (PathFor) starts with '#' and the size of the text,
+ * followed by a tab-separated line per record: name, length, offset,
+ * sequence offset, line bases, line width, quality offset. Line bases and
+ * width describe the sequence lines (letters and bytes per line, all but the
+ * last line alike), both are 0 if the lines aren't alike. The quality offset
+ * is 0 for FASTA.
+ */
+class SequenceIndex {
+public:
+  struct Record {
+    std::string name; // identifier up to the first whitespace
+    size_t      length;
+    size_t      offset, sequenceOffset;
+    size_t      lineBases, lineWidth;
+    size_t      qualityOffset;
+  };
+
+  static std::string PathFor( const std::string& pathToFile ) {
+    return pathToFile + ".nsi";
+  }
+
+  // Scans the file once. False if it isn't FASTA/FASTQ (or empty)
+  bool Build( const std::string& pathToFile );
+
+  bool Read( const std::string& pathToIndex );
+  bool Write( const std::string& pathToIndex ) const;
+
+  size_t Size() const {
+    return mRecords.size();
+  }
+
+  const Record& operator[]( const size_t index ) const {
+    return mRecords[ index ];
+  }
+
+  // Index of the first record named name, Size() if there is none
+  size_t Find( const std::string& name ) const {
+    auto it = mNames.find( name );
+    return it != mNames.end() ? it->second : Size();
+  }
+
+  // Where record index starts, the end of the text for Size()
+  size_t ByteOffset( const size_t index ) const {
+    return index < Size() ? mRecords[ index ].offset : mNumBytes;
+  }
+
+  size_t NumBytes() const {
+    return mNumBytes;
+  }
+
+private:
+  void Clear();
+  void Add( const Record& record );
+
+  std::vector< Record >                     mRecords;
+  std::unordered_map< std::string, size_t > mNames;
+  size_t                                    mNumBytes = 0;
+};
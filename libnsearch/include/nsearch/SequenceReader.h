@@ -1,45 +1,202 @@
 #pragma once
 
+#include "ChunkParser.h"
+#include "RecordBatch.h"
+#include "RecordParser.h"
 #include "Sequence.h"
+#include "SequenceIndex.h"
 #include "TextReader.h"
 #include "Utils.h"
 
+#include <algorithm>
 #include <memory>
+#include <thread>
 
+/*
+ * Records are read in batches (see RecordBatch) and handed out one by one or
+ * batch by batch. Formats implement ReadBatch.
+ */
 template< typename Alphabet >
 class SequenceReader {
 public:
-  SequenceReader( const std::string& pathToFile )
-      : mTextReader( new TextFileReader( pathToFile ) ) {}
-
-  SequenceReader( std::istream& is )
-      : mTextReader( new TextStreamReader( is ) ) {}
-
   bool EndOfFile() const {
-    return mTextReader->EndOfFile();
+    return mBatchPos >= mBatch.Size() && EndOfInput();
   }
 
-  size_t NumBytesRead() const {
-    return mTextReader->NumBytesRead();
+  virtual size_t NumBytesRead() const  = 0;
+  virtual size_t NumBytesTotal() const = 0;
+
+  // Whether reading stopped early (e.g. on a truncated compressed file),
+  // known once EndOfFile is reached
+  virtual bool Failed() const {
+    return false;
   }
 
-  size_t NumBytesTotal() const {
-    return mTextReader->NumBytesTotal();
+  SequenceReader< Alphabet >& operator>>( Sequence< Alphabet >& seq ) {
+    if( !Read( &seq ) ) {
+      seq = Sequence< Alphabet >();
+    }
+    return *this;
   }
 
-  virtual SequenceReader< Alphabet >& operator>>( Sequence< Alphabet >& seq ) = 0;
+  // False at the end of the file
+  bool Read( Sequence< Alphabet >* seq ) {
+    if( mBatchPos >= mBatch.Size() ) {
+      Read( &mBatch );
+      mBatchPos = 0;
+    }
+
+    if( mBatchPos >= mBatch.Size() )
+      return false;
+
+    mBatch.Get( mBatchPos++, seq );
+    return true;
+  }
 
   void Read( const size_t count, SequenceList< Alphabet >* out ) {
     Sequence< Alphabet > seq;
 
-    for( size_t i = 0; i < count && !EndOfFile(); i++ ) {
-      *this >> seq;
+    for( size_t i = 0; i < count && Read( &seq ); i++ ) {
       out->push_back( std::move( seq ) );
     }
   }
 
+  // Reads the next batch of records, at least one unless the end of the file
+  // is reached
+  void Read( RecordBatch* batch ) {
+    batch->Clear();
+
+    // Records left over from operator>> come first
+    if( mBatchPos < mBatch.Size() ) {
+      for( ; mBatchPos < mBatch.Size(); mBatchPos++ ) {
+        batch->Add( mBatch, mBatchPos );
+      }
+      return;
+    }
+
+    ReadBatch( batch );
+  }
+
   virtual ~SequenceReader() = default;
 
 protected:
+  SequenceReader() : mBatchPos( 0 ) {}
+
+  // Appends the next records to the (empty) batch
+  virtual void ReadBatch( RecordBatch* batch ) = 0;
+  virtual bool EndOfInput() const             = 0;
+
+private:
+  RecordBatch mBatch;
+  size_t      mBatchPos;
+};
+
+/*
+ * Records are parsed in batches, straight from the chunks handed out by the
+ * text reader. Only a record cut by the end of a chunk is copied.
+ * With numThreads > 1, chunks are parsed on that many threads (see
+ * ChunkParser), records still come out in file order.
+ */
+template< typename Alphabet >
+class TextSequenceReader : public SequenceReader< Alphabet > {
+public:
+  TextSequenceReader( const std::string& pathToFile,
+                      const size_t       numThreads = std::max(
+                        std::thread::hardware_concurrency(), 1u ) )
+      : TextSequenceReader( OpenTextFile( pathToFile ), numThreads ) {}
+
+  // Records [first, last) of an indexed file only
+  TextSequenceReader( const std::string&   pathToFile,
+                      const SequenceIndex& index, const size_t first,
+                      const size_t last,
+                      const size_t numThreads = std::max(
+                        std::thread::hardware_concurrency(), 1u ) )
+      : TextSequenceReader( OpenTextFile( pathToFile, index.ByteOffset( first ),
+                                          index.ByteOffset( last ) ),
+                            numThreads ) {}
+
+  TextSequenceReader( std::istream& is, const size_t numThreads = 1 )
+      : TextSequenceReader(
+          std::unique_ptr< TextReader >( new TextStreamReader( is ) ),
+          numThreads ) {}
+
+  TextSequenceReader( std::unique_ptr< TextReader > textReader,
+                      const size_t                  numThreads = 1 )
+      : mTextReader( std::move( textReader ) ), mNumThreads( numThreads ),
+        mRetrySize( 0 ) {}
+
+  size_t NumBytesRead() const {
+    return mChunkParser ? mChunkParser->NumBytesRead()
+                        : mTextReader->NumBytesRead();
+  }
+
+  size_t NumBytesTotal() const {
+    return mTextReader->NumBytesTotal();
+  }
+
+  bool Failed() const {
+    return mTextReader->Failed();
+  }
+
+protected:
+  bool EndOfInput() const {
+    if( mChunkParser )
+      return mChunkParser->EndOfFile();
+
+    return mPending.empty() && mTextReader->EndOfFile();
+  }
+
+  // All complete records of the next chunk(s)
+  void ReadBatch( RecordBatch* batch ) {
+    if( mNumThreads > 1 ) {
+      // Started on first use, the parser isn't known before
+      if( !mChunkParser ) {
+        mChunkParser.reset(
+          new ChunkParser( mTextReader.get(), &Parser(), mNumThreads ) );
+      }
+      mChunkParser->Read( batch );
+      return;
+    }
+
+    const RecordParser& parser = Parser();
+    while( batch->Empty() &&
+           !( mPending.empty() && mTextReader->EndOfFile() ) ) {
+      LineView chunk     = mTextReader->ReadChunk();
+      bool     endOfFile = mTextReader->EndOfFile();
+
+      size_t numBytes;
+      if( mPending.empty() ) {
+        numBytes = parser.Parse( chunk.data, chunk.length, endOfFile, batch );
+        mPending.assign( chunk.data + numBytes, chunk.length - numBytes );
+      } else {
+        mPending.append( chunk.data, chunk.length );
+
+        // A record spanning many chunks is parsed again only once the pending
+        // bytes doubled, which keeps it linear
+        if( mPending.size() < mRetrySize && !endOfFile )
+          continue;
+
+        numBytes =
+          parser.Parse( mPending.data(), mPending.size(), endOfFile, batch );
+        mPending.erase( 0, numBytes );
+      }
+
+      mRetrySize = batch->Empty() ? 2 * mPending.size() : 0;
+    }
+  }
+
+  // Format specific, used by several threads
+  virtual const RecordParser& Parser() const = 0;
+
   std::unique_ptr< TextReader > mTextReader;
+
+private:
+  size_t mNumThreads;
+
+  // Sequential parsing
+  std::string mPending; // start of a record cut off by the end of a chunk
+  size_t      mRetrySize;
+
+  // Parallel parsing, reads from mTextReader on its own threads
+  std::unique_ptr< ChunkParser > mChunkParser;
 };
@@ -1,15 +1,17 @@
 #pragma once
 
+#include "OutputFile.h"
 #include "Sequence.h"
 
 #include <fstream>
+#include <memory>
 
 template< typename Alphabet >
 class SequenceWriter  {
 public:
   SequenceWriter( std::ostream& output ) : mOutput( output ) {}
   SequenceWriter( const std::string& pathToFile )
-      : mFile( pathToFile ), mOutput( mFile ) {}
+      : mFile( OpenOutputFile( pathToFile ) ), mOutput( *mFile ) {}
 
   virtual SequenceWriter< Alphabet >&
   operator<<( const Sequence< Alphabet >& seq ) = 0;
@@ -17,6 +19,6 @@ public:
   virtual ~SequenceWriter() = default;
 
 protected:
-  std::ofstream mFile;
-  std::ostream& mOutput;
+  std::unique_ptr< std::ostream > mFile;
+  std::ostream&                   mOutput;
 };
@@ -0,0 +1,247 @@
+#pragma once
+
+#include "../Database/HitWriter.h"
+
+#include "../Alphabet/DNA.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace TSV {
+
+enum class Column {
+  Query,
+  Target,
+  Identity,
+  AlignmentLength,
+  Mismatches,
+  GapOpens,
+  Gaps,
+  QueryLow,
+  QueryHigh,
+  TargetLow,
+  TargetHigh,
+  QueryLength,
+  TargetLength,
+  QueryStrand,
+  Cigar,
+};
+using Columns = std::vector< Column >;
+
+// Named like usearch's userfields
+static const std::map< std::string, Column > ColumnNames = {
+  { "query", Column::Query },         { "target", Column::Target },
+  { "id", Column::Identity },         { "alnlen", Column::AlignmentLength },
+  { "mism", Column::Mismatches },     { "opens", Column::GapOpens },
+  { "gaps", Column::Gaps },           { "qlo", Column::QueryLow },
+  { "qhi", Column::QueryHigh },       { "tlo", Column::TargetLow },
+  { "thi", Column::TargetHigh },      { "ql", Column::QueryLength },
+  { "tl", Column::TargetLength },     { "qstrand", Column::QueryStrand },
+  { "cigar", Column::Cigar },
+};
+
+// blast6-like
+static const char DefaultColumns[] =
+  "query+target+id+alnlen+mism+opens+qlo+qhi+tlo+thi";
+
+// Names joined by '+', false if a name is unknown
+inline bool ParseColumns( const std::string& str, Columns* columns ) {
+  columns->clear();
+
+  size_t start = 0;
+  while( start <= str.size() ) {
+    size_t end = str.find( '+', start );
+    if( end == std::string::npos )
+      end = str.size();
+
+    auto it = ColumnNames.find( str.substr( start, end - start ) );
+    if( it == ColumnNames.end() )
+      return false;
+
+    columns->push_back( it->second );
+    start = end + 1;
+  }
+
+  return true;
+}
+
+inline Columns ParseColumns( const std::string& str ) {
+  Columns columns;
+  ParseColumns( str, &columns );
+  return columns;
+}
+
+/*
+ * One tab-separated line per hit, with the selected columns only.
+ * Columns are computed from the cigar entries (not the alignment columns)
+ * and only if selected. Coordinates are 1-based, a minus strand hit has
+ * qlo > qhi.
+ */
+template < typename Alphabet >
+class Writer : public HitWriter< Alphabet > {
+public:
+  Writer( std::ostream&  output,
+          const Columns& columns = ParseColumns( DefaultColumns ) )
+      : HitWriter< Alphabet >( output ) {
+    SetColumns( columns );
+  }
+
+  Writer( const std::string& pathToFile,
+          const Columns&     columns = ParseColumns( DefaultColumns ) )
+      : HitWriter< Alphabet >( pathToFile ) {
+    SetColumns( columns );
+  }
+
+  HitWriter< Alphabet >&
+  operator<<( const QueryHitsPair< Alphabet >& queryWithHits ) {
+    const auto& query = queryWithHits.first;
+    const auto& hits  = queryWithHits.second;
+
+    mLine.clear();
+    for( auto& hit : hits ) {
+      const Cigar& cigar = hit.alignment;
+
+      // Interior entries, without terminal gaps
+      size_t first = 0, last = cigar.size();
+      size_t qs = 0, qe = query.Length();
+      size_t ts = 0, te = hit.target.Length();
+      if( first < last && IsGap( cigar[ first ] ) ) {
+        ( cigar[ first ].op == CigarOp::Insertion ? qs : ts ) +=
+          cigar[ first ].count;
+        first++;
+      }
+      if( first < last && IsGap( cigar[ last - 1 ] ) ) {
+        ( cigar[ last - 1 ].op == CigarOp::Insertion ? qe : te ) -=
+          cigar[ last - 1 ].count;
+        last--;
+      }
+
+      size_t numMismatches = 0, numGapOpens = 0, numGaps = 0;
+      if( mCountDifferences ) {
+        for( size_t i = first; i < last; i++ ) {
+          CigarEntry entry = cigar[ i ];
+          if( entry.op == CigarOp::Mismatch ) {
+            numMismatches += entry.count;
+          } else if( IsGap( entry ) ) {
+            numGapOpens++;
+            numGaps += entry.count;
+          }
+        }
+      }
+
+      bool minus = IsMinusStrand( hit );
+      if( minus ) {
+        // Positions on the query as given
+        size_t len = query.Length();
+        qs         = len - qs;
+        qe         = len - qe + 1;
+      } else {
+        qs++;
+      }
+      ts++;
+
+      for( size_t i = 0; i < mColumns.size(); i++ ) {
+        if( i > 0 )
+          mLine += '\t';
+
+        switch( mColumns[ i ] ) {
+          case Column::Query: mLine += query.identifier; break;
+          case Column::Target: mLine += hit.target.identifier; break;
+          case Column::Identity:
+            AppendFixed( &mLine, cigar.Identity() * 100.0f, 1 );
+            break;
+          case Column::AlignmentLength:
+            AppendUnsigned( &mLine,
+                            cigar.NumMatches() + cigar.NumDifferences() );
+            break;
+          case Column::Mismatches:
+            AppendUnsigned( &mLine, numMismatches );
+            break;
+          case Column::GapOpens: AppendUnsigned( &mLine, numGapOpens ); break;
+          case Column::Gaps: AppendUnsigned( &mLine, numGaps ); break;
+          case Column::QueryLow: AppendUnsigned( &mLine, qs ); break;
+          case Column::QueryHigh: AppendUnsigned( &mLine, qe ); break;
+          case Column::TargetLow: AppendUnsigned( &mLine, ts ); break;
+          case Column::TargetHigh: AppendUnsigned( &mLine, te ); break;
+          case Column::QueryLength:
+            AppendUnsigned( &mLine, query.Length() );
+            break;
+          case Column::TargetLength:
+            AppendUnsigned( &mLine, hit.target.Length() );
+            break;
+          case Column::QueryStrand: mLine += minus ? '-' : '+'; break;
+          case Column::Cigar:
+            for( size_t j = first; j < last; j++ ) {
+              AppendUnsigned( &mLine, cigar[ j ].count );
+              mLine += char( cigar[ j ].op );
+            }
+            break;
+        }
+      }
+      mLine += '\n';
+    }
+
+    this->mOutput.write( mLine.data(), mLine.size() );
+    return *this;
+  }
+
+private:
+  void SetColumns( const Columns& columns ) {
+    mColumns          = columns;
+    mCountDifferences = false;
+    for( auto column : mColumns ) {
+      if( column == Column::Mismatches || column == Column::GapOpens ||
+          column == Column::Gaps )
+        mCountDifferences = true;
+    }
+  }
+
+  static bool IsGap( const CigarEntry& entry ) {
+    return entry.op == CigarOp::Insertion || entry.op == CigarOp::Deletion;
+  }
+
+  static inline bool IsMinusStrand( const Hit< Alphabet >& hit ) {
+    return false;
+  }
+
+  static void AppendUnsigned( std::string* out, size_t value ) {
+    char  digits[ 20 ];
+    char* end = digits + sizeof( digits );
+    char* pos = end;
+    do {
+      *--pos = char( '0' + value % 10 );
+      value /= 10;
+    } while( value > 0 );
+    out->append( pos, end - pos );
+  }
+
+  // Non-negative values, rounded
+  static void AppendFixed( std::string* out, const float value,
+                           const int decimals ) {
+    size_t scale = 1;
+    for( int i = 0; i < decimals; i++ )
+      scale *= 10;
+
+    size_t scaled = size_t( value * scale + 0.5f );
+    AppendUnsigned( out, scaled / scale );
+    if( decimals > 0 ) {
+      *out += '.';
+      size_t fraction = scaled % scale;
+      for( size_t div = scale / 10; div > 0; div /= 10 ) {
+        *out += char( '0' + ( fraction / div ) % 10 );
+      }
+    }
+  }
+
+  Columns     mColumns;
+  bool        mCountDifferences;
+  std::string mLine;
+};
+
+template <>
+inline bool Writer< DNA >::IsMinusStrand( const Hit< DNA >& hit ) {
+  return hit.strand == DNA::Strand::Minus;
+}
+
+} // namespace TSV
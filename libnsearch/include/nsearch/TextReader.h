@@ -1,13 +1,46 @@
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
 #include <fstream>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <queue>
 #include <string>
+#include <thread>
+#include <vector>
 
 #ifdef USE_ZLIB
 #include <zlib.h>
+
+class BGZFDecompressor;
 #endif
 
+// Line handed out by a reader without copying it
+class LineView {
+public:
+  const char* data   = NULL;
+  size_t      length = 0;
+
+  LineView() {}
+  LineView( const char* data, const size_t length )
+      : data( data ), length( length ) {}
+  LineView( const std::string& str ) : data( str.data() ), length( str.size() ) {}
+
+  bool empty() const {
+    return length == 0;
+  }
+
+  char operator[]( const size_t index ) const {
+    return data[ index ];
+  }
+
+  std::string ToString() const {
+    return std::string( data, length );
+  }
+};
+
 class TextReader {
 public:
   virtual size_t NumBytesRead() const  = 0;
@@ -17,9 +50,35 @@ public:
 
   virtual void operator>>( std::string& str ) = 0;
 
+  // Next non-blank line, valid until the next read. Readers which can't
+  // point into their buffer copy the line
+  virtual LineView ReadLine() {
+    *this >> mLine;
+    return LineView( mLine );
+  }
+
+  // Next chunk of raw bytes (lines can be cut anywhere), valid until the next
+  // read
+  virtual LineView ReadChunk() = 0;
+
+  // Whether chunks stay valid as long as the reader (e.g. a mapped file)
+  virtual bool ChunksOutliveReads() const {
+    return false;
+  }
+
+  // Whether reading stopped early, e.g. on truncated or corrupt compressed
+  // data. Known once EndOfFile is reached
+  virtual bool Failed() const {
+    return false;
+  }
+
   virtual ~TextReader() = default;
+
+protected:
+  std::string mLine;
 };
 
+// Never seeks, so pipes work. Their size is unknown (NumBytesTotal is 0)
 class TextStreamReader : public TextReader {
 public:
   TextStreamReader( std::istream& is );
@@ -29,20 +88,28 @@ public:
 
   bool EndOfFile() const;
 
-  void operator>>( std::string& str );
+  void     operator>>( std::string& str );
+  LineView ReadChunk();
 
 private:
-  std::istream&  mInput;
-  std::streampos mTotalBytes;
+  std::istream& mInput;
+  size_t        mTotalBytes, mNumBytesRead;
 };
 
 /*
  * Reading huge fastq files needs to be fast
+ * With numReadAheadBuffers > 0, a separate thread reads (and decompresses)
+ * ahead into that many buffers, so parsing doesn't wait for disk or zlib.
+ * BGZF files are inflated on all cores instead (up to the first member which
+ * isn't BGZF, zlib takes over from there).
+ * "-" reads stdin. Pipes aren't seeked: gzip input is detected by zlib
+ * itself, NumBytesTotal is 0 and NumBytesRead counts the bytes handed out.
  */
 class TextFileReader : public TextReader {
 public:
   TextFileReader( const std::string& fileName,
-                  const size_t       totalBufferSize = 32 * 1024 );
+                  const size_t       totalBufferSize     = 32 * 1024,
+                  const size_t       numReadAheadBuffers = 0 );
   ~TextFileReader();
 
   size_t NumBytesRead() const;
@@ -50,18 +117,120 @@ public:
 
   bool EndOfFile() const;
 
-  void operator>>( std::string& str );
+  void     operator>>( std::string& str );
+  LineView ReadChunk();
+
+  bool Failed() const;
 
 private:
-  void NextBuffer();
+  size_t Read( char* buffer );
+  void   NextBuffer( const bool keepCurrent = false );
+  void   ReadAhead();
 
   int mFd;
 
 #ifdef USE_ZLIB
-  gzFile mGzFile;
+  gzFile                              mGzFile;
+  std::unique_ptr< BGZFDecompressor > mBGZF;
 #endif
 
   size_t mBufferPos, mBufferSize, mTotalBufferSize;
   char*  mBuffer;
   off_t  mTotalBytes;
+  size_t mNumBytesConsumed;
+
+  std::atomic< bool > mFailed; // set by the read-ahead thread, too
+
+  std::vector< std::vector< char > > mBuffers;
+  std::vector< size_t >              mBufferSizes;
+  size_t                             mCurrentBuffer;
+  size_t                             mKeptBuffer; // handed out by ReadChunk
+
+  // Read-ahead thread fills free buffers, we consume filled ones
+  std::thread             mReadAheadThread;
+  std::mutex              mMutex;
+  std::condition_variable mFilledCondition, mFreeCondition;
+  std::queue< size_t >    mFilledBuffers, mFreeBuffers;
+  bool                    mStop;
+};
+
+#ifndef _WIN32
+/*
+ * Uncompressed files are mapped into memory, lines are handed out straight
+ * from the mapping. Given a range, only bytes [begin, end) are read (and
+ * counted by NumBytesRead/NumBytesTotal)
+ */
+class MappedTextFileReader : public TextReader {
+public:
+  MappedTextFileReader( const std::string& fileName, const size_t begin = 0,
+                        const size_t end = size_t( -1 ) );
+  ~MappedTextFileReader();
+
+  bool IsMapped() const;
+
+  size_t NumBytesRead() const;
+  size_t NumBytesTotal() const;
+
+  bool EndOfFile() const;
+
+  void     operator>>( std::string& str );
+  LineView ReadLine();
+  LineView ReadChunk();
+
+  bool ChunksOutliveReads() const {
+    return true;
+  }
+
+private:
+  void SkipBlankLines();
+
+  const char* mData;
+  size_t      mMappedSize, mBegin, mSize, mPos;
+};
+#endif
+
+/*
+ * Bytes [begin, end) of the text of another reader. Everything before begin
+ * is read (e.g. inflated) and skipped. NumBytesTotal is 0 if end is past the
+ * end of the text.
+ */
+class TextRangeReader : public TextReader {
+public:
+  TextRangeReader( std::unique_ptr< TextReader > reader, const size_t begin,
+                   const size_t end = size_t( -1 ) );
+
+  size_t NumBytesRead() const;
+  size_t NumBytesTotal() const;
+
+  bool EndOfFile() const;
+
+  void     operator>>( std::string& str );
+  LineView ReadChunk();
+
+  bool ChunksOutliveReads() const {
+    return mReader->ChunksOutliveReads();
+  }
+
+  bool Failed() const {
+    return mReader->Failed();
+  }
+
+private:
+  void NextChunk();
+
+  std::unique_ptr< TextReader > mReader;
+  size_t                        mBegin, mEnd;
+  size_t                        mPos; // in the text of mReader
+  size_t                        mNumBytesRead;
+  LineView                      mChunk; // not handed out yet
 };
+
+// Maps the file if possible, reads it chunk by chunk on a read-ahead thread
+// otherwise (e.g. if it is compressed or "-", i.e. stdin)
+std::unique_ptr< TextReader > OpenTextFile( const std::string& fileName );
+
+// Bytes [begin, end) of the (uncompressed) text only. Mapped files start
+// right there, others are read up to begin
+std::unique_ptr< TextReader > OpenTextFile( const std::string& fileName,
+                                            const size_t       begin,
+                                            const size_t       end );
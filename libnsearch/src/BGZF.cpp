@@ -0,0 +1,437 @@
+#include "nsearch/BGZF.h"
+
+#ifdef USE_ZLIB
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cstring>
+
+#ifndef _WIN32
+#include <unistd.h>
+#else
+#include "winstd.h"
+#endif
+
+static const size_t HeaderSize = 12; // up to and including XLEN
+
+const size_t BGZFDecompressor::MaxBlockSize;
+
+// Fewer bytes only at the end of the file (or on errors)
+static size_t ReadUpTo( const int fd, void* buffer, const size_t numBytes ) {
+  size_t numRead = 0;
+  while( numRead < numBytes ) {
+    ssize_t ret = read( fd, ( uint8_t* ) buffer + numRead, numBytes - numRead );
+    if( ret <= 0 )
+      break;
+    numRead += ret;
+  }
+  return numRead;
+}
+
+static bool ReadFully( const int fd, void* buffer, const size_t numBytes ) {
+  return ReadUpTo( fd, buffer, numBytes ) == numBytes;
+}
+
+static uint16_t Uint16LE( const uint8_t* bytes ) {
+  return bytes[ 0 ] | ( bytes[ 1 ] << 8 );
+}
+
+static uint32_t Uint32LE( const uint8_t* bytes ) {
+  return Uint16LE( bytes ) | ( uint32_t( Uint16LE( bytes + 2 ) ) << 16 );
+}
+
+static bool IsGzipHeader( const uint8_t* header ) {
+  return header[ 0 ] == 0x1F && header[ 1 ] == 0x8B && header[ 2 ] == 8;
+}
+
+static bool IsGzipHeaderWithExtra( const uint8_t* header ) {
+  return IsGzipHeader( header ) && ( header[ 3 ] & 4 ); // FEXTRA
+}
+
+// Total size of the block (BSIZE + 1) from the "BC" extra subfield, 0 if
+// there is none
+static size_t BlockSize( const uint8_t* extra, const size_t length ) {
+  size_t pos = 0;
+  while( pos + 4 <= length ) {
+    uint16_t subfieldLength = Uint16LE( extra + pos + 2 );
+    if( extra[ pos ] == 'B' && extra[ pos + 1 ] == 'C' &&
+        subfieldLength == 2 && pos + 6 <= length ) {
+      return Uint16LE( extra + pos + 4 ) + 1;
+    }
+    pos += 4 + subfieldLength;
+  }
+  return 0;
+}
+
+bool BGZFDecompressor::IsBGZF( const int fd ) {
+  off_t pos = lseek( fd, 0, SEEK_CUR );
+
+  uint8_t header[ HeaderSize + 6 ];
+  bool    isBGZF = ReadFully( fd, header, sizeof( header ) ) &&
+                IsGzipHeaderWithExtra( header ) &&
+                BlockSize( header + HeaderSize,
+                           std::min( size_t( Uint16LE( header + 10 ) ),
+                                     size_t( 6 ) ) ) > 0;
+
+  lseek( fd, pos, SEEK_SET );
+  return isBGZF;
+}
+
+BGZFDecompressor::BGZFDecompressor( const int fd, const size_t numThreads )
+    : mFd( fd ), mBlocks( 2 * numThreads + 2 ), mNumRead( 0 ),
+      mNumHandedOut( 0 ), mEnd( false ), mTruncated( false ), mCorrupt( false ),
+      mStop( false ), mPlainGzipOffset( -1 ) {
+  for( size_t i = 0; i < numThreads; i++ ) {
+    mWorkers.push_back( std::thread( &BGZFDecompressor::WorkerLoop, this ) );
+  }
+}
+
+BGZFDecompressor::~BGZFDecompressor() {
+  { // acquire lock
+    std::unique_lock< std::mutex > lock( mMutex );
+    mStop = true;
+  } // release lock
+  mFreeCondition.notify_all();
+
+  for( auto& worker : mWorkers ) {
+    worker.join();
+  }
+}
+
+size_t BGZFDecompressor::NextBlock( char** data ) {
+  std::unique_lock< std::mutex > lock( mMutex );
+
+  while( !mCorrupt ) {
+    const Block& block = mBlocks[ mNumHandedOut % mBlocks.size() ];
+    while( !( block.ready && block.seq == mNumHandedOut ) &&
+           !( mEnd && mNumHandedOut >= mNumRead ) )
+      mReadyCondition.wait( lock );
+
+    if( !block.ready || block.seq != mNumHandedOut )
+      break; // end of file
+
+    // The previous block can be reused now
+    mNumHandedOut++;
+    mFreeCondition.notify_all();
+
+    if( !block.valid ) {
+      mCorrupt = true;
+      break;
+    }
+
+    // Skip empty blocks (e.g. the end-of-file marker)
+    if( block.size > 0 ) {
+      *data = const_cast< char* >( block.data.data() );
+      return block.size;
+    }
+  }
+
+  return 0;
+}
+
+bool BGZFDecompressor::Corrupt() const {
+  std::unique_lock< std::mutex > lock( mMutex );
+  return mCorrupt || mTruncated;
+}
+
+int64_t BGZFDecompressor::PlainGzipOffset() const {
+  std::unique_lock< std::mutex > lock( mMutex );
+  return mPlainGzipOffset;
+}
+
+BGZFDecompressor::ReadResult BGZFDecompressor::ReadBlock( Block* block ) {
+  int64_t offset = lseek( mFd, 0, SEEK_CUR );
+
+  uint8_t header[ HeaderSize ];
+  size_t  numRead = ReadUpTo( mFd, header, HeaderSize );
+  if( numRead == 0 )
+    return ReadResult::End;
+  if( numRead < HeaderSize || !IsGzipHeader( header ) )
+    return ReadResult::Corrupt;
+
+  // Without the "BC" subfield (or any extra field), it's plain gzip
+  uint16_t extraLength =
+    IsGzipHeaderWithExtra( header ) ? Uint16LE( header + 10 ) : 0;
+  uint8_t extra[ 0xFFFF ];
+  if( !ReadFully( mFd, extra, extraLength ) )
+    return ReadResult::Corrupt;
+
+  size_t blockSize = BlockSize( extra, extraLength );
+  if( blockSize == 0 ) {
+    mPlainGzipOffset = offset;
+    return ReadResult::PlainGzip;
+  }
+
+  // Compressed data, CRC32 and ISIZE
+  if( blockSize < HeaderSize + extraLength + 8 )
+    return ReadResult::Corrupt;
+
+  block->compressed.resize( blockSize - HeaderSize - extraLength );
+  if( !ReadFully( mFd, block->compressed.data(), block->compressed.size() ) )
+    return ReadResult::Corrupt;
+
+  return ReadResult::Block;
+}
+
+bool BGZFDecompressor::Inflate( Block* block ) {
+  const uint8_t* trailer =
+    block->compressed.data() + block->compressed.size() - 8;
+  uint32_t crc  = Uint32LE( trailer );
+  uint32_t size = Uint32LE( trailer + 4 );
+  if( size > MaxBlockSize )
+    return false;
+
+  block->data.resize( MaxBlockSize );
+  block->size = 0;
+
+  z_stream stream;
+  memset( &stream, 0, sizeof( stream ) );
+  if( inflateInit2( &stream, -15 ) != Z_OK ) // raw deflate
+    return false;
+
+  stream.next_in   = block->compressed.data();
+  stream.avail_in  = block->compressed.size() - 8;
+  stream.next_out  = ( Bytef* ) block->data.data();
+  stream.avail_out = block->data.size();
+
+  int ret = inflate( &stream, Z_FINISH );
+  inflateEnd( &stream );
+  if( ret != Z_STREAM_END || stream.total_out != size )
+    return false;
+
+  block->size = size;
+  return crc32( crc32( 0, NULL, 0 ), ( const Bytef* ) block->data.data(),
+                size ) == crc;
+}
+
+void BGZFDecompressor::WorkerLoop() {
+  while( true ) {
+    Block* block;
+
+    { // acquire lock
+      std::unique_lock< std::mutex > lock( mMutex );
+
+      // Don't overwrite blocks not handed out yet (or the current one)
+      while( !mStop && !mEnd &&
+             mNumRead + 1 >= mNumHandedOut + mBlocks.size() )
+        mFreeCondition.wait( lock );
+
+      if( mStop || mEnd )
+        break;
+
+      // Reading is cheap compared to inflating, keep it in order here
+      block        = &mBlocks[ mNumRead % mBlocks.size() ];
+      block->ready = false;
+      block->seq   = mNumRead;
+
+      ReadResult result = ReadBlock( block );
+      if( result != ReadResult::Block ) {
+        mEnd       = true;
+        mTruncated = ( result == ReadResult::Corrupt );
+        mReadyCondition.notify_all();
+        mFreeCondition.notify_all();
+        break;
+      }
+      mNumRead++;
+    } // release lock
+
+    bool valid = Inflate( block );
+
+    { // acquire lock
+      std::unique_lock< std::mutex > lock( mMutex );
+      block->valid = valid;
+      block->ready = true;
+    } // release lock
+    mReadyCondition.notify_all();
+  }
+}
+
+/*
+ * BGZFOutputStream
+ */
+const size_t BGZFOutputStream::Compressor::BlockSize;
+
+static void PutUint16LE( uint8_t* bytes, const uint16_t value ) {
+  bytes[ 0 ] = value & 0xFF;
+  bytes[ 1 ] = value >> 8;
+}
+
+static void PutUint32LE( uint8_t* bytes, const uint32_t value ) {
+  PutUint16LE( bytes, value & 0xFFFF );
+  PutUint16LE( bytes + 2, value >> 16 );
+}
+
+// Header with the "BC" subfield, BSIZE is filled in later
+static const uint8_t BlockHeader[] = { 0x1F, 0x8B, 8, 4, 0, 0, 0, 0, 0, 0xFF,
+                                       6,    0,    'B', 'C', 2, 0, 0, 0 };
+
+// Empty block marking the end of the file
+static const uint8_t EndOfFileBlock[] = {
+  0x1F, 0x8B, 8, 4, 0, 0, 0, 0, 0, 0xFF, 6, 0, 'B', 'C',
+  2,    0,    27, 0, 3, 0, 0, 0, 0, 0,   0, 0, 0,   0
+};
+
+BGZFOutputStream::BGZFOutputStream( const std::string& fileName,
+                                    const size_t       numThreads )
+    : std::ostream( NULL ), mCompressor( fileName, numThreads ) {
+  rdbuf( &mCompressor );
+}
+
+BGZFOutputStream::Compressor::Compressor( const std::string& fileName,
+                                          const size_t       numThreads )
+    : mFile( fileName, std::ios::binary ), mPending( BlockSize ),
+      mBlocks( 2 * numThreads + 2 ), mNumSubmitted( 0 ), mNumTaken( 0 ),
+      mNumWritten( 0 ), mStop( false ) {
+  setp( mPending.data(), mPending.data() + mPending.size() );
+
+  for( size_t i = 0; i < numThreads; i++ ) {
+    mWorkers.push_back(
+      std::thread( &BGZFOutputStream::Compressor::WorkerLoop, this ) );
+  }
+}
+
+BGZFOutputStream::Compressor::~Compressor() {
+  Submit();
+
+  { // acquire lock
+    std::unique_lock< std::mutex > lock( mMutex );
+    while( mNumWritten < mNumSubmitted )
+      mFreeCondition.wait( lock );
+
+    mStop = true;
+  } // release lock
+  mFilledCondition.notify_all();
+
+  for( auto& worker : mWorkers ) {
+    worker.join();
+  }
+
+  mFile.write( ( const char* ) EndOfFileBlock, sizeof( EndOfFileBlock ) );
+}
+
+BGZFOutputStream::Compressor::int_type
+BGZFOutputStream::Compressor::overflow( int_type ch ) {
+  Submit();
+
+  if( !traits_type::eq_int_type( ch, traits_type::eof() ) ) {
+    *pptr() = traits_type::to_char_type( ch );
+    pbump( 1 );
+  }
+  return traits_type::not_eof( ch );
+}
+
+std::streamsize
+BGZFOutputStream::Compressor::xsputn( const char* data,
+                                      std::streamsize count ) {
+  std::streamsize numWritten = 0;
+  while( numWritten < count ) {
+    std::streamsize numBytes =
+      std::min< std::streamsize >( count - numWritten, epptr() - pptr() );
+    memcpy( pptr(), data + numWritten, numBytes );
+    pbump( numBytes );
+    numWritten += numBytes;
+
+    if( pptr() == epptr() ) {
+      Submit();
+    }
+  }
+  return numWritten;
+}
+
+void BGZFOutputStream::Compressor::Submit() {
+  size_t size = pptr() - pbase();
+  if( size == 0 )
+    return;
+
+  { // acquire lock
+    std::unique_lock< std::mutex > lock( mMutex );
+
+    Block& block = mBlocks[ mNumSubmitted % mBlocks.size() ];
+    while( block.state != State::Free )
+      mFreeCondition.wait( lock );
+
+    // Swap buffers instead of copying
+    block.data.swap( mPending );
+    block.data.resize( size );
+    block.seq   = mNumSubmitted++;
+    block.state = State::Filled;
+  } // release lock
+  mFilledCondition.notify_one();
+
+  mPending.resize( BlockSize );
+  setp( mPending.data(), mPending.data() + mPending.size() );
+}
+
+void BGZFOutputStream::Compressor::Compress( Block* block ) {
+  const size_t headerSize = sizeof( BlockHeader ), trailerSize = 8;
+
+  z_stream stream;
+  memset( &stream, 0, sizeof( stream ) );
+  deflateInit2( &stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8,
+                Z_DEFAULT_STRATEGY ); // raw deflate
+
+  size_t bound = deflateBound( &stream, block->data.size() );
+  block->compressed.resize( headerSize + bound + trailerSize );
+
+  stream.next_in   = ( Bytef* ) block->data.data();
+  stream.avail_in  = block->data.size();
+  stream.next_out  = block->compressed.data() + headerSize;
+  stream.avail_out = bound;
+  deflate( &stream, Z_FINISH );
+  deflateEnd( &stream );
+
+  size_t   size  = headerSize + stream.total_out + trailerSize;
+  uint8_t* bytes = block->compressed.data();
+  memcpy( bytes, BlockHeader, headerSize );
+  PutUint16LE( bytes + 16, size - 1 ); // BSIZE
+
+  uint8_t* trailer = bytes + headerSize + stream.total_out;
+  PutUint32LE( trailer, crc32( crc32( 0, NULL, 0 ),
+                               ( const Bytef* ) block->data.data(),
+                               block->data.size() ) );
+  PutUint32LE( trailer + 4, block->data.size() );
+
+  block->compressed.resize( size );
+}
+
+void BGZFOutputStream::Compressor::WorkerLoop() {
+  while( true ) {
+    Block* block;
+
+    { // acquire lock
+      std::unique_lock< std::mutex > lock( mMutex );
+
+      while( !mStop && mNumTaken == mNumSubmitted )
+        mFilledCondition.wait( lock );
+
+      if( mStop )
+        break;
+
+      block = &mBlocks[ mNumTaken % mBlocks.size() ];
+      mNumTaken++;
+    } // release lock
+
+    Compress( block );
+
+    { // acquire lock
+      std::unique_lock< std::mutex > lock( mMutex );
+      block->state = State::Compressed;
+
+      // Write all blocks which are next in line
+      while( true ) {
+        Block& next = mBlocks[ mNumWritten % mBlocks.size() ];
+        if( next.state != State::Compressed || next.seq != mNumWritten )
+          break;
+
+        mFile.write( ( const char* ) next.compressed.data(),
+                     next.compressed.size() );
+        next.state = State::Free;
+        mNumWritten++;
+      }
+    } // release lock
+    mFreeCondition.notify_all();
+  }
+}
+
+#endif
@@ -0,0 +1,149 @@
+#include "nsearch/ChunkParser.h"
+
+#include <algorithm>
+
+ChunkParser::ChunkParser( TextReader* textReader, const RecordParser* parser,
+                          const size_t numThreads )
+    : mTextReader( textReader ), mParser( parser ),
+      mChunks( 2 * numThreads + 2 ), mNumRead( 0 ), mNumHandedOut( 0 ),
+      mEnd( false ), mStop( false ), mLastByte( '\n' ), mNumBytesRead( 0 ),
+      mDone( false ) {
+  for( size_t i = 0; i < numThreads; i++ ) {
+    mWorkers.push_back( std::thread( &ChunkParser::WorkerLoop, this ) );
+  }
+}
+
+ChunkParser::~ChunkParser() {
+  { // acquire lock
+    std::unique_lock< std::mutex > lock( mMutex );
+    mStop = true;
+  } // release lock
+  mFreeCondition.notify_all();
+
+  for( auto& worker : mWorkers ) {
+    worker.join();
+  }
+}
+
+void ChunkParser::Read( RecordBatch* batch ) {
+  batch->Clear();
+
+  while( batch->Empty() && !mDone ) {
+    Chunk* chunk;
+
+    { // acquire lock
+      std::unique_lock< std::mutex > lock( mMutex );
+
+      chunk = &mChunks[ mNumHandedOut % mChunks.size() ];
+      while( !( chunk->ready && chunk->seq == mNumHandedOut ) )
+        mReadyCondition.wait( lock );
+
+      // The previous chunk can be reused now
+      mNumHandedOut++;
+    } // release lock
+    mFreeCondition.notify_all();
+
+    mNumBytesRead = chunk->numBytesRead;
+
+    const char*  data = chunk->data.data;
+    const size_t size = chunk->data.length;
+    if( chunk->recordStart < size ) {
+      // The cut off record ends where the first record of this chunk starts
+      mPending.append( data, chunk->recordStart );
+      mParser->Parse( mPending.data(), mPending.size(), true, batch );
+
+      if( batch->Empty() ) {
+        std::swap( *batch, chunk->batch );
+      } else {
+        batch->Append( chunk->batch );
+      }
+
+      mPending.assign( data + chunk->recordEnd, size - chunk->recordEnd );
+    } else {
+      mPending.append( data, size );
+    }
+
+    if( chunk->last ) {
+      mParser->Parse( mPending.data(), mPending.size(), true, batch );
+      mPending.clear();
+      mDone = true;
+    }
+  }
+}
+
+bool ChunkParser::EndOfFile() const {
+  return mDone;
+}
+
+size_t ChunkParser::NumBytesRead() const {
+  return mNumBytesRead;
+}
+
+void ChunkParser::WorkerLoop() {
+  while( true ) {
+    Chunk* chunk;
+
+    { // acquire read lock
+      std::unique_lock< std::mutex > readLock( mReadMutex );
+
+      { // acquire lock
+        std::unique_lock< std::mutex > lock( mMutex );
+
+        // Don't overwrite chunks not handed out yet (or the current one)
+        while( !mStop && !mEnd &&
+               mNumRead + 1 >= mNumHandedOut + mChunks.size() )
+          mFreeCondition.wait( lock );
+
+        if( mStop || mEnd )
+          break;
+
+        chunk        = &mChunks[ mNumRead % mChunks.size() ];
+        chunk->ready = false;
+        chunk->seq   = mNumRead;
+        mNumRead++;
+      } // release lock
+
+      // Reading is cheap compared to parsing, keep it in order here. Chunks
+      // of mapped files are parsed where they are, others copied once
+      LineView view = mTextReader->ReadChunk();
+      if( mTextReader->ChunksOutliveReads() ) {
+        chunk->data = view;
+      } else {
+        chunk->copy.assign( view.data, view.length );
+        chunk->data = LineView( chunk->copy );
+      }
+
+      chunk->startsLine   = mLastByte == '\n';
+      chunk->numBytesRead = mTextReader->NumBytesRead();
+      chunk->last         = mTextReader->EndOfFile();
+
+      if( view.length > 0 )
+        mLastByte = view.data[ view.length - 1 ];
+
+      if( chunk->last ) {
+        { // acquire lock
+          std::unique_lock< std::mutex > lock( mMutex );
+          mEnd = true;
+        } // release lock
+        mFreeCondition.notify_all();
+      }
+    } // release read lock
+
+    const char*  data = chunk->data.data;
+    const size_t size = chunk->data.length;
+
+    chunk->batch.Clear();
+    chunk->recordStart =
+      mParser->FindRecordStart( data, size, chunk->startsLine );
+    chunk->recordEnd =
+      chunk->recordStart + mParser->Parse( data + chunk->recordStart,
+                                           size - chunk->recordStart, false,
+                                           &chunk->batch );
+
+    { // acquire lock
+      std::unique_lock< std::mutex > lock( mMutex );
+      chunk->ready = true;
+    } // release lock
+    mReadyCondition.notify_all();
+  }
+}
@@ -0,0 +1,56 @@
+#include "nsearch/NSB/Format.h"
+#include "nsearch/TextReader.h"
+
+#include <fcntl.h>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+NSB::MappedFile::MappedFile( const std::string& fileName )
+    : mData( NULL ), mSize( 0 ), mIsMapped( false ) {
+#ifndef _WIN32
+  int fd = fileName == "-" ? -1 : open( fileName.c_str(), O_RDONLY );
+  if( fd != -1 ) {
+    struct stat st;
+    if( fstat( fd, &st ) == 0 && S_ISREG( st.st_mode ) && st.st_size > 0 ) {
+      void* data = mmap( NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+      if( data != MAP_FAILED ) {
+        mData     = ( const uint8_t* ) data;
+        mSize     = st.st_size;
+        mIsMapped = true;
+        madvise( data, mSize, MADV_SEQUENTIAL );
+      }
+    }
+    close( fd ); // the mapping stays valid
+  }
+
+  // Compressed files are inflated below
+  if( mIsMapped && mSize >= 2 && mData[ 0 ] == 0x1F && mData[ 1 ] == 0x8B ) {
+    munmap( ( void* ) mData, mSize );
+    mData     = NULL;
+    mSize     = 0;
+    mIsMapped = false;
+  }
+
+  if( mIsMapped )
+    return;
+#endif
+
+  auto reader = OpenTextFile( fileName );
+  while( !reader->EndOfFile() ) {
+    LineView chunk = reader->ReadChunk();
+    mContents.insert( mContents.end(), chunk.data, chunk.data + chunk.length );
+  }
+  mData = mContents.data();
+  mSize = mContents.size();
+}
+
+NSB::MappedFile::~MappedFile() {
+#ifndef _WIN32
+  if( mIsMapped )
+    munmap( ( void* ) mData, mSize );
+#endif
+}
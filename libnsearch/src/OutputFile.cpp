@@ -0,0 +1,134 @@
+#include "nsearch/OutputFile.h"
+
+#include <fcntl.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#ifndef _WIN32
+#include <sys/uio.h>
+#include <unistd.h>
+#else
+#include "winstd.h"
+
+struct iovec {
+  void*  iov_base;
+  size_t iov_len;
+};
+
+static ssize_t writev( const int fd, const struct iovec* iov,
+                       const int count ) {
+  ssize_t total = 0;
+  for( int i = 0; i < count; i++ ) {
+    ssize_t ret = write( fd, iov[ i ].iov_base, iov[ i ].iov_len );
+    if( ret < 0 )
+      return total > 0 ? total : ret;
+
+    total += ret;
+    if( size_t( ret ) < iov[ i ].iov_len )
+      break;
+  }
+  return total;
+}
+#endif
+
+/*
+ * BufferedOutputStream
+ */
+BufferedOutputStream::BufferedOutputStream( const std::string& fileName,
+                                            const size_t       bufferSize )
+    : std::ostream( NULL ), mBuffer( fileName, bufferSize ) {
+  rdbuf( &mBuffer );
+  if( !mBuffer.IsOpen() ) {
+    setstate( std::ios::failbit );
+  }
+}
+
+BufferedOutputStream::Buffer::Buffer( const std::string& fileName,
+                                      const size_t       bufferSize )
+    : mBuffer( bufferSize ) {
+  // Duplicated, so closing it doesn't close stdout
+  mFd = fileName == "-"
+          ? dup( STDOUT_FILENO )
+          : open( fileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+  setp( mBuffer.data(), mBuffer.data() + mBuffer.size() );
+}
+
+BufferedOutputStream::Buffer::~Buffer() {
+  if( mFd != -1 ) {
+    Write( NULL, 0 );
+    close( mFd );
+  }
+}
+
+bool BufferedOutputStream::Buffer::IsOpen() const {
+  return mFd != -1;
+}
+
+BufferedOutputStream::Buffer::int_type
+BufferedOutputStream::Buffer::overflow( int_type ch ) {
+  if( !Write( NULL, 0 ) )
+    return traits_type::eof();
+
+  if( !traits_type::eq_int_type( ch, traits_type::eof() ) ) {
+    *pptr() = traits_type::to_char_type( ch );
+    pbump( 1 );
+  }
+  return traits_type::not_eof( ch );
+}
+
+std::streamsize BufferedOutputStream::Buffer::xsputn( const char*     data,
+                                                      std::streamsize count ) {
+  if( count <= epptr() - pptr() ) {
+    memcpy( pptr(), data, count );
+    pbump( count );
+    return count;
+  }
+
+  return Write( data, count ) ? count : 0;
+}
+
+int BufferedOutputStream::Buffer::sync() {
+  return 0; // written when the buffer is full
+}
+
+bool BufferedOutputStream::Buffer::Write( const char* data,
+                                          const size_t size ) {
+  if( mFd == -1 )
+    return false;
+
+  struct iovec iov[ 2 ];
+  iov[ 0 ].iov_base = pbase();
+  iov[ 0 ].iov_len  = pptr() - pbase();
+  iov[ 1 ].iov_base = ( void* ) data;
+  iov[ 1 ].iov_len  = size;
+
+  // Resume after partial writes
+  int first = 0;
+  while( first < 2 ) {
+    if( iov[ first ].iov_len == 0 ) {
+      first++;
+      continue;
+    }
+
+    ssize_t ret = writev( mFd, iov + first, 2 - first );
+    if( ret < 0 ) {
+      if( errno == EINTR )
+        continue;
+      return false;
+    }
+
+    size_t numBytes = ret;
+    while( first < 2 && numBytes >= iov[ first ].iov_len ) {
+      numBytes -= iov[ first ].iov_len;
+      first++;
+    }
+    if( first < 2 ) {
+      iov[ first ].iov_base = ( char* ) iov[ first ].iov_base + numBytes;
+      iov[ first ].iov_len -= numBytes;
+    }
+  }
+
+  setp( mBuffer.data(), mBuffer.data() + mBuffer.size() );
+  return true;
+}
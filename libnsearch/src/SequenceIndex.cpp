@@ -0,0 +1,211 @@
+#include "nsearch/SequenceIndex.h"
+#include "nsearch/TextReader.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+// Lines of a text reader along with their offset in the text
+class LineScanner {
+public:
+  LineScanner( TextReader* reader )
+      : mReader( reader ), mPos( 0 ), mOffset( 0 ) {}
+
+  // width includes the '\n'
+  bool Next( LineView* line, size_t* offset, size_t* width ) {
+    bool partial = false;
+    *offset      = mOffset;
+
+    while( true ) {
+      if( mPos >= mChunk.length ) {
+        if( mReader->EndOfFile() ) {
+          if( !partial )
+            return false;
+          break;
+        }
+
+        mChunk = mReader->ReadChunk();
+        mPos   = 0;
+        continue;
+      }
+
+      const char* start = mChunk.data + mPos;
+      const char* end =
+        ( const char* ) memchr( start, '\n', mChunk.length - mPos );
+      size_t numBytes = end ? end - start : mChunk.length - mPos;
+      mPos += numBytes + ( end ? 1 : 0 );
+      mOffset += numBytes + ( end ? 1 : 0 );
+
+      // Most lines are within the chunk, only lines cut by its end are copied
+      if( end && !partial ) {
+        *line  = LineView( start, numBytes );
+        *width = numBytes + 1;
+        return true;
+      }
+
+      if( !partial )
+        mLine.clear();
+      mLine.append( start, numBytes );
+      partial = true;
+
+      if( end )
+        break;
+    }
+
+    *line  = LineView( mLine );
+    *width = mOffset - *offset;
+    return true;
+  }
+
+  size_t Offset() const {
+    return mOffset;
+  }
+
+private:
+  TextReader* mReader;
+  LineView    mChunk;
+  size_t      mPos, mOffset;
+  std::string mLine;
+};
+
+static bool IsBlank( const LineView& line ) {
+  return std::all_of( line.data, line.data + line.length, []( const char ch ) {
+    return isspace( ( unsigned char ) ch );
+  } );
+}
+
+static std::string Name( const LineView& line ) {
+  const char* start = line.data + 1; // skip '>' or '@'
+  const char* end   = line.data + line.length;
+  return std::string( start, std::find_if( start, end, []( const char ch ) {
+                        return isspace( ( unsigned char ) ch );
+                      } ) );
+}
+
+void SequenceIndex::Clear() {
+  mRecords.clear();
+  mNames.clear();
+  mNumBytes = 0;
+}
+
+void SequenceIndex::Add( const Record& record ) {
+  mNames.emplace( record.name, mRecords.size() );
+  mRecords.push_back( record );
+}
+
+bool SequenceIndex::Build( const std::string& pathToFile ) {
+  Clear();
+
+  // Not mapped: a mapped file skips leading blank lines, which would shift
+  // the offsets
+  TextFileReader reader( pathToFile, 256 * 1024, 3 );
+  LineScanner    lines( &reader );
+
+  LineView line;
+  size_t   offset, width;
+  char     format   = 0;
+  size_t   lineNum  = 0;     // within the record
+  bool     lastLine = false; // a sequence line shorter than the others
+  Record   record;
+
+  while( lines.Next( &line, &offset, &width ) ) {
+    if( IsBlank( line ) ) {
+      lastLine = true;
+      continue;
+    }
+
+    if( !format ) {
+      format = line[ 0 ];
+      if( format != '>' && format != '@' )
+        return false;
+    }
+
+    // FASTQ records are four lines, the same as FASTQ::Parser reads
+    bool header = format == '>' ? line[ 0 ] == '>' : lineNum % 4 == 0;
+    if( header ) {
+      if( line[ 0 ] != format )
+        return false;
+
+      if( lineNum > 0 )
+        Add( record );
+
+      record        = Record();
+      record.name   = Name( line );
+      record.offset = offset;
+      lineNum       = 1;
+      lastLine      = false;
+      continue;
+    }
+
+    if( format == '@' && lineNum == 2 ) {
+      if( line[ 0 ] != '+' )
+        return false;
+    } else if( format == '@' && lineNum == 3 ) {
+      record.qualityOffset = offset;
+    } else if( record.length == 0 && lineNum == 1 ) {
+      record.sequenceOffset = offset;
+      record.lineBases      = line.length;
+      record.lineWidth      = width;
+      record.length         = line.length;
+      lastLine              = false;
+    } else {
+      // Only the last line may be shorter
+      if( lastLine || line.length > record.lineBases ||
+          width - line.length != record.lineWidth - record.lineBases ) {
+        record.lineBases = record.lineWidth = 0;
+      }
+      lastLine = line.length < record.lineBases;
+      record.length += line.length;
+    }
+    lineNum++;
+  }
+
+  if( lineNum > 0 )
+    Add( record );
+
+  mNumBytes = lines.Offset();
+  return format != 0;
+}
+
+bool SequenceIndex::Read( const std::string& pathToIndex ) {
+  Clear();
+
+  std::ifstream file( pathToIndex );
+  if( !file )
+    return false;
+
+  std::string line;
+  if( !std::getline( file, line ) || line.compare( 0, 1, "#" ) != 0 )
+    return false;
+
+  // Header: "#<number of bytes>"
+  mNumBytes = strtoull( line.c_str() + 1, NULL, 10 );
+
+  while( std::getline( file, line ) ) {
+    std::istringstream fields( line );
+    Record             record;
+    if( !std::getline( fields, record.name, '\t' ) )
+      return false;
+
+    if( !( fields >> record.length >> record.offset >> record.sequenceOffset >>
+           record.lineBases >> record.lineWidth >> record.qualityOffset ) )
+      return false;
+
+    Add( record );
+  }
+
+  return true;
+}
+
+bool SequenceIndex::Write( const std::string& pathToIndex ) const {
+  std::ofstream file( pathToIndex );
+  file << '#' << mNumBytes << '\n';
+  for( auto& record : mRecords ) {
+    file << record.name << '\t' << record.length << '\t' << record.offset
+         << '\t' << record.sequenceOffset << '\t' << record.lineBases << '\t'
+         << record.lineWidth << '\t' << record.qualityOffset << '\n';
+  }
+  return bool( file );
+}
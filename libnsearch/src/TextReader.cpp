@@ -1,4 +1,5 @@
 #include "nsearch/TextReader.h"
+#include "nsearch/BGZF.h"
 #include "nsearch/Utils.h"
 
 #include <fcntl.h>
@@ -8,6 +9,8 @@
 #include <cstring>
 
 #ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 #else
 #include "winstd.h"
@@ -16,15 +19,21 @@
 /*
  * TextStreamReader
  */
-TextStreamReader::TextStreamReader( std::istream& is ) : mInput( is ) {
-  mInput.seekg( 0, mInput.end );
-  mTotalBytes = mInput.tellg();
-  mInput.seekg( 0, mInput.beg );
+TextStreamReader::TextStreamReader( std::istream& is )
+    : mInput( is ), mTotalBytes( 0 ), mNumBytesRead( 0 ) {
+  // Ask the buffer, seekg would fail the stream if it can't seek
+  std::streambuf* buf   = mInput.rdbuf();
+  std::streampos  start = buf->pubseekoff( 0, mInput.cur, mInput.in );
+  if( start >= 0 ) {
+    std::streampos end = buf->pubseekoff( 0, mInput.end, mInput.in );
+    buf->pubseekpos( start, mInput.in );
+    if( end >= start )
+      mTotalBytes = end - start;
+  }
 }
 
 size_t TextStreamReader::NumBytesRead() const {
-  std::streampos pos = mInput.tellg();
-  return pos < 0 ? mTotalBytes : pos;
+  return mNumBytesRead;
 }
 
 size_t TextStreamReader::NumBytesTotal() const {
@@ -42,59 +51,211 @@ inline bool IsBlank( const std::string& str ) {
 void TextStreamReader::operator>>( std::string& str ) {
   do {
     getline( mInput, str );
+    mNumBytesRead += str.size() + ( mInput.eof() ? 0 : 1 );
   } while( !EndOfFile() && IsBlank( str ) );
 }
 
+LineView TextStreamReader::ReadChunk() {
+  mLine.resize( 64 * 1024 );
+  mInput.read( &mLine[ 0 ], mLine.size() );
+  mLine.resize( mInput.gcount() );
+  mNumBytesRead += mLine.size();
+  return LineView( mLine );
+}
+
 /*
  * TextFileReader
  */
-void TextFileReader::NextBuffer() {
+size_t TextFileReader::Read( char* buffer ) {
+  ssize_t numBytes;
 #ifdef USE_ZLIB
   if( mGzFile ) {
-    mBufferSize = gzread( mGzFile, mBuffer, mTotalBufferSize );
+    numBytes = gzread( mGzFile, buffer, mTotalBufferSize );
+
+    // Truncated input ends without error, but sets Z_BUF_ERROR
+    int error = Z_OK;
+    if( numBytes <= 0 )
+      gzerror( mGzFile, &error );
+    if( error != Z_OK )
+      mFailed = true;
   } else
 #endif
   {
-    mBufferSize = read( mFd, mBuffer, mTotalBufferSize );
+    numBytes = read( mFd, buffer, mTotalBufferSize );
+    if( numBytes < 0 )
+      mFailed = true;
   }
 
+  return numBytes > 0 ? numBytes : 0;
+}
+
+// With keepCurrent, the current read-ahead buffer isn't reused before the
+// next call
+void TextFileReader::NextBuffer( const bool keepCurrent ) {
   mBufferPos = 0;
+
+#ifdef USE_ZLIB
+  if( mBGZF ) {
+    mBufferSize = mBGZF->NextBlock( &mBuffer );
+    if( mBufferSize > 0 )
+      return;
+
+    // Any gzip members following the BGZF blocks are inflated by zlib
+    int64_t offset = mBGZF->PlainGzipOffset();
+    mFailed        = mBGZF->Corrupt();
+    mBGZF.reset();
+    if( offset < 0 )
+      return;
+
+    if( lseek( mFd, offset, SEEK_SET ) != offset ||
+        !( mGzFile = gzdopen( mFd, "rb" ) ) ) {
+      mFailed = true;
+      return;
+    }
+    mBuffer = mBuffers[ 0 ].data();
+  }
+#endif
+
+  if( !mReadAheadThread.joinable() ) {
+    mBufferSize = Read( mBuffer );
+    mNumBytesConsumed += mBufferSize;
+    return;
+  }
+
+  // The read-ahead thread stops after the last (empty) buffer
+  if( mCurrentBuffer < mBuffers.size() && mBufferSize == 0 )
+    return;
+
+  std::unique_lock< std::mutex > lock( mMutex );
+  if( mKeptBuffer < mBuffers.size() ) {
+    mFreeBuffers.push( mKeptBuffer );
+    mFreeCondition.notify_one();
+    mKeptBuffer = -1;
+  }
+
+  if( mCurrentBuffer < mBuffers.size() ) {
+    if( keepCurrent ) {
+      mKeptBuffer = mCurrentBuffer;
+    } else {
+      mFreeBuffers.push( mCurrentBuffer );
+      mFreeCondition.notify_one();
+    }
+  }
+
+  while( mFilledBuffers.empty() )
+    mFilledCondition.wait( lock );
+
+  mCurrentBuffer = mFilledBuffers.front();
+  mFilledBuffers.pop();
+
+  mBuffer     = mBuffers[ mCurrentBuffer ].data();
+  mBufferSize = mBufferSizes[ mCurrentBuffer ];
+  mNumBytesConsumed += mBufferSize;
+}
+
+void TextFileReader::ReadAhead() {
+  while( true ) {
+    size_t index;
+    { // acquire lock
+      std::unique_lock< std::mutex > lock( mMutex );
+
+      while( !mStop && mFreeBuffers.empty() )
+        mFreeCondition.wait( lock );
+
+      if( mStop )
+        break;
+
+      index = mFreeBuffers.front();
+      mFreeBuffers.pop();
+    } // release lock
+
+    size_t numBytes = Read( mBuffers[ index ].data() );
+
+    { // acquire lock
+      std::unique_lock< std::mutex > lock( mMutex );
+      mBufferSizes[ index ] = numBytes;
+      mFilledBuffers.push( index );
+    } // release lock
+    mFilledCondition.notify_one();
+
+    if( numBytes == 0 )
+      break;
+  }
 }
 
 TextFileReader::TextFileReader( const std::string& fileName,
-                                const size_t       totalBufferSize )
+                                const size_t       totalBufferSize,
+                                const size_t       numReadAheadBuffers )
     : mBufferPos( -1 ), mBufferSize( 0 ), mTotalBufferSize( totalBufferSize ),
-      mBuffer( NULL ) {
-  mFd = open( fileName.c_str(), O_RDONLY ); // orly?
+      mBuffer( NULL ), mTotalBytes( 0 ), mNumBytesConsumed( 0 ),
+      mFailed( false ), mCurrentBuffer( -1 ), mKeptBuffer( -1 ),
+      mStop( false ) {
+  // Duplicated, so closing it doesn't close stdin
+  mFd = fileName == "-" ? dup( STDIN_FILENO )
+                        : open( fileName.c_str(), O_RDONLY );
 
   if( mFd != -1 ) {
+    off_t end      = lseek( mFd, 0, SEEK_END );
+    bool  seekable = end >= 0 && lseek( mFd, 0, SEEK_SET ) == 0;
+    if( seekable )
+      mTotalBytes = end;
+
 #ifdef USE_ZLIB
     mGzFile = NULL;
 
-    // Check for GZ magic number
-    uint8_t magic[ 2 ] = { 0, 0 };
-    read( mFd, magic, 2 );
-    lseek( mFd, 0, SEEK_SET );
+    // Check for GZ magic number. zlib reads uncompressed pipes as they are
+    uint8_t magic[ 2 ] = { 0x1F, 0x8B };
+    if( seekable ) {
+      magic[ 0 ] = magic[ 1 ] = 0;
+      read( mFd, magic, 2 );
+      lseek( mFd, 0, SEEK_SET );
+    }
     if( magic[ 0 ] == 0x1F && magic[ 1 ] == 0x8B ) {
-      mGzFile = gzdopen( mFd, "rb" );
+      if( seekable && numReadAheadBuffers > 0 &&
+          BGZFDecompressor::IsBGZF( mFd ) ) {
+        mBGZF.reset( new BGZFDecompressor(
+          mFd, std::max( std::thread::hardware_concurrency(), 1u ) ) );
+      } else {
+        mGzFile = gzdopen( mFd, "rb" );
+      }
     }
 #endif
-    mBuffer = new char[ totalBufferSize ];
+    size_t numBuffers = std::max( numReadAheadBuffers, size_t( 1 ) );
+    mBuffers.resize( numBuffers, std::vector< char >( totalBufferSize ) );
+    mBufferSizes.resize( numBuffers, 0 );
 
-    mTotalBytes = lseek( mFd, 0, SEEK_END );
-    lseek( mFd, 0, SEEK_SET );
+#ifdef USE_ZLIB
+    const bool readAhead = numReadAheadBuffers > 0 && !mBGZF;
+#else
+    const bool readAhead = numReadAheadBuffers > 0;
+#endif
+    if( readAhead ) {
+      for( size_t i = 0; i < numBuffers; i++ ) {
+        mFreeBuffers.push( i );
+      }
+      mReadAheadThread = std::thread( &TextFileReader::ReadAhead, this );
+    } else {
+      mBuffer = mBuffers[ 0 ].data();
+    }
 
     NextBuffer();
   }
 }
 
 TextFileReader::~TextFileReader() {
-  if( mBuffer ) {
-    delete[] mBuffer;
+  if( mReadAheadThread.joinable() ) {
+    { // acquire lock
+      std::unique_lock< std::mutex > lock( mMutex );
+      mStop = true;
+    } // release lock
+    mFreeCondition.notify_one();
+    mReadAheadThread.join();
   }
 
   if( mFd != -1 ) {
 #ifdef USE_ZLIB
+    mBGZF.reset(); // stop inflating before closing the file
+
     if( mGzFile ) {
       gzclose( mGzFile );
     } else
@@ -131,12 +292,35 @@ ReadLine:
     goto ReadLine;
 }
 
+LineView TextFileReader::ReadChunk() {
+  if( EndOfFile() )
+    return LineView();
+
+  // A read-ahead buffer is kept until the next read (while the thread fills
+  // the others), other buffers are overwritten by it and copied out
+  if( mReadAheadThread.joinable() && mBuffers.size() > 1 ) {
+    LineView chunk( mBuffer + mBufferPos, mBufferSize - mBufferPos );
+    NextBuffer( true );
+    return chunk;
+  }
+
+  mLine.assign( mBuffer + mBufferPos, mBufferSize - mBufferPos );
+  NextBuffer();
+  return LineView( mLine );
+}
+
 bool TextFileReader::EndOfFile() const {
   return mFd == -1 || mBufferSize <= 0;
 }
 
+bool TextFileReader::Failed() const {
+  return mFailed;
+}
+
 size_t TextFileReader::NumBytesRead() const {
-  if( EndOfFile() ) {
+  if( mTotalBytes <= 0 ) {
+    return mNumBytesConsumed;
+  } else if( EndOfFile() ) {
     return mTotalBytes;
   } else {
     return lseek( mFd, 0, SEEK_CUR );
@@ -146,3 +330,213 @@ size_t TextFileReader::NumBytesRead() const {
 size_t TextFileReader::NumBytesTotal() const {
   return mTotalBytes;
 }
+
+/*
+ * MappedTextFileReader
+ */
+#ifndef _WIN32
+MappedTextFileReader::MappedTextFileReader( const std::string& fileName,
+                                            const size_t       begin,
+                                            const size_t       end )
+    : mData( NULL ), mMappedSize( 0 ), mBegin( 0 ), mSize( 0 ), mPos( 0 ) {
+  int fd = open( fileName.c_str(), O_RDONLY );
+  if( fd == -1 )
+    return;
+
+  struct stat st;
+  if( fstat( fd, &st ) == 0 && S_ISREG( st.st_mode ) && st.st_size > 0 ) {
+    void* data = mmap( NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+    if( data != MAP_FAILED ) {
+      mData       = ( const char* ) data;
+      mMappedSize = st.st_size;
+      madvise( data, mMappedSize, MADV_SEQUENTIAL );
+    }
+  }
+  close( fd ); // the mapping stays valid
+
+  // Compressed files have to be read through zlib
+  if( mMappedSize >= 2 && uint8_t( mData[ 0 ] ) == 0x1F &&
+      uint8_t( mData[ 1 ] ) == 0x8B ) {
+    munmap( ( void* ) mData, mMappedSize );
+    mData       = NULL;
+    mMappedSize = 0;
+  }
+
+  mSize  = std::min( end, mMappedSize );
+  mBegin = mPos = std::min( begin, mSize );
+  SkipBlankLines();
+}
+
+MappedTextFileReader::~MappedTextFileReader() {
+  if( mData ) {
+    munmap( ( void* ) mData, mMappedSize );
+  }
+}
+
+bool MappedTextFileReader::IsMapped() const {
+  return mData != NULL;
+}
+
+void MappedTextFileReader::SkipBlankLines() {
+  while( mPos < mSize ) {
+    size_t pos = mPos;
+    while( pos < mSize && mData[ pos ] != '\n' &&
+           isspace( ( unsigned char ) mData[ pos ] ) )
+      pos++;
+
+    if( pos < mSize && mData[ pos ] != '\n' )
+      break;
+
+    mPos = std::min( pos + 1, mSize ); // skip '\n'
+  }
+}
+
+LineView MappedTextFileReader::ReadLine() {
+  if( EndOfFile() )
+    return LineView();
+
+  const char* line = mData + mPos;
+  const char* end  = ( const char* ) memchr( line, '\n', mSize - mPos );
+
+  size_t numBytes = end ? end - line : mSize - mPos;
+  mPos            = std::min( mPos + numBytes + 1, mSize ); // skip '\n'
+  SkipBlankLines();
+
+  return LineView( line, numBytes );
+}
+
+LineView MappedTextFileReader::ReadChunk() {
+  size_t   numBytes = std::min( mSize - mPos, size_t( 1024 * 1024 ) );
+  LineView chunk( mData + mPos, numBytes );
+  mPos += numBytes;
+  return chunk;
+}
+
+void MappedTextFileReader::operator>>( std::string& str ) {
+  LineView line = ReadLine();
+  str.assign( line.data, line.length );
+}
+
+bool MappedTextFileReader::EndOfFile() const {
+  return mPos >= mSize;
+}
+
+size_t MappedTextFileReader::NumBytesRead() const {
+  return mPos - mBegin;
+}
+
+size_t MappedTextFileReader::NumBytesTotal() const {
+  return mSize - mBegin;
+}
+#endif
+
+/*
+ * TextRangeReader
+ */
+TextRangeReader::TextRangeReader( std::unique_ptr< TextReader > reader,
+                                  const size_t begin, const size_t end )
+    : mReader( std::move( reader ) ), mBegin( begin ), mEnd( end ), mPos( 0 ),
+      mNumBytesRead( 0 ) {
+  NextChunk();
+}
+
+void TextRangeReader::NextChunk() {
+  mChunk = LineView();
+  while( mChunk.empty() && mPos < mEnd && !mReader->EndOfFile() ) {
+    LineView chunk = mReader->ReadChunk();
+    size_t   start = mPos;
+    mPos += chunk.length;
+
+    size_t from = mBegin > start ? std::min( mBegin - start, chunk.length ) : 0;
+    size_t to   = std::min( chunk.length, mEnd - start );
+    if( from < to )
+      mChunk = LineView( chunk.data + from, to - from );
+  }
+}
+
+size_t TextRangeReader::NumBytesRead() const {
+  return mNumBytesRead;
+}
+
+size_t TextRangeReader::NumBytesTotal() const {
+  return mEnd != size_t( -1 ) ? mEnd - mBegin : 0;
+}
+
+bool TextRangeReader::EndOfFile() const {
+  return mChunk.empty() && ( mPos >= mEnd || mReader->EndOfFile() );
+}
+
+void TextRangeReader::operator>>( std::string& str ) {
+  str.clear();
+  while( !EndOfFile() ) {
+    if( mChunk.empty() ) {
+      NextChunk();
+      continue;
+    }
+
+    const char* pos =
+      ( const char* ) memchr( mChunk.data, '\n', mChunk.length );
+    size_t numBytes = pos ? pos - mChunk.data : mChunk.length;
+    str.append( mChunk.data, numBytes );
+
+    numBytes = std::min( numBytes + 1, mChunk.length ); // skip '\n'
+    mChunk   = LineView( mChunk.data + numBytes, mChunk.length - numBytes );
+    mNumBytesRead += numBytes;
+
+    if( pos != NULL ) {
+      if( !IsBlank( str ) )
+        break;
+      str.clear();
+    }
+  }
+}
+
+LineView TextRangeReader::ReadChunk() {
+  if( mChunk.empty() )
+    NextChunk();
+
+  LineView chunk = mChunk;
+  mChunk         = LineView();
+  mNumBytesRead += chunk.length;
+  return chunk;
+}
+
+// The mapped file if it can be mapped, otherwise NULL
+static std::unique_ptr< TextReader > MapTextFile( const std::string& fileName,
+                                                  const size_t       begin,
+                                                  const size_t       end ) {
+  std::unique_ptr< TextReader > reader;
+#ifndef _WIN32
+  if( fileName != "-" ) {
+    MappedTextFileReader* mapped =
+      new MappedTextFileReader( fileName, begin, end );
+    reader.reset( mapped );
+    if( !mapped->IsMapped() )
+      reader.reset();
+  }
+#endif
+  return reader;
+}
+
+std::unique_ptr< TextReader > OpenTextFile( const std::string& fileName ) {
+  std::unique_ptr< TextReader > reader =
+    MapTextFile( fileName, 0, size_t( -1 ) );
+  if( reader )
+    return reader;
+
+  // Decompress on a separate thread, triple buffered
+  return std::unique_ptr< TextReader >(
+    new TextFileReader( fileName, 256 * 1024, 3 ) );
+}
+
+std::unique_ptr< TextReader > OpenTextFile( const std::string& fileName,
+                                            const size_t       begin,
+                                            const size_t       end ) {
+  std::unique_ptr< TextReader > reader = MapTextFile( fileName, begin, end );
+  if( reader )
+    return reader;
+
+  reader.reset( new TextFileReader( fileName, 256 * 1024, 3 ) );
+  return std::unique_ptr< TextReader >(
+    new TextRangeReader( std::move( reader ), begin, end ) );
+}
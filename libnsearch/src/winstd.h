@@ -21,6 +21,10 @@
 #define write _write
 #define open _open
 #define close _close
+#define dup _dup
+
+#define STDIN_FILENO 0
+#define STDOUT_FILENO 1
 /* read, write, and close are NOT being #defined here, because while there are file handle specific versions for Windows, they probably don't work for sockets. You need to look at your app and consider whether to call e.g. closesocket(). */
 
 #ifdef _WIN64
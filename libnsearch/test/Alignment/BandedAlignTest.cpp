@@ -138,4 +138,47 @@ TEST_CASE( "BandedAlign" ) {
     REQUIRE( cigar1.ToString() == cigar2.ToString() );
     REQUIRE( score1 == score2 );
   }
+
+  SECTION( "Long sequences" ) {
+    // Traceback information is kept for the band only
+    std::string seq;
+    for( int i = 0; i < 20000; i++ ) {
+      seq += "ACGT"[ ( i * 7 + i / 3 ) % 4 ];
+    }
+    std::string mutated = seq;
+    mutated[ 5000 ]     = mutated[ 5000 ] == 'A' ? 'C' : 'A';
+    mutated.erase( 12000, 3 );
+
+    BandedAlign< DNA > ba;
+    ba.Align( Sequence< DNA >( seq ), Sequence< DNA >( mutated ), &cigar );
+    REQUIRE( cigar.ToString() == "5000=1X6999=3I7997=" );
+  }
+
+  SECTION( "Max differences" ) {
+    // Align the interior of the sequences, so no gaps are terminal
+    Sequence< DNA >    a = "GTATAATGTTTACATTGGA";
+    Sequence< DNA >    b = "GTATAATGACACTGGA";
+    BandedAlign< DNA > ba;
+
+    // 13 matches and 4 differences: identity 13/17 is above 0.75...
+    int score = ba.Align( a, b, &cigar, AlignmentDirection::Forward, 1, 1, 18,
+                          15, 0.0, 1.0 / 3.0 );
+    REQUIRE( score != ba.Rejected() );
+    REQUIRE( cigar.ToString() == "7=3I3=1X3=" );
+
+    // ...but below 0.8
+    REQUIRE( ba.Align( a, b, &cigar, AlignmentDirection::Forward, 1, 1, 18, 15,
+                       0.0, 0.25 ) == ba.Rejected() );
+    REQUIRE( cigar.ToString() == "" );
+
+    // Unless there is room for more differences elsewhere
+    REQUIRE( ba.Align( a, b, &cigar, AlignmentDirection::Forward, 1, 1, 18, 15,
+                       1.0, 0.25 ) == score );
+
+    // Terminal gaps don't count
+    REQUIRE( ba.Align( "ATCGGGGGGGGGGGGGGGGGGGGGGG", "CGG", &cigar,
+                       AlignmentDirection::Forward, 0, 0, -1, -1, 0.0,
+                       0.0 ) != ba.Rejected() );
+    REQUIRE( cigar.ToString() == "2I3=21I" );
+  }
 }
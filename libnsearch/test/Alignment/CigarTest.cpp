@@ -27,5 +27,63 @@ TEST_CASE( "CigarTest" ) {
     REQUIRE( Cigar( "50I14=2X4=25D" ).Identity() == float( 18 ) / float( 20 ) );
     REQUIRE( Cigar( "2=" ).Identity() == 1.0f );
     REQUIRE( Cigar( "1X1=" ).Identity() == 0.5f );
+    REQUIRE( Cigar( "5I" ).Identity() == 0.0f );
+    REQUIRE( Cigar().Identity() == 0.0f );
+
+    Cigar cigar( "3D4=1X3=2I" );
+    REQUIRE( cigar.Identity() == float( 7 ) / float( 8 ) );
+    cigar.pop_front();
+    cigar.pop_back();
+    cigar.pop_back();
+    REQUIRE( cigar.Identity() == float( 4 ) / float( 5 ) );
+  }
+
+  SECTION( "Concatenating" ) {
+    Cigar cigar( "3=1X" );
+    cigar += Cigar( "2X5=" );
+    cigar += Cigar();
+    REQUIRE( cigar.ToString() == "3=3X5=" );
+    REQUIRE( cigar.size() == 3 );
+    REQUIRE( cigar.Identity() == float( 8 ) / float( 11 ) );
+
+    REQUIRE( ( Cigar( "1I" ) + Cigar( "2I1D" ) ).ToString() == "3I1D" );
+
+    // With itself, also growing past the inline buffer
+    Cigar twice( "2=1X1=" );
+    twice += twice;
+    REQUIRE( twice.ToString() == "2=1X3=1X1=" );
+    REQUIRE( twice.Identity() == float( 6 ) / float( 8 ) );
+    twice += twice;
+    REQUIRE( twice.ToString() == "2=1X3=1X3=1X3=1X1=" );
+  }
+
+  SECTION( "Long cigars" ) {
+    // Beyond the inline buffer
+    Cigar       cigar;
+    std::string expected;
+    for( int i = 1; i <= 100; i++ ) {
+      cigar.Add( { i, i % 2 ? CigarOp::Match : CigarOp::Insertion } );
+      expected += std::to_string( i ) + ( i % 2 ? "=" : "I" );
+    }
+    REQUIRE( cigar.ToString() == expected );
+
+    Cigar copy = cigar;
+    REQUIRE( copy.ToString() == expected );
+
+    Cigar moved = std::move( copy );
+    REQUIRE( moved.ToString() == expected );
+    REQUIRE( moved.Identity() == cigar.Identity() );
+
+    cigar.Reverse();
+    REQUIRE( cigar.front() == CigarEntry( 100, CigarOp::Insertion ) );
+    REQUIRE( cigar.back() == CigarEntry( 1, CigarOp::Match ) );
+  }
+
+  SECTION( "BAM encoding" ) {
+    Cigar cigar( "5=10I2D1X" );
+    REQUIRE( cigar.data()[ 0 ] == ( 5 << 4 | 7 ) );
+    REQUIRE( cigar.data()[ 1 ] == ( 10 << 4 | 1 ) );
+    REQUIRE( cigar.data()[ 2 ] == ( 2 << 4 | 2 ) );
+    REQUIRE( cigar.data()[ 3 ] == ( 1 << 4 | 8 ) );
   }
 }
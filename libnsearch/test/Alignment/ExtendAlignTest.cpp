@@ -1,9 +1,12 @@
 #include <catch.hpp>
 
 #include <nsearch/Alignment/ExtendAlign.h>
+#include <nsearch/Alignment/ExtendAlignSIMD.h>
 #include <nsearch/Alphabet/DNA.h>
 #include <nsearch/Sequence.h>
 
+#include <random>
+
 TEST_CASE( "ExtendAlign" ) {
   size_t bestA, bestB;
   Cigar  cigar;
@@ -65,4 +68,158 @@ TEST_CASE( "ExtendAlign" ) {
     REQUIRE( bestA == 1 );
     REQUIRE( bestB == 0 );
   }
+
+  SECTION( "Long sequences" ) {
+    // Traceback information is kept for the explored cells only
+    std::string seq;
+    for( int i = 0; i < 20000; i++ ) {
+      seq += "ACGT"[ ( i * 7 + i / 3 ) % 4 ];
+    }
+    std::string mutated = seq;
+    mutated.erase( 12000, 3 );
+
+    score = ea.Extend( Sequence< DNA >( seq ), Sequence< DNA >( mutated ),
+                       &bestA, &bestB, &cigar );
+    REQUIRE( bestA == 19999 );
+    REQUIRE( bestB == 19996 );
+    REQUIRE( cigar.ToString() == "12000=3I7997=" );
+  }
+}
+
+TEST_CASE( "ExtendAlignSIMD" ) {
+  size_t bestA, bestB;
+  Cigar  cigar;
+  int    score;
+
+  ExtendAlignSIMD< DNA > esa;
+
+  SECTION( "Gaps" ) {
+    Sequence< DNA > a = "GATTGCGGGG";
+    Sequence< DNA > b = "GAGCGGT";
+
+    score = esa.Extend( a, b, &bestA, &bestB, &cigar,
+                        AlignmentDirection::Forward, 0, 0 );
+    REQUIRE( cigar.ToString() == "2=" );
+
+    ExtendAlignParams eap;
+    eap.gapOpenScore = eap.gapExtendScore - 1;
+
+    esa   = ExtendAlignSIMD< DNA >( eap );
+    score = esa.Extend( a, b, &bestA, &bestB, &cigar,
+                        AlignmentDirection::Forward, 0, 0 );
+    REQUIRE( cigar.ToString() == "2=2I4=" );
+  }
+
+  SECTION( "Forwards and backwards extend" ) {
+    Sequence< DNA > a = "ATCGG";
+    Sequence< DNA > b = "ATCGT";
+
+    score = esa.Extend( a, b, &bestA, &bestB, &cigar,
+                        AlignmentDirection::Forward, 0, 0 );
+    REQUIRE( score == 8 );
+    REQUIRE( bestA == 3 );
+    REQUIRE( bestB == 3 );
+    REQUIRE( cigar.ToString() == "4=" );
+
+    score = esa.Extend( a, b, &bestA, &bestB, &cigar,
+                        AlignmentDirection::Forward, 4, 4 );
+    REQUIRE( score == 0 );
+    REQUIRE( bestA == 4 );
+    REQUIRE( bestB == 4 );
+    REQUIRE( cigar.ToString() == "" );
+
+    a = "ATCGGTTG";
+    b = "TCGGTAT";
+
+    score = esa.Extend( a, b, &bestA, &bestB, &cigar,
+                        AlignmentDirection::Reverse, 3, 2 );
+    REQUIRE( bestA == 1 );
+    REQUIRE( bestB == 0 );
+    REQUIRE( cigar.ToString() == "2=" );
+  }
+
+  SECTION( "Ambiguous nucleotides" ) {
+    // N scores differently against each nucleotide, the substitution
+    // scores are looked up per cell
+    Sequence< DNA > a = "ATCGNNATCGAT";
+    Sequence< DNA > b = "ATCGAAATCGAT";
+
+    ExtendAlign< DNA > ea;
+    score = esa.Extend( a, b, &bestA, &bestB, &cigar );
+    REQUIRE( score == ea.Extend( a, b ) );
+    REQUIRE( bestA == 11 );
+    REQUIRE( bestB == 11 );
+    REQUIRE( cigar.ToString() == "12=" );
+  }
+
+  SECTION( "Long sequences" ) {
+    std::string seq;
+    for( int i = 0; i < 20000; i++ ) {
+      seq += "ACGT"[ ( i * 7 + i / 3 ) % 4 ];
+    }
+    std::string mutated = seq;
+    mutated.erase( 12000, 3 );
+
+    score = esa.Extend( Sequence< DNA >( seq ), Sequence< DNA >( mutated ),
+                        &bestA, &bestB, &cigar );
+    REQUIRE( bestA == 19999 );
+    REQUIRE( bestB == 19996 );
+    REQUIRE( cigar.ToString() == "12000=3I7997=" );
+  }
+
+  SECTION( "Same results as ExtendAlign" ) {
+    // Without any cells dropped, both explore the whole matrix
+    ExtendAlignParams unbounded;
+    unbounded.xDrop = 100000;
+
+    ExtendAlign< DNA >     ea, eaUnbounded( unbounded );
+    ExtendAlignSIMD< DNA > esaUnbounded( unbounded );
+
+    std::mt19937 rng( 42 );
+    const char*  nucleotides = "ACGTN";
+
+    for( int i = 0; i < 500; i++ ) {
+      size_t      numLetters = ( i % 5 == 0 ) ? 5 : 4;
+      std::string a, b;
+      for( size_t len = 1 + rng() % 200; a.size() < len; ) {
+        a += nucleotides[ rng() % numLetters ];
+      }
+
+      b = a;
+      for( size_t edits = rng() % 10; edits > 0; edits-- ) {
+        size_t pos    = rng() % b.size();
+        char   letter = nucleotides[ rng() % numLetters ];
+        switch( rng() % 3 ) {
+          case 0: b[ pos ] = letter; break;
+          case 1: b.insert( pos, 1, letter ); break;
+          default: b.erase( pos, 1 ); break;
+        }
+        if( b.empty() )
+          b = letter;
+      }
+
+      Sequence< DNA >    A( a ), B( b );
+      AlignmentDirection dir = ( i % 2 ) ? AlignmentDirection::Forward
+                                         : AlignmentDirection::Reverse;
+      size_t startA = ( dir == AlignmentDirection::Forward ) ? 0 : a.size();
+      size_t startB = ( dir == AlignmentDirection::Forward ) ? 0 : b.size();
+
+      size_t refBestA, refBestB;
+      Cigar  refCigar;
+      int    refScore = eaUnbounded.Extend( A, B, &refBestA, &refBestB,
+                                         &refCigar, dir, startA, startB );
+      score = esaUnbounded.Extend( A, B, &bestA, &bestB, &cigar, dir,
+                                   startA, startB );
+      REQUIRE( score == refScore );
+      REQUIRE( bestA == refBestA );
+      REQUIRE( bestB == refBestB );
+      REQUIRE( cigar.ToString() == refCigar.ToString() );
+
+      // The anti-diagonals test the X-Drop boundary against a different
+      // highscore than the rows, so it may be explored further, never less
+      refScore = ea.Extend( A, B, NULL, NULL, NULL, dir, startA, startB );
+      score    = esa.Extend( A, B, NULL, NULL, NULL, dir, startA, startB );
+      REQUIRE( score >= refScore );
+    }
+  }
 }
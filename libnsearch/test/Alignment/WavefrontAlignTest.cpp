@@ -0,0 +1,79 @@
+#include <catch.hpp>
+
+#include <nsearch/Alignment/BandedAlign.h>
+#include <nsearch/Alignment/WavefrontAlign.h>
+#include <nsearch/Alphabet/DNA.h>
+#include <nsearch/Sequence.h>
+
+TEST_CASE( "WavefrontAlign" ) {
+  Cigar cigar;
+  int   score;
+
+  WavefrontAlign< DNA > wa;
+
+  SECTION( "Basic" ) {
+    Sequence< DNA > a = "TATAATGTTTACATTGG";
+    Sequence< DNA > b = "TATAATGACACTGG";
+
+    REQUIRE( wa.Align( a, b, &cigar, &score ) );
+    // TATAATGTTTACATTGG
+    // |||||||   |||.|||
+    // TATAATG---ACACTGG
+    REQUIRE( cigar.ToString() == "7=3I3=1X3=" );
+
+    BandedAlign< DNA > ba;
+    REQUIRE( score == ba.Align( a, b ) );
+  }
+
+  SECTION( "Identical" ) {
+    REQUIRE( wa.Align( "ATCGGTAC", "ATCGGTAC", &cigar, &score ) );
+    REQUIRE( cigar.ToString() == "8=" );
+    REQUIRE( score == 8 * 2 );
+  }
+
+  SECTION( "Gap Penalties" ) {
+    Sequence< DNA > a = "GGATCCTA";
+    Sequence< DNA > b = "ATCGTA";
+
+    // Default: terminal gaps are not penalized heavily
+    REQUIRE( wa.Align( a, b, &cigar ) );
+    REQUIRE( cigar.ToString() == "2I3=1X2=" );
+
+    // Penalize terminal gaps heavily
+    WavefrontAlignParams wap;
+    wap.terminalGapOpenScore = wap.interiorGapOpenScore * 2;
+    WavefrontAlign< DNA > wa2( wap );
+    REQUIRE( wa2.Align( a, b, &cigar ) );
+    // GGATCCTA
+    // A--TCGTA
+    REQUIRE( cigar.ToString() == "1X2I2=1X2=" );
+  }
+
+  SECTION( "Long tails" ) {
+    REQUIRE( wa.Align( "ATCGGGGGGGGGGGGGGGGGGGGGGG", "CGG", &cigar ) );
+    REQUIRE( cigar.ToString() == "2I3=21I" );
+    REQUIRE( wa.Align( "GGGGTATAAAATTT", "TTTTTTTTGGGGTATAAAA", &cigar ) );
+    REQUIRE( cigar.ToString() == "8D11=3I" );
+  }
+
+  SECTION( "Edge cases" ) {
+    REQUIRE( wa.Align( "", "", &cigar ) );
+    REQUIRE( cigar.ToString() == "" );
+
+    REQUIRE( wa.Align( "A", "", &cigar ) );
+    REQUIRE( cigar.ToString() == "1I" );
+
+    REQUIRE( wa.Align( "", "T", &cigar ) );
+    REQUIRE( cigar.ToString() == "1D" );
+  }
+
+  SECTION( "Score limit" ) {
+    Sequence< DNA > a = "ATCGATCGATCGATCGATCG";
+    Sequence< DNA > b = "ATCGATCGTTCGATCCATCG";
+
+    // Two mismatches cost 2 * (2 - (-4)) = 12
+    REQUIRE( wa.Align( a, b, &cigar, &score, 12 ) );
+    REQUIRE( cigar.ToString() == "8=1X6=1X4=" );
+    REQUIRE( wa.Align( a, b, &cigar, &score, 11 ) == false );
+  }
+}
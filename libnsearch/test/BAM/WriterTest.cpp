@@ -0,0 +1,94 @@
+#include <catch.hpp>
+
+#include <nsearch/BAM/Writer.h>
+
+#include <sstream>
+
+static uint32_t Uint32LE( const std::string& data, const size_t pos ) {
+  uint32_t value = 0;
+  for( int i = 3; i >= 0; i-- ) {
+    value = ( value << 8 ) | uint8_t( data[ pos + i ] );
+  }
+  return value;
+}
+
+static uint16_t Uint16LE( const std::string& data, const size_t pos ) {
+  return uint8_t( data[ pos ] ) | ( uint8_t( data[ pos + 1 ] ) << 8 );
+}
+
+TEST_CASE( "BAM" ) {
+  auto entry = std::make_pair(
+    Sequence< DNA >( "Query1 sample=A", "ATCGTGTACCAGGATG",
+                     "ABCDEFGHIJKLMNOP" ),
+    HitList< DNA >( {
+      { { "Ref2", "TTCATCCTCGTACACGA" }, "2D6=1X8=1I", DNA::Strand::Minus },
+    } ) );
+
+  std::ostringstream oss;
+  BAM::Writer< DNA > writer( oss );
+
+  Sequence< DNA > other( "Ref1", "ACGT" );
+  writer.WriteHeader( { other, entry.second[ 0 ].target } );
+  writer << entry;
+
+  std::string bam = oss.str();
+
+  // Header
+  REQUIRE( bam.substr( 0, 4 ) == std::string( "BAM\1", 4 ) );
+  size_t textLength = Uint32LE( bam, 4 );
+  REQUIRE( bam.substr( 8, textLength ) ==
+           SAM::Header( SequenceList< DNA >( { other,
+                                               entry.second[ 0 ].target } ) ) );
+
+  size_t pos = 8 + textLength;
+  REQUIRE( Uint32LE( bam, pos ) == 2 );
+  pos += 4;
+  REQUIRE( Uint32LE( bam, pos ) == 5 );
+  REQUIRE( bam.substr( pos + 4, 5 ) == std::string( "Ref1\0", 5 ) );
+  REQUIRE( Uint32LE( bam, pos + 9 ) == 4 );
+  pos += 13;
+  REQUIRE( Uint32LE( bam, pos ) == 5 );
+  REQUIRE( bam.substr( pos + 4, 5 ) == std::string( "Ref2\0", 5 ) );
+  REQUIRE( Uint32LE( bam, pos + 9 ) == 17 );
+  pos += 13;
+
+  // Record
+  size_t blockSize = Uint32LE( bam, pos );
+  REQUIRE( pos + 4 + blockSize == bam.size() );
+
+  const size_t record = pos + 4;
+  REQUIRE( Uint32LE( bam, record ) == 1 );         // refID
+  REQUIRE( Uint32LE( bam, record + 4 ) == 2 );     // pos
+  REQUIRE( uint8_t( bam[ record + 8 ] ) == 7 );    // l_read_name
+  REQUIRE( uint8_t( bam[ record + 9 ] ) == 255 );  // mapq
+  REQUIRE( Uint16LE( bam, record + 10 ) == 4681 ); // bin
+  REQUIRE( Uint16LE( bam, record + 12 ) == 4 );    // n_cigar_op
+  REQUIRE( Uint16LE( bam, record + 14 ) == 16 );   // flag
+  REQUIRE( Uint32LE( bam, record + 16 ) == 16 );   // l_seq
+  REQUIRE( Uint32LE( bam, record + 20 ) == uint32_t( -1 ) );
+  REQUIRE( Uint32LE( bam, record + 24 ) == uint32_t( -1 ) );
+  REQUIRE( Uint32LE( bam, record + 28 ) == 0 );
+  REQUIRE( bam.substr( record + 32, 7 ) == std::string( "Query1\0", 7 ) );
+
+  // 6=1X8=1S
+  size_t cigar = record + 39;
+  REQUIRE( Uint32LE( bam, cigar ) == ( 6 << 4 | 7 ) );
+  REQUIRE( Uint32LE( bam, cigar + 4 ) == ( 1 << 4 | 8 ) );
+  REQUIRE( Uint32LE( bam, cigar + 8 ) == ( 8 << 4 | 7 ) );
+  REQUIRE( Uint32LE( bam, cigar + 12 ) == ( 1 << 4 | 4 ) );
+
+  // CATCCTGGTACACGAT, =ACMGRSVTWYHKDBN
+  size_t seq = cigar + 16;
+  REQUIRE( uint8_t( bam[ seq ] ) == 0x21 );
+  REQUIRE( uint8_t( bam[ seq + 7 ] ) == 0x18 );
+
+  // PONMLKJIHGFEDCBA (Phred+33)
+  size_t qual = seq + 8;
+  REQUIRE( bam[ qual ] == 'P' - 33 );
+  REQUIRE( bam[ qual + 15 ] == 'A' - 33 );
+
+  size_t tags = qual + 16;
+  REQUIRE( bam.substr( tags, 3 ) == "NMi" );
+  REQUIRE( Uint32LE( bam, tags + 3 ) == 1 );
+  REQUIRE( tags + 7 == bam.size() );
+}
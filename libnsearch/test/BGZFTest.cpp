@@ -0,0 +1,227 @@
+#include <catch.hpp>
+
+#include <nsearch/Alphabet/DNA.h>
+#include <nsearch/BGZF.h>
+#include <nsearch/FASTA/Reader.h>
+#include <nsearch/TextReader.h>
+
+#include <fcntl.h>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#if defined( USE_ZLIB ) && ( defined( __APPLE__ ) || defined( __unix__ ) )
+#include <unistd.h>
+
+static void PutUint16LE( std::string& out, const size_t value ) {
+  out += char( value & 0xFF );
+  out += char( ( value >> 8 ) & 0xFF );
+}
+
+static void PutUint32LE( std::string& out, const size_t value ) {
+  PutUint16LE( out, value & 0xFFFF );
+  PutUint16LE( out, ( value >> 16 ) & 0xFFFF );
+}
+
+// Compresses text as one BGZF block
+static std::string BGZFBlock( const std::string& text ) {
+  std::vector< Bytef > cdata( compressBound( text.size() ) + 64 );
+
+  z_stream stream = {};
+  deflateInit2( &stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8,
+                Z_DEFAULT_STRATEGY );
+  stream.next_in   = ( Bytef* ) text.data();
+  stream.avail_in  = text.size();
+  stream.next_out  = cdata.data();
+  stream.avail_out = cdata.size();
+  deflate( &stream, Z_FINISH );
+  deflateEnd( &stream );
+
+  // ID1 ID2 CM FLG, MTIME, XFL OS, XLEN
+  std::string block( "\x1F\x8B\x08\x04\0\0\0\0\0\xFF", 10 );
+  PutUint16LE( block, 6 );
+  block += "BC";
+  PutUint16LE( block, 2 );
+  PutUint16LE( block, 12 + 6 + stream.total_out + 8 - 1 );
+  block += std::string( ( const char* ) cdata.data(), stream.total_out );
+  PutUint32LE( block, crc32( crc32( 0, NULL, 0 ),
+                             ( const Bytef* ) text.data(), text.size() ) );
+  PutUint32LE( block, text.size() );
+  return block;
+}
+
+// Compresses text as plain gzip member (without "BC" field)
+static std::string GzipMember( const std::string& text ) {
+  std::vector< Bytef > cdata( compressBound( text.size() ) + 64 );
+
+  z_stream stream = {};
+  deflateInit2( &stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+                Z_DEFAULT_STRATEGY ); // gzip wrapper
+  stream.next_in   = ( Bytef* ) text.data();
+  stream.avail_in  = text.size();
+  stream.next_out  = cdata.data();
+  stream.avail_out = cdata.size();
+  deflate( &stream, Z_FINISH );
+  deflateEnd( &stream );
+
+  return std::string( ( const char* ) cdata.data(), stream.total_out );
+}
+
+TEST_CASE( "BGZF" ) {
+  const char filename[] = "/tmp/bgzftest.gz";
+
+  // Lines straddle the blocks
+  std::string text;
+  for( int i = 0; i < 10000; i++ ) {
+    text += "Line " + std::to_string( i ) + "\n";
+  }
+
+  std::string contents;
+  for( size_t pos = 0; pos < text.size(); pos += 1000 ) {
+    contents += BGZFBlock( text.substr( pos, 1000 ) );
+  }
+
+  SECTION( "Read" ) {
+    std::ofstream( filename ) << contents << BGZFBlock( "" ); // EOF marker
+
+    int fd = open( filename, O_RDONLY );
+    REQUIRE( BGZFDecompressor::IsBGZF( fd ) );
+    REQUIRE( lseek( fd, 0, SEEK_CUR ) == 0 );
+    close( fd );
+
+    std::string    line;
+    TextFileReader reader( filename, 32 * 1024, 3 );
+    for( int i = 0; i < 10000; i++ ) {
+      REQUIRE( reader.EndOfFile() == false );
+      reader >> line;
+      REQUIRE( line == "Line " + std::to_string( i ) );
+    }
+    REQUIRE( reader.EndOfFile() == true );
+    REQUIRE( reader.Failed() == false );
+  }
+
+  // Lines up to the first block which can't be read (the last one may be
+  // cut), then fails
+  auto readUntilFailure = [&]() {
+    std::string    line;
+    TextFileReader reader( filename, 32 * 1024, 3 );
+    size_t         numLines = 0;
+    bool           complete = true;
+    while( !reader.EndOfFile() ) {
+      reader >> line;
+      complete = complete && line == "Line " + std::to_string( numLines );
+      numLines += complete;
+    }
+    REQUIRE( reader.EndOfFile() == true );
+    REQUIRE( reader.Failed() == true );
+    return numLines;
+  };
+
+  SECTION( "Corrupt block" ) {
+    contents[ contents.size() / 2 ] ^= 0x55;
+    std::ofstream( filename ) << contents;
+    REQUIRE( readUntilFailure() < 10000 );
+  }
+
+  SECTION( "Truncated" ) {
+    // Within a block
+    std::ofstream( filename ) << contents.substr( 0, contents.size() - 5 );
+    REQUIRE( readUntilFailure() < 10000 );
+
+    // Within a header
+    std::ofstream( filename ) << contents << BGZFBlock( "" ).substr( 0, 10 );
+    REQUIRE( readUntilFailure() == 10000 );
+
+    // Between blocks (without end-of-file marker), that's fine
+    std::ofstream( filename ) << contents;
+    TextFileReader reader( filename, 32 * 1024, 3 );
+    std::string    line;
+    while( !reader.EndOfFile() )
+      reader >> line;
+    REQUIRE( line == "Line 9999" );
+    REQUIRE( reader.Failed() == false );
+  }
+
+  SECTION( "Not a gzip member" ) {
+    std::ofstream( filename ) << contents << "Garbage";
+    REQUIRE( readUntilFailure() == 10000 );
+  }
+
+  SECTION( "Followed by plain gzip" ) {
+    std::ofstream( filename ) << BGZFBlock( ">a\nACGT\n" )
+                              << GzipMember( ">b\nTTGA\n" )
+                              << BGZFBlock( ">c\nGGCA\n" ) << BGZFBlock( "" );
+
+    FASTA::Reader< DNA > reader( filename );
+    Sequence< DNA >      seq;
+    REQUIRE( reader.Read( &seq ) );
+    REQUIRE( seq.identifier == "a" );
+    REQUIRE( reader.Read( &seq ) );
+    REQUIRE( seq.identifier == "b" );
+    REQUIRE( seq.sequence == "TTGA" );
+    REQUIRE( reader.Read( &seq ) );
+    REQUIRE( seq.identifier == "c" );
+    REQUIRE( !reader.Read( &seq ) );
+    REQUIRE( !reader.Failed() );
+  }
+
+  SECTION( "Write" ) {
+    {
+      BGZFOutputStream out( filename, 3 );
+      // Single characters and long writes
+      out << text[ 0 ];
+      out.write( text.data() + 1, text.size() - 1 );
+    }
+
+    // Blocks are read in parallel...
+    int fd = open( filename, O_RDONLY );
+    REQUIRE( BGZFDecompressor::IsBGZF( fd ) );
+    close( fd );
+
+    std::string    line;
+    TextFileReader reader( filename, 32 * 1024, 3 );
+    for( int i = 0; i < 10000; i++ ) {
+      reader >> line;
+      REQUIRE( line == "Line " + std::to_string( i ) );
+    }
+    REQUIRE( reader.EndOfFile() == true );
+
+    // ...or like any other gzip file
+    gzFile      file = gzopen( filename, "rb" );
+    std::string decompressed( text.size() + 1, '\0' );
+    REQUIRE( gzread( file, &decompressed[ 0 ], decompressed.size() ) ==
+             text.size() );
+    decompressed.resize( text.size() );
+    REQUIRE( decompressed == text );
+    gzclose( file );
+  }
+
+  SECTION( "Write nothing" ) {
+    { BGZFOutputStream out( filename ); }
+
+    TextFileReader reader( filename, 32 * 1024, 3 );
+    REQUIRE( reader.EndOfFile() == true );
+  }
+
+  SECTION( "Plain gzip" ) {
+    gzFile file = gzopen( filename, "wb" );
+    gzputs( file, text.c_str() );
+    gzclose( file );
+
+    int fd = open( filename, O_RDONLY );
+    REQUIRE( BGZFDecompressor::IsBGZF( fd ) == false );
+    close( fd );
+
+    // Truncated
+    std::ofstream( filename ) << GzipMember( text ).substr( 0, 1000 );
+    TextFileReader reader( filename, 32 * 1024, 3 );
+    std::string    line;
+    while( !reader.EndOfFile() )
+      reader >> line;
+    REQUIRE( reader.Failed() == true );
+  }
+
+  std::remove( filename );
+}
+#endif
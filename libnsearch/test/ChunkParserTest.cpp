@@ -0,0 +1,93 @@
+#include <catch.hpp>
+
+#include <nsearch/Alphabet/DNA.h>
+#include <nsearch/ChunkParser.h>
+#include <nsearch/FASTA/Reader.h>
+#include <nsearch/FASTQ/Reader.h>
+
+#include <fstream>
+
+TEST_CASE( "ChunkParser" ) {
+#if defined( __APPLE__ ) || defined( __unix__ )
+  const char filename[] = "/tmp/chunkparsertest.tmp";
+
+  SECTION( "FASTQ" ) {
+    // Qualities starting with '@', blank lines
+    std::ofstream file( filename );
+    for( int i = 0; i < 500; i++ ) {
+      file << "@Seq" << i << "\n"
+           << std::string( i % 17 + 1, 'c' ) << "\n+\n"
+           << std::string( i % 17 + 1, i % 3 ? '@' : 'J' ) << "\n"
+           << ( i % 5 ? "" : "\n" );
+    }
+    file.close();
+
+    // Tiny chunks cut most records
+    for( size_t chunkSize : { 1, 7, 64, 4096 } ) {
+      TextFileReader textReader( filename, chunkSize );
+      FASTQ::Parser  parser;
+      ChunkParser    chunkParser( &textReader, &parser, 3 );
+
+      RecordBatch batch;
+      int         numRecords = 0;
+      while( !chunkParser.EndOfFile() ) {
+        chunkParser.Read( &batch );
+        for( size_t i = 0; i < batch.Size(); i++, numRecords++ ) {
+          REQUIRE( batch.IdentifierAt( i ).ToString() ==
+                   "Seq" + std::to_string( numRecords ) );
+          REQUIRE( batch.SequenceAt( i ).ToString() ==
+                   std::string( numRecords % 17 + 1, 'C' ) );
+          REQUIRE( batch.QualityAt( i ).ToString() ==
+                   std::string( numRecords % 17 + 1,
+                                numRecords % 3 ? '@' : 'J' ) );
+        }
+      }
+      REQUIRE( numRecords == 500 );
+      REQUIRE( chunkParser.NumBytesRead() == textReader.NumBytesTotal() );
+    }
+  }
+
+  SECTION( "FASTA" ) {
+    // Records spanning many chunks, '>' within records
+    std::ofstream file( filename );
+    for( int i = 0; i < 100; i++ ) {
+      file << ">Seq" << i << ">\n";
+      for( int j = 0; j < i % 7; j++ ) {
+        file << std::string( 60, 'a' ) << "\n";
+      }
+    }
+    file.close();
+
+    for( size_t chunkSize : { 1, 13, 256 } ) {
+      std::unique_ptr< TextReader > textReader(
+        new TextFileReader( filename, chunkSize ) );
+      FASTA::Reader< DNA > reader( std::move( textReader ), 4 );
+
+      Sequence< DNA > seq;
+      for( int i = 0; i < 100; i++ ) {
+        REQUIRE( reader.Read( &seq ) );
+        REQUIRE( seq.identifier == "Seq" + std::to_string( i ) + ">" );
+        REQUIRE( seq.sequence == std::string( 60 * ( i % 7 ), 'A' ) );
+      }
+      REQUIRE( reader.Read( &seq ) == false );
+      REQUIRE( reader.EndOfFile() );
+    }
+  }
+
+  SECTION( "Empty file" ) {
+    std::ofstream file( filename );
+    file.close();
+
+    TextFileReader textReader( filename );
+    FASTA::Parser  parser;
+    ChunkParser    chunkParser( &textReader, &parser, 2 );
+
+    RecordBatch batch;
+    chunkParser.Read( &batch );
+    REQUIRE( batch.Empty() );
+    REQUIRE( chunkParser.EndOfFile() );
+  }
+
+  std::remove( filename );
+#endif
+}
@@ -117,6 +117,23 @@ TEST_CASE( "Global Search" ) {
     REQUIRE( std::find( ids.begin(), ids.end(), "RF00807;mir-314;AFFE01007792.1/82767-82854   42026:Drosophila bipectinata" ) != ids.end() );
   }
 
+  SECTION( "Ungapped" ) {
+    // Same length as the candidate, one mismatch
+    Sequence< DNA > candidate = sequences[ 9 ];
+    query       = candidate;
+    query[ 20 ] = query[ 20 ] == 'A' ? 'C' : 'A';
+
+    GlobalSearch< DNA > gs( db, sp );
+    auto hits = gs.Query( query );
+
+    REQUIRE( hits.size() == 1 );
+    REQUIRE( hits[ 0 ].target.identifier == candidate.identifier );
+
+    std::string expected =
+      "20=1X" + std::to_string( candidate.Length() - 21 ) + "=";
+    REQUIRE( hits[ 0 ].alignment.ToString() == expected );
+  }
+
   SECTION( "Strand support" ) {
     // our read goes in the "other" direction
     query = query.Reverse().Complement();
@@ -0,0 +1,69 @@
+#include <catch.hpp>
+
+#include <nsearch/Database/HSPChain.h>
+
+TEST_CASE( "HSPChain" ) {
+  HSPChain           hspChain;
+  std::vector< HSP > hsps, chain;
+
+  SECTION( "Empty" ) {
+    hspChain.Chain( &hsps, &chain );
+    REQUIRE( chain.empty() );
+  }
+
+  SECTION( "Co-linear" ) {
+    hsps.emplace_back( 40, 59, 40, 59, 40 );
+    hsps.emplace_back( 0, 19, 0, 19, 40 );
+    hsps.emplace_back( 20, 29, 20, 29, 20 );
+
+    hspChain.Chain( &hsps, &chain );
+    REQUIRE( chain.size() == 3 );
+    REQUIRE( chain[ 0 ].a1 == 0 );
+    REQUIRE( chain[ 1 ].a1 == 20 );
+    REQUIRE( chain[ 2 ].a1 == 40 );
+  }
+
+  SECTION( "Best chain instead of best HSP" ) {
+    // Greedily starting with the best HSP (crossing the other two) would
+    // miss the better chain
+    hsps.emplace_back( 0, 19, 20, 39, 50 );
+    hsps.emplace_back( 0, 19, 0, 19, 40 );
+    hsps.emplace_back( 20, 39, 20, 39, 40 );
+
+    hspChain.Chain( &hsps, &chain );
+    REQUIRE( chain.size() == 2 );
+    REQUIRE( chain[ 0 ].b1 == 0 );
+    REQUIRE( chain[ 1 ].b1 == 20 );
+  }
+
+  SECTION( "Overlaps" ) {
+    hsps.emplace_back( 0, 19, 0, 19, 40 );
+    hsps.emplace_back( 10, 29, 10, 29, 30 );
+
+    hspChain.Chain( &hsps, &chain );
+    REQUIRE( chain.size() == 1 );
+    REQUIRE( chain[ 0 ].Score() == 40 );
+  }
+
+  SECTION( "Gap penalty" ) {
+    // Diagonal shift of 4: -20 + 4 * -2 = -28
+    hsps.emplace_back( 0, 19, 0, 19, 40 );
+    hsps.emplace_back( 24, 33, 20, 29, 20 );
+    hspChain.Chain( &hsps, &chain );
+    REQUIRE( chain.size() == 1 );
+
+    hsps.clear();
+    hsps.emplace_back( 0, 19, 0, 19, 40 );
+    hsps.emplace_back( 24, 43, 20, 39, 40 );
+    hspChain.Chain( &hsps, &chain );
+    REQUIRE( chain.size() == 2 );
+  }
+
+  SECTION( "Max join distance" ) {
+    hsps.emplace_back( 0, 19, 0, 19, 40 );
+    hsps.emplace_back( 100, 119, 100, 119, 40 );
+
+    hspChain.Chain( &hsps, &chain );
+    REQUIRE( chain.size() == 1 );
+  }
+}
@@ -39,6 +39,19 @@ TEST_CASE( "FASTA" ) {
     REQUIRE( reader.EndOfFile() == true );
   }
 
+  SECTION( "Record start" ) {
+    FASTA::Parser parser;
+
+    std::string chunk = "Seq1\nAC>GT\n>Seq2\nTT\n";
+    REQUIRE( parser.FindRecordStart( chunk.data(), chunk.size(), true ) ==
+             chunk.find( ">Seq2" ) );
+
+    chunk = ">Seq2\nTT\n";
+    REQUIRE( parser.FindRecordStart( chunk.data(), chunk.size(), true ) == 0 );
+    REQUIRE( parser.FindRecordStart( chunk.data(), chunk.size(), false ) ==
+             chunk.size() );
+  }
+
   SECTION( "Writer" ) {
     Sequence< DNA > seq1( "Seq1", "MTEITAAMVKELRESTGAGMMDCKNALSETNGDFDKAVQLLREKGLGKAAKKADRLAAEGLVSVKVSDDFTIAAMRPSYLSYEDLDMTFVENEYKALVAELEKENEERRRL" );
     Sequence< DNA > seq2( "Seq2", "SATVSEINSETDFVAKNDQFIALTKDTTAHIQSNSLQSVEELHSSTINGVKFEEYLKSQI" );
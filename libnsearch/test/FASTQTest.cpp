@@ -36,6 +36,71 @@ TEST_CASE( "FASTQ" ) {
     REQUIRE( reader.EndOfFile() == true );
   }
 
+#if defined( __APPLE__ ) || defined( __unix__ )
+  SECTION( "Reader (mapped file)" ) {
+    const char    filename[] = "/tmp/fastqreadertest.fq";
+    std::ofstream file( filename );
+    file << "@Seq1\nTGGCG\n+\nJJJJB\n\n@Seq2 \nactgc\n+\nJAJI=\n";
+    file.close();
+
+    FASTQ::Reader< DNA > reader( filename );
+    Sequence< DNA >      sequence;
+
+    reader >> sequence;
+    REQUIRE( sequence.identifier == "Seq1" );
+    REQUIRE( sequence.sequence == "TGGCG" );
+    REQUIRE( sequence.quality == "JJJJB" );
+
+    reader >> sequence;
+    REQUIRE( sequence.identifier == "Seq2 " );
+    REQUIRE( sequence.sequence == "ACTGC" );
+    REQUIRE( sequence.quality == "JAJI=" );
+
+    REQUIRE( reader.EndOfFile() == true );
+    std::remove( filename );
+  }
+
+#ifdef USE_ZLIB
+  SECTION( "Compressed file" ) {
+    const char filename[] = "/tmp/fastqwritertest.fq.gz";
+    {
+      FASTQ::Writer< DNA > writer( filename );
+      writer << Sequence< DNA >( "Seq1", "TAGGC", "JJ:BB" );
+    }
+
+    FASTQ::Reader< DNA > reader( filename );
+    Sequence< DNA >      sequence;
+    reader >> sequence;
+    REQUIRE( sequence.identifier == "Seq1" );
+    REQUIRE( sequence.sequence == "TAGGC" );
+    REQUIRE( sequence.quality == "JJ:BB" );
+    REQUIRE( reader.EndOfFile() == true );
+    std::remove( filename );
+  }
+#endif
+#endif
+
+  SECTION( "Record start" ) {
+    FASTQ::Parser parser;
+
+    // Quality line starting with '@'
+    std::string chunk = "GT\n+\n@JJ\n@Seq2\nACGT\n+\nJJJJ\n";
+    REQUIRE( parser.FindRecordStart( chunk.data(), chunk.size(), true ) ==
+             chunk.find( "@Seq2" ) );
+
+    // Cut within a line
+    chunk = "q1\n@Seq2\nACGT\n+\nJJJJ\n";
+    REQUIRE( parser.FindRecordStart( chunk.data(), chunk.size(), false ) ==
+             chunk.find( "@Seq2" ) );
+    REQUIRE( parser.FindRecordStart( chunk.data() + 1, chunk.size() - 1,
+                                     false ) == chunk.find( "@Seq2" ) - 1 );
+
+    // Can't tell
+    chunk = "@JJ\n@Seq2\nAC";
+    REQUIRE( parser.FindRecordStart( chunk.data(), chunk.size(), true ) ==
+             chunk.size() );
+  }
+
   SECTION( "Writer" ) {
     Sequence< DNA > seq1( "Seq1", "TAGGC", "JJ:BB" );
     Sequence< DNA > seq2( "Seq2", "CTAGG", "AA..D" );
@@ -0,0 +1,178 @@
+#include <catch.hpp>
+
+#include <nsearch/Alphabet/DNA.h>
+#include <nsearch/Alphabet/Protein.h>
+#include <nsearch/NSB/Reader.h>
+#include <nsearch/NSB/Writer.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+
+TEST_CASE( "NSB" ) {
+  const char filename[] = "/tmp/nsbtest.nsb";
+
+  SECTION( "Round trip" ) {
+    SequenceList< DNA > sequences = {
+      { "Seq1", "TGGCGAATC", "JJJJBJJJJ" },
+      { "Seq2 with description", "NNNACGTNNUUTN", "" },
+      { "", "", "" },
+      { "Seq4", "RYACGTKM", "ABCDEFGH" },
+    };
+
+    {
+      NSB::Writer< DNA > writer( filename );
+      for( auto& seq : sequences )
+        writer << seq;
+    }
+
+    NSB::Reader< DNA > reader( filename );
+    REQUIRE( reader.IsValid() );
+    REQUIRE( reader.NumRecords() == sequences.size() );
+
+    Sequence< DNA > seq;
+    for( auto& expected : sequences ) {
+      REQUIRE( reader.Read( &seq ) );
+      REQUIRE( seq.identifier == expected.identifier );
+      REQUIRE( seq.sequence == expected.sequence );
+      REQUIRE( seq.quality == expected.quality );
+    }
+    REQUIRE( reader.EndOfFile() );
+    REQUIRE( reader.NumBytesRead() == reader.NumBytesTotal() );
+  }
+
+  SECTION( "Multiple blocks" ) {
+    const size_t numRecords = NSB::MaxBlockRecords * 2 + 7;
+
+    auto nth = []( const size_t i ) {
+      std::string sequence;
+      for( size_t j = 0; j < i % 23; j++ )
+        sequence += "ACGTN"[ ( i + j * j ) % 5 ];
+      return Sequence< DNA >( "Seq" + std::to_string( i ), sequence,
+                              std::string( sequence.size(), 'I' ) );
+    };
+
+    {
+      NSB::Writer< DNA > writer( filename );
+      for( size_t i = 0; i < numRecords; i++ )
+        writer << nth( i );
+    }
+
+    NSB::Reader< DNA > reader( filename );
+    REQUIRE( reader.NumRecords() == numRecords );
+
+    RecordBatch batch;
+    size_t      count = 0, numBatches = 0;
+    while( !reader.EndOfFile() ) {
+      reader.Read( &batch );
+      numBatches++;
+
+      Sequence< DNA > seq;
+      for( size_t i = 0; i < batch.Size(); i++, count++ ) {
+        batch.Get( i, &seq );
+        auto expected = nth( count );
+        REQUIRE( seq.identifier == expected.identifier );
+        REQUIRE( seq.sequence == expected.sequence );
+        REQUIRE( seq.quality == expected.quality );
+      }
+    }
+    REQUIRE( count == numRecords );
+    REQUIRE( numBatches == 3 );
+  }
+
+  SECTION( "Protein" ) {
+    {
+      NSB::Writer< Protein > writer( filename );
+      writer << Sequence< Protein >( "Prot1", "MKVLAAGIC" );
+    }
+
+    NSB::Reader< Protein > reader( filename );
+    Sequence< Protein >    seq;
+    REQUIRE( reader.Read( &seq ) );
+    REQUIRE( seq.identifier == "Prot1" );
+    REQUIRE( seq.sequence == "MKVLAAGIC" );
+    REQUIRE( reader.EndOfFile() );
+
+    // Stored 8 bits per letter, not readable as DNA
+    NSB::Reader< DNA > dnaReader( filename );
+    REQUIRE( !dnaReader.IsValid() );
+    REQUIRE( dnaReader.NumRecords() == 0 );
+    REQUIRE( dnaReader.EndOfFile() );
+  }
+
+  SECTION( "Invalid file" ) {
+    {
+      std::ofstream file( filename );
+      file << ">Seq1\nACGT\n";
+    }
+
+    NSB::Reader< DNA > reader( filename );
+    Sequence< DNA >    seq;
+    REQUIRE( !reader.IsValid() );
+    REQUIRE( reader.EndOfFile() );
+    REQUIRE( !reader.Read( &seq ) );
+  }
+
+  SECTION( "Empty" ) {
+    {
+      NSB::Writer< DNA > writer( filename );
+    }
+
+    NSB::Reader< DNA > reader( filename );
+    REQUIRE( reader.IsValid() );
+    REQUIRE( reader.NumRecords() == 0 );
+    REQUIRE( reader.EndOfFile() );
+  }
+
+  SECTION( "Corrupt file" ) {
+    {
+      NSB::Writer< DNA > writer( filename );
+      writer << Sequence< DNA >( "Seq1", "ACNNT", "" );
+    }
+
+    std::string content;
+    {
+      std::ifstream file( filename, std::ios::binary );
+      content.assign( std::istreambuf_iterator< char >( file ),
+                      std::istreambuf_iterator< char >() );
+    }
+
+    // Header, block header, 4 record ends, identifier, 2 bytes of letters
+    const size_t block     = NSB::HeaderSize;
+    const size_t exception = block + NSB::BlockHeaderSize + 16 + 4 + 2;
+
+    auto readsAsEmpty = [&]( const size_t pos, const char byte ) {
+      std::string corrupt = content;
+      corrupt[ pos ]      = byte;
+      {
+        std::ofstream file( filename, std::ios::binary );
+        file << corrupt;
+      }
+
+      NSB::Reader< DNA > reader( filename );
+      Sequence< DNA >    seq;
+      return !reader.IsValid() && reader.NumRecords() == 0 &&
+             reader.EndOfFile() && !reader.Read( &seq );
+    };
+
+    REQUIRE( !readsAsEmpty( block, 1 ) ); // unchanged
+    REQUIRE( readsAsEmpty( block, 100 ) ); // number of records
+    REQUIRE( readsAsEmpty( block + 16, 100 ) ); // number of letters
+    REQUIRE( readsAsEmpty( exception, 5 ) ); // position past the record
+    REQUIRE( readsAsEmpty( exception + 4, 100 ) ); // run past the record
+    REQUIRE( readsAsEmpty( content.size() - NSB::FooterSize - 8,
+                           100 ) ); // block offset
+
+    // Truncated
+    {
+      std::ofstream file( filename, std::ios::binary );
+      file << content.substr( 0, content.size() - 9 );
+    }
+    NSB::Reader< DNA > reader( filename );
+    REQUIRE( !reader.IsValid() );
+    REQUIRE( reader.NumRecords() == 0 );
+    REQUIRE( reader.EndOfFile() );
+  }
+
+  std::remove( filename );
+}
@@ -0,0 +1,68 @@
+#include <catch.hpp>
+
+#include <nsearch/OutputFile.h>
+
+#include <fstream>
+#include <sstream>
+
+#if defined( __APPLE__ ) || defined( __unix__ )
+static std::string ReadFile( const char* filename ) {
+  std::ifstream     file( filename, std::ios::binary );
+  std::stringstream ss;
+  ss << file.rdbuf();
+  return ss.str();
+}
+#endif
+
+TEST_CASE( "OutputFile" ) {
+#if defined( __APPLE__ ) || defined( __unix__ )
+  const char filename[] = "/tmp/outputfiletest.tmp";
+
+  SECTION( "Buffered" ) {
+    std::string expected;
+    {
+      BufferedOutputStream out( filename, 16 );
+      REQUIRE( out.good() );
+
+      out << "Hello" << std::endl;
+      expected += "Hello\n";
+
+      // Flushing doesn't write
+      out.flush();
+      REQUIRE( ReadFile( filename ).empty() );
+
+      // Full buffer
+      for( int i = 0; i < 100; i++ ) {
+        out << i << ',';
+        expected += std::to_string( i ) + ',';
+      }
+
+      // More than fits
+      std::string big( 1000, 'x' );
+      out << big;
+      expected += big;
+
+      out << 'y';
+      expected += 'y';
+      REQUIRE( out.good() );
+    }
+
+    REQUIRE( ReadFile( filename ) == expected );
+  }
+
+  SECTION( "Open by name" ) {
+    {
+      auto out = OpenOutputFile( filename );
+      *out << "Plain";
+    }
+    REQUIRE( ReadFile( filename ) == "Plain" );
+  }
+
+  SECTION( "Non-existing directory" ) {
+    BufferedOutputStream out( "/tmp/nonexisting/dir/file" );
+    REQUIRE( out.fail() );
+  }
+
+  std::remove( filename );
+#endif
+}
@@ -0,0 +1,67 @@
+#include <catch.hpp>
+
+#include <nsearch/Alphabet/DNA.h>
+#include <nsearch/Alphabet/Protein.h>
+#include <nsearch/PackedSequence.h>
+
+#include <vector>
+
+TEST_CASE( "PackedSequence" ) {
+  SECTION( "Packing" ) {
+    REQUIRE( PackedSequence< DNA >( "ACGTU" ).IsPacked() );
+    REQUIRE( PackedSequence< DNA >( "" ).IsPacked() );
+    REQUIRE( PackedSequence< DNA >( "ACGTU" ).Length() == 5 );
+
+    // Ambiguous nucleotides
+    REQUIRE( PackedSequence< DNA >( "ACGNT" ).IsPacked() == false );
+
+    // The protein bit mapping collapses amino acids
+    REQUIRE( PackedSequence< Protein >( "DEQ" ).IsPacked() == false );
+  }
+
+  SECTION( "Mismatches" ) {
+    PackedSequence< DNA > a( "ACGTACGTAC" );
+    PackedSequence< DNA > b( "ACGAACGUAGC" );
+
+    REQUIRE( a.NumMismatches( b, 0, 0, 10 ) == 2 );
+    REQUIRE( a.NumMismatches( b, 0, 0, 3 ) == 0 );
+    REQUIRE( a.NumMismatches( b, 4, 4, 5 ) == 0 );
+    REQUIRE( a.NumMismatches( b, 1, 0, 0 ) == 0 );
+
+    std::vector< size_t > mismatches;
+    a.ForEachMismatch( b, 0, 0, 10, [&]( const size_t offset ) {
+      mismatches.push_back( offset );
+    } );
+    REQUIRE( mismatches == ( std::vector< size_t >{ 3, 9 } ) );
+  }
+
+  SECTION( "Long sequences" ) {
+    // Spanning multiple words, at arbitrary offsets
+    std::string seq;
+    for( int i = 0; i < 300; i++ ) {
+      seq += "ACGT"[ ( i * 7 + i / 3 ) % 4 ];
+    }
+    std::string mutated = "GG" + seq;
+    mutated[ 2 + 100 ] = mutated[ 2 + 100 ] == 'A' ? 'C' : 'A';
+    mutated[ 2 + 263 ] = mutated[ 2 + 263 ] == 'A' ? 'C' : 'A';
+
+    PackedSequence< DNA > a( seq.c_str() ), b( mutated.c_str() );
+    for( size_t pos = 0; pos < 40; pos++ ) {
+      size_t numMismatches = 0;
+      size_t length        = 300 - pos;
+      for( size_t i = 0; i < length; i++ ) {
+        numMismatches += seq[ pos + i ] != mutated[ pos + i ];
+      }
+      REQUIRE( a.NumMismatches( b, pos, pos, length ) == numMismatches );
+    }
+
+    REQUIRE( a.NumMismatches( b, 0, 2, 300 ) == 2 );
+    REQUIRE( a.NumMismatches( b, 101, 103, 162 ) == 0 );
+
+    std::vector< size_t > mismatches;
+    a.ForEachMismatch( b, 0, 2, 300, [&]( const size_t offset ) {
+      mismatches.push_back( offset );
+    } );
+    REQUIRE( mismatches == ( std::vector< size_t >{ 100, 263 } ) );
+  }
+}
@@ -55,6 +55,86 @@ TEST_CASE( "Merger" ) {
     REQUIRE( res == false );
   }
 
+  SECTION( "overlap without shared seeds" ) {
+    // Every 8-mer of the overlap has a mismatch, the full slide finds it
+    Merger< DNA >   merger( 10, 0.8 );
+    Sequence< DNA > fwd1 =
+      Sequence< DNA >( "fwd1", "GATTACAGGCTTAACGTCCA", "JJJJJJJJJJJJJJJJJJJJ" );
+    Sequence< DNA > rev1 =
+      Sequence< DNA >( "rev1", "GATTTCAGGCTAAACGTCGA", "JJJJJJJJJJJJJJJJJJJJ" )
+        .Reverse()
+        .Complement();
+
+    res = merger.Merge( fwd1, rev1, &merged );
+    REQUIRE( res == true );
+    REQUIRE( merged.sequence == "GATTACAGGCTTAACGTCCA" );
+  }
+
+  SECTION( "reverse read longer than forward read" ) {
+    Merger< DNA >   merger( 5, 1.0 );
+    Sequence< DNA > fwd1 = Sequence< DNA >( "fwd1", "GGATGGA", "JJJJJJJ" );
+    Sequence< DNA > rev1 =
+      Sequence< DNA >( "rev1", "ATGGAATCCCTT", "JJJJJJJJJJJJ" )
+        .Reverse()
+        .Complement();
+
+    res = merger.Merge( fwd1, rev1, &merged );
+    REQUIRE( res == true );
+    REQUIRE( merged == Sequence< DNA >( "GGATGGAATCCCTT" ) );
+  }
+
+  SECTION( "ambiguous letters within a long overlap" ) {
+    // N matches any letter, also when compared 16 letters at a time
+    Merger< DNA >   merger( 20, 1.0 );
+    Sequence< DNA > fwd1 = Sequence< DNA >(
+      "fwd1", "GATTACAGGCTTAACGTCCATG", "JJJJJJJJJJJJJJJJJJJJJJ" );
+    Sequence< DNA > rev1 = Sequence< DNA >(
+                             "rev1", "GATTACAGGNTTAACGTCCATG",
+                             "JJJJJJJJJ#JJJJJJJJJJJJ" )
+                             .Reverse()
+                             .Complement();
+
+    res = merger.Merge( fwd1, rev1, &merged );
+    REQUIRE( res == true );
+    REQUIRE( merged.sequence == "GATTACAGGCTTAACGTCCATG" );
+  }
+
+  SECTION( "merged read buffer is reused" ) {
+    Merger< DNA >   merger( 5, 1.0 );
+    Sequence< DNA > fwd1 = Sequence< DNA >( "fwd1", "ACTGGATGGA", "JJJJJJJJJJ" );
+    Sequence< DNA > rev1 =
+      Sequence< DNA >( "rev1", "ATGGAATCCC", "JJJJJJJJJJ" ).Reverse().Complement();
+    Sequence< DNA > fwd2 = Sequence< DNA >( "fwd2", "ATCCCGGA", "JJJJJJJJ" );
+
+    REQUIRE( merger.Merge( fwd1, rev1, &merged ) == true );
+    REQUIRE( merger.Merge( fwd2, rev1, &merged ) == true );
+    REQUIRE( merged.identifier == "fwd2" );
+    REQUIRE( merged == Sequence< DNA >( "ATCCC" ) );
+    REQUIRE( merged.quality.length() == 5 );
+  }
+
+  SECTION( "overlap prior" ) {
+    Merger< DNA >   merger( 5, 1.0, 2 );
+    Sequence< DNA > fwd1 = Sequence< DNA >( "fwd1", "ACTGGATGGA", "JJJJJJJJJJ" );
+    Sequence< DNA > rev1 =
+      Sequence< DNA >( "rev1", "ATGGAATCCC", "JJJJJJJJJJ" ).Reverse().Complement();
+    Sequence< DNA > fwd2 = Sequence< DNA >( "fwd2", "ATCCCGGA", "JJJJJJJJ" );
+
+    REQUIRE( merger.Merge( fwd1, rev1, &merged ) == true );
+    REQUIRE( merger.PriorLengths().empty() );
+    REQUIRE( merger.Merge( fwd1, rev1, &merged ) == true );
+    REQUIRE( merger.PriorLengths() == std::vector< int >{ 5 } );
+
+    // Also staggered by the prior length
+    res = merger.Merge( fwd2, rev1, &merged );
+    REQUIRE( res == true );
+    REQUIRE( merged == Sequence< DNA >( "ATCCC" ) );
+
+    REQUIRE( merger.Merge( fwd1, rev1, &merged ) == true );
+    REQUIRE( merged == Sequence< DNA >( "ACTGGATGGAATCCC" ) );
+    REQUIRE( merger.OverlapLengths()[ 5 ] == 4 );
+  }
+
   SECTION( "posterior Q calculation" ) {
     Merger< DNA >   merger( 3, 1.0 );
     Sequence< DNA > fwd1 = Sequence< DNA >( "fwd1", "ATTGACCGT", "1>AA1@FFF" );
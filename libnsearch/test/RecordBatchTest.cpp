@@ -0,0 +1,144 @@
+#include <catch.hpp>
+
+#include <nsearch/Alphabet/DNA.h>
+#include <nsearch/FASTA/Reader.h>
+#include <nsearch/FASTQ/Reader.h>
+#include <nsearch/RecordBatch.h>
+
+#include <sstream>
+
+TEST_CASE( "RecordBatch" ) {
+  SECTION( "Arenas" ) {
+    RecordBatch batch;
+    REQUIRE( batch.Empty() );
+
+    batch.BeginRecord( LineView( "Seq1" ) );
+    batch.AppendSequence( LineView( "acg" ) );
+    batch.AppendSequence( LineView( "Tn" ) );
+    batch.AppendQuality( LineView( "JJJ" ) );
+    batch.AppendQuality( LineView( "AB" ) );
+    batch.EndRecord();
+
+    batch.BeginRecord( LineView( "Seq2" ) );
+    batch.AppendSequence( LineView( "TTT" ) );
+    batch.EndRecord();
+
+    REQUIRE( batch.Size() == 2 );
+    REQUIRE( batch.IdentifierAt( 0 ).ToString() == "Seq1" );
+    REQUIRE( batch.SequenceAt( 0 ).ToString() == "ACGTN" );
+    REQUIRE( batch.QualityAt( 0 ).ToString() == "JJJAB" );
+    REQUIRE( batch.IdentifierAt( 1 ).ToString() == "Seq2" );
+    REQUIRE( batch.SequenceAt( 1 ).ToString() == "TTT" );
+    REQUIRE( batch.QualityAt( 1 ).empty() );
+
+    // Contiguous
+    REQUIRE( batch.SequenceAt( 1 ).data ==
+             batch.SequenceAt( 0 ).data + batch.SequenceAt( 0 ).length );
+
+    Sequence< DNA > seq;
+    batch.Get( 0, &seq );
+    REQUIRE( seq.identifier == "Seq1" );
+    REQUIRE( seq.sequence == "ACGTN" );
+    REQUIRE( seq.quality == "JJJAB" );
+
+    RecordBatch copy;
+    copy.Add( batch, 1 );
+    REQUIRE( copy.Size() == 1 );
+    REQUIRE( copy.IdentifierAt( 0 ).ToString() == "Seq2" );
+    REQUIRE( copy.SequenceAt( 0 ).ToString() == "TTT" );
+
+    batch.Clear();
+    REQUIRE( batch.Empty() );
+  }
+
+  SECTION( "Read batch" ) {
+    std::istringstream   iss( "@Seq1\nacgt\n+\nJJJJ\n\n@Seq2\nTT\n+\nAB\n" );
+    FASTQ::Reader< DNA > reader( iss );
+
+    RecordBatch batch;
+    reader.Read( &batch );
+    REQUIRE( batch.Size() == 2 );
+    REQUIRE( batch.IdentifierAt( 1 ).ToString() == "Seq2" );
+    REQUIRE( batch.SequenceAt( 0 ).ToString() == "ACGT" );
+    REQUIRE( batch.QualityAt( 1 ).ToString() == "AB" );
+    REQUIRE( reader.EndOfFile() );
+
+    reader.Read( &batch );
+    REQUIRE( batch.Empty() );
+  }
+
+  SECTION( "Mixed with single reads" ) {
+    std::istringstream   iss( ">Seq1\nAC\n>Seq2\nGT\n>Seq3\nTT\n" );
+    FASTA::Reader< DNA > reader( iss );
+
+    Sequence< DNA > seq;
+    reader >> seq;
+    REQUIRE( seq.identifier == "Seq1" );
+
+    RecordBatch batch;
+    reader.Read( &batch );
+    REQUIRE( batch.Size() == 2 );
+    REQUIRE( batch.IdentifierAt( 0 ).ToString() == "Seq2" );
+    REQUIRE( batch.IdentifierAt( 1 ).ToString() == "Seq3" );
+    REQUIRE( reader.EndOfFile() );
+  }
+
+#if defined( __APPLE__ ) || defined( __unix__ )
+  SECTION( "Records cut by chunks" ) {
+    const char filename[] = "/tmp/recordbatchtest.tmp";
+
+    // Tiny buffers, so records span several chunks
+    auto openTinyChunks = [&]() {
+      return std::unique_ptr< TextReader >( new TextFileReader( filename, 5 ) );
+    };
+
+    SECTION( "FASTA" ) {
+      std::ofstream file( filename );
+      for( int i = 0; i < 100; i++ ) {
+        file << ">Seq" << i << "\n"
+             << std::string( i % 7, 'a' ) << "\n\n"
+             << std::string( i % 13, 'C' ) << "\n";
+      }
+      file.close();
+
+      FASTA::Reader< DNA > reader( openTinyChunks() );
+      Sequence< DNA >      seq;
+      for( int i = 0; i < 100; i++ ) {
+        reader >> seq;
+        REQUIRE( seq.identifier == "Seq" + std::to_string( i ) );
+        REQUIRE( seq.sequence ==
+                 std::string( i % 7, 'A' ) + std::string( i % 13, 'C' ) );
+      }
+      REQUIRE( reader.EndOfFile() );
+    }
+
+    SECTION( "FASTQ" ) {
+      std::ofstream file( filename );
+      for( int i = 0; i < 100; i++ ) {
+        file << "@Seq" << i << "\n"
+             << std::string( i % 11 + 1, 'g' ) << "\n+\n"
+             << std::string( i % 11 + 1, '@' ) << "\n";
+      }
+      file.close();
+
+      FASTQ::Reader< DNA > reader( openTinyChunks() );
+      RecordBatch          batch;
+      int                  numRecords = 0;
+      while( !reader.EndOfFile() ) {
+        reader.Read( &batch );
+        for( size_t i = 0; i < batch.Size(); i++, numRecords++ ) {
+          REQUIRE( batch.IdentifierAt( i ).ToString() ==
+                   "Seq" + std::to_string( numRecords ) );
+          REQUIRE( batch.SequenceAt( i ).ToString() ==
+                   std::string( numRecords % 11 + 1, 'G' ) );
+          REQUIRE( batch.QualityAt( i ).ToString() ==
+                   std::string( numRecords % 11 + 1, '@' ) );
+        }
+      }
+      REQUIRE( numRecords == 100 );
+    }
+
+    std::remove( filename );
+  }
+#endif
+}
@@ -0,0 +1,47 @@
+#include <catch.hpp>
+
+#include <nsearch/SAM/Writer.h>
+
+#include <sstream>
+
+const char SAMOutput[] = R"(@HD	VN:1.6	SO:unsorted
+@SQ	SN:Ref1	LN:25
+@SQ	SN:Ref2	LN:17
+@PG	ID:nsearch	PN:nsearch
+Query1	0	Ref1	4	255	7=3D9=	*	0	0	ATCGTGTACCAGGATG	ABCDEFGHIJKLMNOP	NM:i:3
+Query1	272	Ref2	3	255	6=1X8=1S	*	0	0	CATCCTGGTACACGAT	PONMLKJIHGFEDCBA	NM:i:1
+)";
+
+TEST_CASE( "SAM" ) {
+  auto entry = std::make_pair(
+    Sequence< DNA >( "Query1 sample=A", "ATCGTGTACCAGGATG",
+                     "ABCDEFGHIJKLMNOP" ),
+    HitList< DNA >( {
+      { { "Ref1 first", "TTTATCGTGTCCCACCAGGATGTTT" }, "3D7=3D9=3D",
+        DNA::Strand::Plus },
+      /*
+       *
+       *   ATCGTGTACCAGGATG (Query +Strand)
+       *   CATCCTGGTACACGAT (Query -Strand)
+       *   |||||| ||||||||
+       * TTCATCCTCGTACACGA- (Database +Strand)
+       *
+       */
+      { { "Ref2", "TTCATCCTCGTACACGA" }, "2D6=1X8=1I", DNA::Strand::Minus },
+    } ) );
+
+  std::ostringstream oss;
+  SAM::Writer< DNA > writer( oss );
+
+  SECTION( "With header" ) {
+    writer.WriteHeader( { entry.second[ 0 ].target, entry.second[ 1 ].target } );
+    writer << entry;
+    REQUIRE( oss.str() == SAMOutput );
+  }
+
+  SECTION( "Without header" ) {
+    writer << entry;
+    REQUIRE( oss.str().find( "@HD\tVN:1.6\tSO:unsorted\n@PG" ) == 0 );
+    REQUIRE( oss.str().find( "\nQuery1\t0\tRef1\t4\t" ) != std::string::npos );
+  }
+}
@@ -0,0 +1,157 @@
+#include <catch.hpp>
+
+#include <nsearch/Alphabet/DNA.h>
+#include <nsearch/FASTA/Reader.h>
+#include <nsearch/FASTA/Writer.h>
+#include <nsearch/FASTQ/Reader.h>
+#include <nsearch/SequenceIndex.h>
+
+#include <cstdio>
+#include <fstream>
+
+#if defined( __APPLE__ ) || defined( __unix__ )
+TEST_CASE( "SequenceIndex" ) {
+  const char filename[] = "/tmp/sequenceindextest.tmp";
+  std::string indexname = SequenceIndex::PathFor( filename );
+
+  SECTION( "FASTA" ) {
+    std::ofstream file( filename );
+    file << "\n>Seq1 first\nACGTA\nCGTAC\nGT\n"
+         << ">Seq2\nACG\nACGTA\n\n"
+         << ">Seq3\r\nACGT\r\nAC\r\n";
+    file.close();
+
+    SequenceIndex index;
+    REQUIRE( index.Build( filename ) );
+    REQUIRE( index.Size() == 3 );
+    REQUIRE( index.NumBytes() == 62 );
+
+    REQUIRE( index[ 0 ].name == "Seq1" );
+    REQUIRE( index[ 0 ].offset == 1 );
+    REQUIRE( index[ 0 ].sequenceOffset == 13 );
+    REQUIRE( index[ 0 ].length == 12 );
+    REQUIRE( index[ 0 ].lineBases == 5 );
+    REQUIRE( index[ 0 ].lineWidth == 6 );
+    REQUIRE( index[ 0 ].qualityOffset == 0 );
+
+    // Lines aren't alike
+    REQUIRE( index[ 1 ].offset == 28 );
+    REQUIRE( index[ 1 ].length == 8 );
+    REQUIRE( index[ 1 ].lineBases == 0 );
+    REQUIRE( index[ 1 ].lineWidth == 0 );
+
+    // '\r' is counted, like the reader keeps it
+    REQUIRE( index[ 2 ].offset == 45 );
+    REQUIRE( index[ 2 ].length == 8 );
+    REQUIRE( index[ 2 ].lineBases == 5 );
+    REQUIRE( index[ 2 ].lineWidth == 6 );
+
+    REQUIRE( index.Find( "Seq2" ) == 1 );
+    REQUIRE( index.Find( "Seq4" ) == 3 );
+
+    SECTION( "Sidecar" ) {
+      REQUIRE( index.Write( indexname ) );
+
+      SequenceIndex read;
+      REQUIRE( read.Read( indexname ) );
+      REQUIRE( read.Size() == 3 );
+      REQUIRE( read.NumBytes() == index.NumBytes() );
+      for( size_t i = 0; i < read.Size(); i++ ) {
+        REQUIRE( read[ i ].name == index[ i ].name );
+        REQUIRE( read[ i ].length == index[ i ].length );
+        REQUIRE( read[ i ].offset == index[ i ].offset );
+        REQUIRE( read[ i ].sequenceOffset == index[ i ].sequenceOffset );
+        REQUIRE( read[ i ].lineBases == index[ i ].lineBases );
+        REQUIRE( read[ i ].lineWidth == index[ i ].lineWidth );
+      }
+      REQUIRE( read.Find( "Seq3" ) == 2 );
+
+      REQUIRE( !read.Read( "garbagepath" ) );
+    }
+
+    SECTION( "Record range" ) {
+      FASTA::Reader< DNA > reader( filename, index, 1, 3, 1 );
+      Sequence< DNA >      seq;
+
+      REQUIRE( reader.Read( &seq ) );
+      REQUIRE( seq.identifier == "Seq2" );
+      REQUIRE( seq.sequence == "ACGACGTA" );
+      REQUIRE( reader.Read( &seq ) );
+      REQUIRE( seq.identifier == "Seq3\r" );
+      REQUIRE( !reader.Read( &seq ) );
+      REQUIRE( reader.NumBytesRead() == reader.NumBytesTotal() );
+    }
+
+    SECTION( "Single record" ) {
+      FASTA::Reader< DNA > reader( filename, index, 0, 1 );
+      Sequence< DNA >      seq;
+
+      REQUIRE( reader.Read( &seq ) );
+      REQUIRE( seq.identifier == "Seq1 first" );
+      REQUIRE( seq.sequence == "ACGTACGTACGT" );
+      REQUIRE( reader.EndOfFile() );
+    }
+  }
+
+  SECTION( "FASTQ" ) {
+    std::ofstream file( filename );
+    file << "@Seq1\nACGT\n+\n@@@@\n"
+         << "@Seq2 second\nTTGCA\n+Seq2\nIIIII\n";
+    file.close();
+
+    SequenceIndex index;
+    REQUIRE( index.Build( filename ) );
+    REQUIRE( index.Size() == 2 );
+
+    // Quality lines starting with '@' are no headers
+    REQUIRE( index[ 0 ].qualityOffset == 13 );
+    REQUIRE( index[ 1 ].name == "Seq2" );
+    REQUIRE( index[ 1 ].offset == 18 );
+    REQUIRE( index[ 1 ].length == 5 );
+    REQUIRE( index[ 1 ].qualityOffset == 43 );
+
+    FASTQ::Reader< DNA > reader( filename, index, 1, 2 );
+    Sequence< DNA >      seq;
+    REQUIRE( reader.Read( &seq ) );
+    REQUIRE( seq.identifier == "Seq2 second" );
+    REQUIRE( seq.quality == "IIIII" );
+    REQUIRE( reader.EndOfFile() );
+  }
+
+#ifdef USE_ZLIB
+  SECTION( "Compressed" ) {
+    {
+      FASTA::Writer< DNA > writer( std::string( filename ) + ".gz" );
+      writer << Sequence< DNA >( "Seq1", "ACGT" );
+      writer << Sequence< DNA >( "Seq2", "TTTT" );
+    }
+
+    SequenceIndex index;
+    REQUIRE( index.Build( std::string( filename ) + ".gz" ) );
+    REQUIRE( index.Size() == 2 );
+
+    FASTA::Reader< DNA > reader( std::string( filename ) + ".gz", index, 1,
+                                 2 );
+    Sequence< DNA > seq;
+    REQUIRE( reader.Read( &seq ) );
+    REQUIRE( seq.identifier == "Seq2" );
+    REQUIRE( seq.sequence == "TTTT" );
+    REQUIRE( reader.EndOfFile() );
+
+    std::remove( ( std::string( filename ) + ".gz" ).c_str() );
+  }
+#endif
+
+  SECTION( "Not FASTA/FASTQ" ) {
+    std::ofstream file( filename );
+    file << "Hello\n";
+    file.close();
+
+    SequenceIndex index;
+    REQUIRE( !index.Build( filename ) );
+  }
+
+  std::remove( filename );
+  std::remove( indexname.c_str() );
+}
+#endif
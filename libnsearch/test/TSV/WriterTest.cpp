@@ -0,0 +1,41 @@
+#include <catch.hpp>
+
+#include <nsearch/TSV/Writer.h>
+
+#include <sstream>
+
+TEST_CASE( "TSV" ) {
+  auto entry = std::make_pair(
+    Sequence< DNA >( "Query 1", "ATCGTGTACCAGGATG" ),
+    HitList< DNA >( {
+      { { "Ref,1", "TTTATCGTGTCCCACCAGGATGTTT" }, "3D7=3D9=3D",
+        DNA::Strand::Plus },
+      { { "Ref2", "TTCATCCTCGTACACGA" }, "2D6=1X8=1I", DNA::Strand::Minus },
+    } ) );
+
+  std::ostringstream oss;
+
+  SECTION( "Default columns" ) {
+    TSV::Writer< DNA > writer( oss );
+    writer << entry;
+    REQUIRE( oss.str() == "Query 1\tRef,1\t84.2\t19\t0\t1\t1\t16\t4\t22\n"
+                          "Query 1\tRef2\t93.3\t15\t1\t0\t16\t2\t3\t17\n" );
+  }
+
+  SECTION( "Selected columns" ) {
+    TSV::Columns columns;
+    REQUIRE( TSV::ParseColumns( "target+qstrand+gaps+ql+tl+cigar", &columns ) );
+
+    TSV::Writer< DNA > writer( oss, columns );
+    writer << entry;
+    REQUIRE( oss.str() == "Ref,1\t+\t3\t16\t25\t7=3D9=\n"
+                          "Ref2\t-\t0\t16\t17\t6=1X8=\n" );
+  }
+
+  SECTION( "Unknown columns" ) {
+    TSV::Columns columns;
+    REQUIRE( !TSV::ParseColumns( "query+bitscore", &columns ) );
+    REQUIRE( !TSV::ParseColumns( "query++id", &columns ) );
+    REQUIRE( !TSV::ParseColumns( "", &columns ) );
+  }
+}
@@ -4,6 +4,14 @@
 
 #include <sstream>
 
+// Like a pipe, can't seek
+class UnseekableBuffer : public std::streambuf {
+public:
+  UnseekableBuffer( std::string* data ) {
+    setg( &( *data )[ 0 ], &( *data )[ 0 ], &( *data )[ 0 ] + data->size() );
+  }
+};
+
 TEST_CASE( "TextReader" ) {
 
 #if defined( __APPLE__ ) || defined( __unix__ )
@@ -40,6 +48,123 @@ TEST_CASE( "TextReader" ) {
 
       REQUIRE( reader.EndOfFile() == true );
     }
+
+    SECTION( "Read-ahead" ) {
+      const char    filename[] = "/tmp/textreadertest.tmp";
+      std::ofstream file( filename );
+      for( int i = 0; i < 1000; i++ ) {
+        file << "Line " << i << std::endl;
+      }
+      file.close();
+
+      // Lines straddle the tiny buffers
+      std::string    line;
+      TextFileReader reader( filename, 7, 2 );
+      for( int i = 0; i < 1000; i++ ) {
+        REQUIRE( reader.EndOfFile() == false );
+        reader >> line;
+        REQUIRE( line == "Line " + std::to_string( i ) );
+      }
+      REQUIRE( reader.EndOfFile() == true );
+
+      // Stop reading ahead early
+      TextFileReader reader2( filename, 7, 3 );
+      reader2 >> line;
+      REQUIRE( line == "Line 0" );
+
+      std::remove( filename );
+    }
+
+#ifdef USE_ZLIB
+    SECTION( "Compressed" ) {
+      const char filename[] = "/tmp/textreadertest.tmp.gz";
+      gzFile     file       = gzopen( filename, "wb" );
+      gzputs( file, "Hello\n\nWorld\n" );
+      gzclose( file );
+
+      std::string line;
+      auto        reader = OpenTextFile( filename );
+      *reader >> line;
+      REQUIRE( line == "Hello" );
+      *reader >> line;
+      REQUIRE( line == "World" );
+      REQUIRE( reader->EndOfFile() == true );
+
+      std::remove( filename );
+    }
+#endif
+  }
+
+  SECTION( "Mapped file" ) {
+    const char filename[] = "/tmp/textreadertest.tmp";
+
+    SECTION( "Lines" ) {
+      std::ofstream file( filename );
+      file << "\n  \nHello" << std::endl
+           << std::endl
+           << "Happy " << std::endl
+           << "World\n \n";
+      file.close();
+
+      MappedTextFileReader reader( filename );
+      REQUIRE( reader.IsMapped() );
+      REQUIRE( reader.NumBytesTotal() == 26 );
+
+      LineView line = reader.ReadLine();
+      REQUIRE( line.ToString() == "Hello" );
+
+      std::string str;
+      reader >> str;
+      REQUIRE( str == "Happy " );
+
+      REQUIRE( reader.EndOfFile() == false );
+      line = reader.ReadLine();
+      REQUIRE( line.ToString() == "World" );
+
+      // Trailing blank lines are skipped
+      REQUIRE( reader.EndOfFile() == true );
+      REQUIRE( reader.NumBytesRead() == reader.NumBytesTotal() );
+      REQUIRE( reader.ReadLine().empty() );
+    }
+
+    SECTION( "No trailing newline" ) {
+      std::ofstream file( filename );
+      file << "Hello\nWorld";
+      file.close();
+
+      MappedTextFileReader reader( filename );
+      REQUIRE( reader.ReadLine().ToString() == "Hello" );
+      REQUIRE( reader.ReadLine().ToString() == "World" );
+      REQUIRE( reader.EndOfFile() == true );
+    }
+
+    SECTION( "Range" ) {
+      std::ofstream file( filename );
+      file << "Hello\nHappy\nWorld\n";
+      file.close();
+
+      MappedTextFileReader reader( filename, 6, 12 );
+      REQUIRE( reader.NumBytesTotal() == 6 );
+      REQUIRE( reader.ReadLine().ToString() == "Happy" );
+      REQUIRE( reader.EndOfFile() == true );
+      REQUIRE( reader.NumBytesRead() == 6 );
+    }
+
+    SECTION( "Fallback" ) {
+      // Empty and compressed files are read chunk by chunk
+      std::ofstream file( filename );
+      file << "\x1F\x8B";
+      file.close();
+      REQUIRE( MappedTextFileReader( filename ).IsMapped() == false );
+
+      auto reader = OpenTextFile( filename );
+      REQUIRE( dynamic_cast< TextFileReader* >( reader.get() ) != NULL );
+
+      REQUIRE( MappedTextFileReader( "garbagepath" ).IsMapped() == false );
+      REQUIRE( OpenTextFile( "garbagepath" )->EndOfFile() == true );
+    }
+
+    std::remove( filename );
   }
 #endif
 
@@ -57,5 +182,59 @@ TEST_CASE( "TextReader" ) {
     REQUIRE( line == "Is up" );
 
     REQUIRE( reader.EndOfFile() == true );
+    REQUIRE( reader.NumBytesTotal() == 19 );
+    REQUIRE( reader.NumBytesRead() == 19 );
+  }
+
+  SECTION( "Unseekable stream" ) {
+    std::string      data = "Hello\nWorld";
+    UnseekableBuffer buffer( &data );
+    std::istream     is( &buffer );
+
+    std::string      line;
+    TextStreamReader reader( is );
+    REQUIRE( reader.NumBytesTotal() == 0 );
+
+    reader >> line;
+    REQUIRE( line == "Hello" );
+    REQUIRE( reader.NumBytesRead() == 6 );
+
+    REQUIRE( reader.ReadChunk().ToString() == "World" );
+    REQUIRE( reader.NumBytesRead() == 11 );
+    REQUIRE( reader.EndOfFile() == true );
+  }
+
+  SECTION( "Range" ) {
+    std::istringstream iss( "Hello\nHappy\n\nWorld\nBye\n" );
+
+    SECTION( "Lines" ) {
+      std::string     line;
+      TextRangeReader reader(
+        std::unique_ptr< TextReader >( new TextStreamReader( iss ) ), 6, 19 );
+      REQUIRE( reader.NumBytesTotal() == 13 );
+
+      reader >> line;
+      REQUIRE( line == "Happy" );
+      reader >> line;
+      REQUIRE( line == "World" );
+      REQUIRE( reader.EndOfFile() == true );
+      REQUIRE( reader.NumBytesRead() == 13 );
+    }
+
+    SECTION( "Chunks" ) {
+      TextRangeReader reader(
+        std::unique_ptr< TextReader >( new TextStreamReader( iss ) ), 12 );
+      REQUIRE( reader.NumBytesTotal() == 0 );
+
+      REQUIRE( reader.ReadChunk().ToString() == "\nWorld\nBye\n" );
+      REQUIRE( reader.EndOfFile() == true );
+    }
+
+    SECTION( "Past the end" ) {
+      TextRangeReader reader(
+        std::unique_ptr< TextReader >( new TextStreamReader( iss ) ), 100 );
+      REQUIRE( reader.EndOfFile() == true );
+      REQUIRE( reader.ReadChunk().empty() );
+    }
   }
 }
@@ -7,5 +7,9 @@ TEST_CASE( "Utils" ) {
     std::string str = "AcGt";
     UpcaseString( str );
     REQUIRE( str == "ACGT" );
+
+    str = "@az[`{";
+    UpcaseString( str );
+    REQUIRE( str == "@AZ[`{" );
   }
 }
@@ -117,8 +117,13 @@ private:
     // Show one decimal point
     os << std::setiosflags( std::ios::fixed ) << std::setprecision( 1 );
     os << std::right << std::setw( maxLabelLen ) << stage.label << ": ";
-    os << float( stage.value ) / stage.max * 100.0 << '%';
-    os << " (" << ValueWithUnit( stage.value, stage.unit ) << ")";
+    if( stage.max > 0 ) {
+      os << float( stage.value ) / stage.max * 100.0 << '%';
+      os << " (" << ValueWithUnit( stage.value, stage.unit ) << ")";
+    } else {
+      // Total unknown (e.g. reading from a pipe)
+      os << ValueWithUnit( stage.value, stage.unit );
+    }
     os << std::string( 20, ' ' ) << "\r" << std::flush;
     os.flags( f );
   }
@@ -0,0 +1,43 @@
+#include "Convert.h"
+
+#include <nsearch/Alphabet/DNA.h>
+#include <nsearch/Alphabet/Protein.h>
+#include <nsearch/Sequence.h>
+
+#include "Common.h"
+#include "FileFormat.h"
+
+template < typename Alphabet >
+bool DoConvert( const std::string& inputPath, const std::string& outputPath ) {
+  auto reader =
+    DetectFileFormatAndOpenReader< Alphabet >( inputPath, FileFormat::FASTA );
+  if( !reader )
+    return false;
+
+  auto writer =
+    DetectFileFormatAndOpenWriter< Alphabet >( outputPath, FileFormat::NSB );
+
+  enum ProgressType { Convert };
+
+  ProgressOutput progress;
+  progress.Add( ProgressType::Convert, "Convert sequences", UnitType::BYTES );
+
+  // Streamed, the input is never held in memory completely
+  RecordBatch          batch;
+  Sequence< Alphabet > seq;
+  progress.Activate( ProgressType::Convert );
+  while( !reader->EndOfFile() ) {
+    reader->Read( &batch );
+    for( size_t i = 0; i < batch.Size(); i++ ) {
+      batch.Get( i, &seq );
+      ( *writer ) << seq;
+    }
+    progress.Set( ProgressType::Convert, reader->NumBytesRead(),
+                  reader->NumBytesTotal() );
+  }
+
+  return !ReportReadFailure( *reader, inputPath );
+}
+
+template bool DoConvert< DNA >( const std::string&, const std::string& );
+template bool DoConvert< Protein >( const std::string&, const std::string& );
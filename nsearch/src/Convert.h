@@ -0,0 +1,7 @@
+#pragma once
+
+#include <string>
+
+template < typename Alphabet >
+extern bool DoConvert( const std::string& inputPath,
+                       const std::string& outputPath );
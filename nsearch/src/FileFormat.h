@@ -1,5 +1,6 @@
 #pragma once
 
+#include <iostream>
 #include <string>
 #include <vector>
 #include <map>
@@ -9,27 +10,45 @@
 #include <nsearch/FASTQ/Writer.h>
 #include <nsearch/FASTA/Reader.h>
 #include <nsearch/FASTQ/Reader.h>
+#include <nsearch/NSB/Writer.h>
+#include <nsearch/NSB/Reader.h>
 
 // Hits
 #include <nsearch/Alnout/Writer.h>
 #include <nsearch/CSV/Writer.h>
+#include <nsearch/SAM/Writer.h>
+#include <nsearch/BAM/Writer.h>
+#include <nsearch/TSV/Writer.h>
 
 enum class FileFormat {
   FASTA,
   FASTQ,
+  NSB,
   ALNOUT,
   CSV,
+  SAM,
+  BAM,
+  TSV,
 };
 
 using StringList = std::vector< std::string > ;
 static const std::map< FileFormat, StringList > FileFormatEndings = {
   { FileFormat::FASTA, { "fa", "fna", "fsa", "fasta" } },
   { FileFormat::FASTQ, { "fq", "fastq" } },
+  { FileFormat::NSB, { "nsb" } },
   { FileFormat::ALNOUT, { "aln", "alnout" } },
   { FileFormat::CSV, { "csv" } },
+  { FileFormat::SAM, { "sam" } },
+  { FileFormat::TSV, { "tsv", "b6" } },
+#ifdef USE_ZLIB
+  { FileFormat::BAM, { "bam" } },
+#endif
 };
 
-static FileFormat InferFileFormat( const std::string& filepath, const FileFormat defaultFormat ) {
+// Compressed files (e.g. reads.fastq.gz) are read and written transparently,
+// the format is given by the extension before .gz
+static FileFormat InferFileFormat( const std::string& path, const FileFormat defaultFormat ) {
+  auto filepath = IsGzipFileName( path ) ? path.substr( 0, path.size() - 3 ) : path;
   auto pos = filepath.find_last_of( "." );
   if( pos == std::string::npos )
     return defaultFormat;
@@ -51,12 +70,17 @@ static std::unique_ptr< SequenceWriter < A > > DetectFileFormatAndOpenWriter( co
       return std::unique_ptr< SequenceWriter< A > >(
         new FASTQ::Writer< A >( path ) );
 
+    case FileFormat::NSB:
+      return std::unique_ptr< SequenceWriter< A > >(
+        new NSB::Writer< A >( path ) );
+
     default:
       return std::unique_ptr< SequenceWriter< A > >(
         new FASTA::Writer< A >( path ) );
   }
 }
 
+// Null (with the reason printed) if the file can't be read
 template < typename A >
 static std::unique_ptr< SequenceReader < A > > DetectFileFormatAndOpenReader( const std::string &path, const FileFormat defaultFormat ) {
   switch( InferFileFormat( path, defaultFormat ) ) {
@@ -64,19 +88,53 @@ static std::unique_ptr< SequenceReader < A > > DetectFileFormatAndOpenReader( co
       return std::unique_ptr< SequenceReader< A > >(
         new FASTQ::Reader< A >( path ) );
 
+    case FileFormat::NSB: {
+      std::unique_ptr< NSB::Reader< A > > reader( new NSB::Reader< A >( path ) );
+      if( !reader->IsValid() ) {
+        std::cerr << path << " is not a valid NSB file" << std::endl;
+        return nullptr;
+      }
+      return std::unique_ptr< SequenceReader< A > >( reader.release() );
+    }
+
     default:
       return std::unique_ptr< SequenceReader< A > >(
         new FASTA::Reader< A >( path ) );
   }
 }
 
+// Tells why if the reader stopped before the end of the file
+template < typename A >
+static bool ReportReadFailure( const SequenceReader< A > &reader, const std::string &path ) {
+  if( !reader.Failed() )
+    return false;
+
+  // Below the progress output
+  std::cerr << std::endl << path << " is truncated or corrupt" << std::endl;
+  return true;
+}
+
 template < typename A >
-static std::unique_ptr< HitWriter < A > > DetectFileFormatAndOpenHitWriter( const std::string &path, const FileFormat defaultFormat ) {
+static std::unique_ptr< HitWriter < A > > DetectFileFormatAndOpenHitWriter( const std::string &path, const FileFormat defaultFormat, const TSV::Columns &columns = TSV::ParseColumns( TSV::DefaultColumns ) ) {
   switch( InferFileFormat( path, defaultFormat ) ) {
     case FileFormat::CSV:
       return std::unique_ptr< HitWriter< A > >(
         new CSV::Writer< A >( path ) );
 
+    case FileFormat::SAM:
+      return std::unique_ptr< HitWriter< A > >(
+        new SAM::Writer< A >( path ) );
+
+    case FileFormat::TSV:
+      return std::unique_ptr< HitWriter< A > >(
+        new TSV::Writer< A >( path, columns ) );
+
+#ifdef USE_ZLIB
+    case FileFormat::BAM:
+      return std::unique_ptr< HitWriter< A > >(
+        new BAM::Writer< A >( path ) );
+#endif
+
     default:
       return std::unique_ptr< HitWriter< A > >(
         new Alnout::Writer< A >( path ) );
@@ -10,6 +10,8 @@ bool DoFilter( const std::string& inputPath, const std::string& outputPath,
              const float maxExpectedErrors ) {
   auto reader =
     DetectFileFormatAndOpenReader< DNA >( inputPath, FileFormat::FASTQ );
+  if( !reader )
+    return false;
 
   enum ProgressType { ReadFile, Filter, WriteFile };
 
@@ -22,12 +24,13 @@ bool DoFilter( const std::string& inputPath, const std::string& outputPath,
   SequenceList< DNA > sequences;
   Sequence< DNA >     seq;
   progress.Activate( ProgressType::ReadFile );
-  while( !reader->EndOfFile() ) {
-    ( *reader ) >> seq;
+  while( reader->Read( &seq ) ) {
     sequences.push_back( std::move( seq ) );
     progress.Set( ProgressType::ReadFile, reader->NumBytesRead(),
                   reader->NumBytesTotal() );
   }
+  if( ReportReadFailure( *reader, inputPath ) )
+    return false;
 
   // Filter
   SequenceList< DNA > filtered;
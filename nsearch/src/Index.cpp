@@ -0,0 +1,29 @@
+#include "Index.h"
+
+#include <nsearch/SequenceIndex.h>
+
+#include <iostream>
+
+#include "Stats.h"
+
+bool DoIndex( const std::string& inputPath ) {
+  if( inputPath == "-" ) {
+    std::cerr << "Can't index stdin" << std::endl;
+    return false;
+  }
+
+  SequenceIndex index;
+  if( !index.Build( inputPath ) ) {
+    std::cerr << inputPath << " is not FASTA or FASTQ" << std::endl;
+    return false;
+  }
+
+  auto indexPath = SequenceIndex::PathFor( inputPath );
+  if( !index.Write( indexPath ) ) {
+    std::cerr << "Can't write " << indexPath << std::endl;
+    return false;
+  }
+
+  gStats.numProcessed += index.Size();
+  return true;
+}
@@ -0,0 +1,5 @@
+#pragma once
+
+#include <string>
+
+extern bool DoIndex( const std::string& inputPath );
@@ -10,7 +10,9 @@
 #include <nsearch/Alphabet/Protein.h>
 
 #include "Common.h"
+#include "Convert.h"
 #include "Filter.h"
+#include "Index.h"
 #include "Merge.h"
 #include "Search.h"
 #include "Stats.h"
@@ -22,9 +24,11 @@ static const char USAGE[] = R"(
 
   Usage:
     nsearch search --query=<queryfile> --db=<databasefile>
-      --out=<outputfile> --min-identity=<minidentity> [--max-hits=<maxaccepts>] [--max-rejects=<maxrejects>] [--protein] [--strand=<strand>]
-    nsearch merge --forward=<forwardfile> --reverse=<reversefile> --out=<outputfile>
+      --out=<outputfile> --min-identity=<minidentity> [--max-hits=<maxaccepts>] [--max-rejects=<maxrejects>] [--protein] [--strand=<strand>] [--unordered] [--columns=<columns>]
+    nsearch merge --forward=<forwardfile> --reverse=<reversefile> --out=<outputfile> [--unordered] [--overlap-prior=<numpairs>]
     nsearch filter --in=<inputfile> --out=<outputfile> [--max-expected-errors=<maxee>]
+    nsearch convert --in=<inputfile> --out=<outputfile> [--protein]
+    nsearch index --in=<inputfile>
 
   Options:
     --min-identity=<minidentity>    Minimum identity threshold (e.g. 0.8).
@@ -32,6 +36,11 @@ static const char USAGE[] = R"(
     --max-rejects=<maxrejects>      Abort after this many candidates were rejected [default: 16].
     --max-expected-errors=<maxee>   Maximum number of expected errors [default: 1.0].
     --strand=<strand>               Strand to search on (plus, minus or both). If minus (or both), queries are reverse complemented [default: both].
+    --columns=<columns>             Columns of tab-separated output (.tsv, .b6), joined by + [default: query+target+id+alnlen+mism+opens+qlo+qhi+tlo+thi].
+    --unordered                     Write results as soon as they are ready instead of in input order.
+    --overlap-prior=<numpairs>      Learn the most common overlap lengths from this many pairs (per thread) and try those first, 0 for none [default: 0].
+
+  Files can be - for stdin or stdout. Their format is FASTQ for merge, ALNOUT for search output, NSB (binary, see convert) for convert output and FASTA otherwise, except for filter input (FASTQ). NSB files can be used in place of FASTA or FASTQ input. index writes the record offsets of a FASTA/FASTQ file to <inputfile>.nsi.
 )";
 
 void PrintSummaryHeader() {
@@ -85,6 +94,11 @@ int main( int argc, const char** argv ) {
                               true, // help
                               APP_NAME );
 
+  // Output written to stdout ("-") must not be mixed with our messages
+  if( args[ "--out" ] && args[ "--out" ].asString() == "-" ) {
+    std::cout.rdbuf( std::cerr.rdbuf() );
+  }
+
   // Print header
   std::cout << APP_NAME << " " << APP_VERSION << " (built on "
             << BUILD_TIMESTAMP << ")" << std::endl;
@@ -96,26 +110,46 @@ int main( int argc, const char** argv ) {
     auto query      = args[ "--query" ].asString();
     auto db         = args[ "--db" ].asString();
     auto out        = args[ "--out" ].asString();
+    auto ordered    = !args[ "--unordered" ].asBool();
 
+    TSV::Columns columns;
+    if( !TSV::ParseColumns( args[ "--columns" ].asString(), &columns ) ) {
+      std::cerr << "Unknown column in " << args[ "--columns" ].asString()
+                << std::endl;
+      return 1;
+    }
 
+    bool ok;
     if( args[ "--protein" ].asBool() ) {
-      DoSearch< Protein >( query, db, out, ParseSearchParams< Protein >( args ) );
+      ok = DoSearch< Protein >( query, db, out,
+                                ParseSearchParams< Protein >( args ), ordered,
+                                columns );
     } else {
-      DoSearch< DNA >( query, db, out, ParseSearchParams< DNA >( args ) );
+      ok = DoSearch< DNA >( query, db, out, ParseSearchParams< DNA >( args ),
+                            ordered, columns );
     }
+    if( !ok )
+      return 1;
 
     gStats.StopTimer();
 
     PrintSummaryHeader();
     PrintSummaryLine( gStats.ElapsedMillis() / 1000.0, "Seconds" );
+    PrintSummaryLine( gStats.numProcessed, "Queries" );
+    PrintSummaryLine( gStats.numExtensions, "Seed extensions" );
+    PrintSummaryLine( gStats.ExtensionsSavedPerQuery(),
+                      "Seed extensions saved/query" );
   }
 
   // Merge
   if( args[ "merge" ].asBool() ) {
     gStats.StartTimer();
 
-    DoMerge( args[ "--forward" ].asString(), args[ "--reverse" ].asString(),
-           args[ "--out" ].asString() );
+    if( !DoMerge( args[ "--forward" ].asString(),
+                  args[ "--reverse" ].asString(), args[ "--out" ].asString(),
+                  !args[ "--unordered" ].asBool(),
+                  args[ "--overlap-prior" ].asLong() ) )
+      return 1;
 
     gStats.StopTimer();
 
@@ -126,6 +160,12 @@ int main( int argc, const char** argv ) {
     PrintSummaryLine( gStats.numProcessed, "Pairs" );
     PrintSummaryLine( gStats.numMerged, "Merged", gStats.numProcessed );
     PrintSummaryLine( gStats.MeanMergedLength(), "Mean merged length" );
+    for( auto& length : gStats.MostCommonOverlapLengths( 5 ) ) {
+      PrintSummaryLine( length.second,
+                        "Overlap of " + std::to_string( length.first ) +
+                          " bases",
+                        gStats.numMerged );
+    }
   }
 
   // Filter
@@ -136,12 +176,49 @@ int main( int argc, const char** argv ) {
     auto out   = args[ "--out" ].asString();
     auto maxee = std::stof( args[ "--max-expected-errors" ].asString() );
 
-    DoFilter( in, out, maxee );
+    if( !DoFilter( in, out, maxee ) )
+      return 1;
+
+    gStats.StopTimer();
+
+    PrintSummaryHeader();
+    PrintSummaryLine( gStats.ElapsedMillis() / 1000.0, "Seconds" );
+  }
+
+  // Convert
+  if( args[ "convert" ].asBool() ) {
+    gStats.StartTimer();
+
+    auto in  = args[ "--in" ].asString();
+    auto out = args[ "--out" ].asString();
+
+    bool ok;
+    if( args[ "--protein" ].asBool() ) {
+      ok = DoConvert< Protein >( in, out );
+    } else {
+      ok = DoConvert< DNA >( in, out );
+    }
+    if( !ok )
+      return 1;
+
+    gStats.StopTimer();
+
+    PrintSummaryHeader();
+    PrintSummaryLine( gStats.ElapsedMillis() / 1000.0, "Seconds" );
+  }
+
+  // Index
+  if( args[ "index" ].asBool() ) {
+    gStats.StartTimer();
+
+    if( !DoIndex( args[ "--in" ].asString() ) )
+      return 1;
 
     gStats.StopTimer();
 
     PrintSummaryHeader();
     PrintSummaryLine( gStats.ElapsedMillis() / 1000.0, "Seconds" );
+    PrintSummaryLine( gStats.numProcessed, "Records" );
   }
 
   return 0;
@@ -6,40 +6,79 @@
 #include <nsearch/Alphabet/DNA.h>
 
 #include <memory>
+#include <mutex>
+#include <vector>
 
 #include "Common.h"
 #include "FileFormat.h"
 #include "Stats.h"
 #include "WorkerQueue.h"
 
+// The first numReads reads are merged, the others are left over from
+// earlier batches (see MergedReadsPool)
 template < typename A >
-class QueueItemInfo< SequenceList< A > > {
+struct MergedReads {
+  std::vector< Sequence< A > > reads;
+  size_t                       numReads = 0;
+};
+
+template < typename A >
+class QueueItemInfo< MergedReads< A > > {
 public:
-  static size_t Count( const SequenceList< A >& list ) {
-    return list.size();
+  static size_t Count( const MergedReads< A >& item ) {
+    return item.numReads;
   }
 };
 
+// Reads the writer is done with, so the merge workers can merge into them
+// again without allocating
+template < typename A >
+class MergedReadsPool {
+public:
+  std::vector< Sequence< A > > Take() {
+    std::lock_guard< std::mutex > lock( mMutex );
+    std::vector< Sequence< A > >  reads;
+    if( !mReads.empty() ) {
+      reads = std::move( mReads.back() );
+      mReads.pop_back();
+    }
+    return reads;
+  }
+
+  void Return( std::vector< Sequence< A > >* reads ) {
+    std::lock_guard< std::mutex > lock( mMutex );
+    mReads.push_back( std::move( *reads ) );
+  }
+
+private:
+  std::mutex                                  mMutex;
+  std::vector< std::vector< Sequence< A > > > mReads;
+};
+
 template < typename A >
 class MergedReadWriterWorker {
 public:
-  MergedReadWriterWorker( const std::string& path )
+  MergedReadWriterWorker( const std::string& path, MergedReadsPool< A >* pool )
       : mWriter( std::move(
-          DetectFileFormatAndOpenWriter< A >( path, FileFormat::FASTQ ) ) ) {}
+          DetectFileFormatAndOpenWriter< A >( path, FileFormat::FASTQ ) ) ),
+        mPool( *pool ) {}
 
-  void Process( const SequenceList< A >& queueItem ) {
-    for( auto seq : queueItem ) {
-      ( *mWriter ) << seq;
+  void Process( MergedReads< A >& queueItem ) {
+    for( size_t i = 0; i < queueItem.numReads; i++ ) {
+      ( *mWriter ) << queueItem.reads[ i ];
     }
+    mPool.Return( &queueItem.reads );
   }
 
 private:
   std::unique_ptr< SequenceWriter< A > > mWriter;
+  MergedReadsPool< A >&                  mPool;
 };
 
 template < typename A >
-using MergedReadWriter = WorkerQueue< MergedReadWriterWorker< A >,
-                                      SequenceList< A >, const std::string& >;
+using MergedReadWriter =
+  WorkerQueue< MergedReadWriterWorker< A >, MergedReads< A >,
+               const std::string&, MergedReadsPool< A >* >;
 
 template < typename A >
 using PairedReads = std::pair< SequenceList< A >, SequenceList< A > >;
@@ -55,52 +94,81 @@ public:
 template < typename A >
 class ReadMergerWorker {
 public:
-  ReadMergerWorker( MergedReadWriter< A >* writer ) : mWriter( *writer ) {}
-
-  void Process( const PairedReads< A >& queueItem ) {
-    const SequenceList< A >& fwd = queueItem.first;
-    const SequenceList< A >& rev = queueItem.second;
+  ReadMergerWorker( MergedReadWriter< A >* writer, MergedReadsPool< A >* pool,
+                    const size_t numPriorPairs )
+      : mWriter( *writer ), mPool( *pool ),
+        mMerger( PairedEnd::MERGER_DEFAULT_MIN_OVERLAP,
+                 PairedEnd::MERGER_DEFAULT_MIN_IDENTITY, numPriorPairs ) {}
+
+  ~ReadMergerWorker() {
+    gStats.AddOverlapLengths( mMerger.OverlapLengths() );
+  }
 
-    const PairedEnd::Merger< A >& merger = mMerger;
+  void Process( const Numbered< PairedReads< A > >& queueItem ) {
+    const SequenceList< A >& fwd = queueItem.second.first;
+    const SequenceList< A >& rev = queueItem.second.second;
 
-    Sequence< A >     mergedRead;
-    SequenceList< A > mergedReads;
+    MergedReads< A > merged;
+    merged.reads = mPool.Take();
 
+    // Merged in place, into reads the writer is done with if there are any
     auto fit = fwd.begin();
     auto rit = rev.begin();
     while( fit != fwd.end() && rit != rev.end() ) {
-      if( merger.Merge( *fit, *rit, &mergedRead ) ) {
+      if( merged.numReads == merged.reads.size() )
+        merged.reads.emplace_back();
+
+      Sequence< A >& mergedRead = merged.reads[ merged.numReads ];
+      if( mMerger.Merge( *fit, *rit, &mergedRead ) ) {
         gStats.numMerged++;
         gStats.mergedReadsTotalLength += mergedRead.Length();
-        mergedReads.push_back( std::move( mergedRead ) );
+        merged.numReads++;
       }
 
       ++fit;
       ++rit;
     }
 
-    if( !mergedReads.empty() )
-      mWriter.Enqueue( mergedReads );
+    // Even if empty, the writer might wait for it to keep the order
+    mWriter.Enqueue( merged, queueItem.first );
 
     gStats.numProcessed += fwd.size();
   }
 
 private:
   MergedReadWriter< A >& mWriter;
+  MergedReadsPool< A >&  mPool;
   PairedEnd::Merger< A > mMerger;
 };
 
 template < typename A >
-using ReadMerger = WorkerQueue< ReadMergerWorker< A >, PairedReads< A >,
-                                MergedReadWriter< A >* >;
+using ReadMerger =
+  WorkerQueue< ReadMergerWorker< A >, Numbered< PairedReads< A > >,
+               MergedReadWriter< A >*, MergedReadsPool< A >*, size_t >;
 
 bool DoMerge( const std::string& fwdPath, const std::string& revPath,
-              const std::string& mergedPath ) {
+              const std::string& mergedPath, const bool ordered,
+              const size_t numPriorPairs ) {
   const int numReadsPerWorkItem = 512;
 
-  PairedEnd::Reader< DNA > reader( fwdPath, revPath );
-  MergedReadWriter< DNA >  writer( 1, mergedPath );
-  ReadMerger< DNA >        merger( -1, &writer );
+  auto fwdReader =
+    DetectFileFormatAndOpenReader< DNA >( fwdPath, FileFormat::FASTQ );
+  auto revReader =
+    DetectFileFormatAndOpenReader< DNA >( revPath, FileFormat::FASTQ );
+  if( !fwdReader || !revReader )
+    return false;
+
+  // Owned by the paired reader from here on
+  const SequenceReader< DNA >& fwd = *fwdReader;
+  const SequenceReader< DNA >& rev = *revReader;
+
+  PairedEnd::Reader< DNA > reader( std::move( fwdReader ),
+                                   std::move( revReader ) );
+  MergedReadsPool< DNA >   pool;
+  MergedReadWriter< DNA >  writer( 1, mergedPath, &pool );
+  writer.SetOrdered( ordered );
+
+  ReadMerger< DNA > merger( -1, &writer, &pool, numPriorPairs );
 
   SequenceList< DNA > fwdReads, revReads;
 
@@ -121,12 +189,14 @@ bool DoMerge( const std::string& fwdPath, const std::string& revPath,
       progress.Set( ProgressType::WriteReads, numProcessed, numEnqueued );
     } );
 
+  size_t numWorkItems = 0;
   progress.Activate( ProgressType::ReadFile );
   while( !reader.EndOfFile() ) {
     reader.Read( numReadsPerWorkItem, &fwdReads, &revReads );
-    auto pair = std::pair< SequenceList< DNA >, SequenceList< DNA > >(
-      std::move( fwdReads ), std::move( revReads ) );
-    merger.Enqueue( pair );
+    auto item = Numbered< PairedReads< DNA > >(
+      numWorkItems++,
+      PairedReads< DNA >( std::move( fwdReads ), std::move( revReads ) ) );
+    merger.Enqueue( item );
     progress.Set( ProgressType::ReadFile, reader.NumBytesRead(),
                   reader.NumBytesTotal() );
   }
@@ -137,5 +207,8 @@ bool DoMerge( const std::string& fwdPath, const std::string& revPath,
   progress.Activate( ProgressType::WriteReads );
   writer.WaitTillDone();
 
-  return true;
+  // Pairs read are merged nevertheless
+  bool fwdFailed = ReportReadFailure( fwd, fwdPath );
+  bool revFailed = ReportReadFailure( rev, revPath );
+  return !fwdFailed && !revFailed;
 }
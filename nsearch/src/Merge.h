@@ -2,5 +2,8 @@
 
 #include <string>
 
+// Each merging thread learns an overlap prior from its first numPriorPairs
+// pairs (see PairedEnd::Merger), none if 0
 extern bool DoMerge( const std::string& fwdPath, const std::string& revPath,
-                     const std::string& mergedPath );
+                     const std::string& mergedPath, const bool ordered,
+                     const size_t numPriorPairs = 0 );
@@ -11,6 +11,7 @@
 
 #include "Common.h"
 #include "FileFormat.h"
+#include "Stats.h"
 #include "WorkerQueue.h"
 
 template < typename A >
@@ -32,9 +33,13 @@ public:
 template < typename A >
 class SearchResultsWriterWorker {
 public:
-  SearchResultsWriterWorker( const std::string& path )
-      : mWriter( std::move(
-          DetectFileFormatAndOpenHitWriter< A >( path, FileFormat::ALNOUT ) ) ) {}
+  SearchResultsWriterWorker( const std::string&       path,
+                             const SequenceList< A >* targets,
+                             const TSV::Columns*      columns )
+      : mWriter( std::move( DetectFileFormatAndOpenHitWriter< A >(
+          path, FileFormat::ALNOUT, *columns ) ) ) {
+    mWriter->WriteHeader( *targets );
+  }
 
   void Process( const QueryWithHitsList< A >& queryWithHitsList ) {
     for( auto& queryWithHits : queryWithHitsList ) {
@@ -49,7 +54,8 @@ private:
 template < typename A >
 using SearchResultsWriter =
   WorkerQueue< SearchResultsWriterWorker< A >, QueryWithHitsList< A >,
-               const std::string& >;
+               const std::string&, const SequenceList< A >*,
+               const TSV::Columns* >;
 
 template < typename A >
 class QueueItemInfo< SequenceList< A > > {
@@ -68,9 +74,14 @@ public:
       : mWriter( *writer ),
         mGlobalSearch( *database, params ) {}
 
-  void Process( const SequenceList< A >& queries ) {
+  void Process( const Numbered< SequenceList< A > >& numberedQueries ) {
+    const SequenceList< A >& queries = numberedQueries.second;
+
     QueryWithHitsList< A > list;
 
+    size_t numExtensions      = mGlobalSearch.NumExtensions();
+    size_t numExtensionsSaved = mGlobalSearch.NumExtensionsSaved();
+
     for( auto& query : queries ) {
       auto hits = mGlobalSearch.Query( query );
       if( hits.empty() )
@@ -79,9 +90,13 @@ public:
       list.push_back( { query, hits } );
     }
 
-    if( !list.empty() ) {
-      mWriter.Enqueue( list );
-    }
+    gStats.numProcessed += queries.size();
+    gStats.numExtensions += mGlobalSearch.NumExtensions() - numExtensions;
+    gStats.numExtensionsSaved +=
+      mGlobalSearch.NumExtensionsSaved() - numExtensionsSaved;
+
+    // Even if empty, the writer might wait for it to keep the order
+    mWriter.Enqueue( list, numberedQueries.first );
   }
 
 private:
@@ -91,7 +106,7 @@ private:
 
 template < typename A >
 using QueryDatabaseSearcher =
-  WorkerQueue< QueryDatabaseSearcherWorker< A >, SequenceList< A >,
+  WorkerQueue< QueryDatabaseSearcherWorker< A >, Numbered< SequenceList< A > >,
                SearchResultsWriter< A >*, const Database< A >*,
                const SearchParams< A >& >;
 
@@ -108,13 +123,17 @@ struct WordSize< Protein > {
 template < typename A >
 bool DoSearch( const std::string& queryPath, const std::string& databasePath,
                const std::string&       outputPath,
-               const SearchParams< A >& searchParams ) {
+               const SearchParams< A >& searchParams, const bool ordered,
+               const TSV::Columns& columns ) {
   ProgressOutput progress;
 
   Sequence< A >     seq;
   SequenceList< A > sequences;
 
   auto dbReader = DetectFileFormatAndOpenReader< A >( databasePath, FileFormat::FASTA );
+  auto qryReader = DetectFileFormatAndOpenReader< A >( queryPath, FileFormat::FASTA );
+  if( !dbReader || !qryReader )
+    return false;
 
   enum ProgressType {
     ReadDBFile,
@@ -134,12 +153,13 @@ bool DoSearch( const std::string& queryPath, const std::string& databasePath,
 
   // Read DB
   progress.Activate( ProgressType::ReadDBFile );
-  while( !dbReader->EndOfFile() ) {
-    (*dbReader) >> seq;
+  while( dbReader->Read( &seq ) ) {
     sequences.push_back( std::move( seq ) );
     progress.Set( ProgressType::ReadDBFile, dbReader->NumBytesRead(),
                   dbReader->NumBytesTotal() );
   }
+  if( ReportReadFailure( *dbReader, databasePath ) )
+    return false;
 
   // Index DB
   Database< A > db( WordSize< A >::VALUE );
@@ -165,7 +185,9 @@ bool DoSearch( const std::string& queryPath, const std::string& databasePath,
   // Read and process queries
   const int numQueriesPerWorkItem = 64;
 
-  SearchResultsWriter< A >   writer( 1, outputPath );
+  SearchResultsWriter< A > writer( 1, outputPath, &sequences, &columns );
+  writer.SetOrdered( ordered );
+
   QueryDatabaseSearcher< A > searcher( -1, &writer, &db, searchParams );
 
   searcher.OnProcessed( [&]( size_t numProcessed, size_t numEnqueued ) {
@@ -175,13 +197,14 @@ bool DoSearch( const std::string& queryPath, const std::string& databasePath,
     progress.Set( ProgressType::WriteHits, numProcessed, numEnqueued );
   } );
 
-  auto qryReader = DetectFileFormatAndOpenReader< A >( queryPath, FileFormat::FASTA );
-
   SequenceList< A > queries;
+  size_t            numWorkItems = 0;
   progress.Activate( ProgressType::ReadQueryFile );
   while( !qryReader->EndOfFile() ) {
     qryReader->Read( numQueriesPerWorkItem, &queries );
-    searcher.Enqueue( queries );
+    auto item = Numbered< SequenceList< A > >( numWorkItems++,
+                                               std::move( queries ) );
+    searcher.Enqueue( item );
     progress.Set( ProgressType::ReadQueryFile, qryReader->NumBytesRead(),
                   qryReader->NumBytesTotal() );
   }
@@ -193,12 +216,18 @@ bool DoSearch( const std::string& queryPath, const std::string& databasePath,
   progress.Activate( ProgressType::WriteHits );
   writer.WaitTillDone();
 
+  // Hits of the queries read are written nevertheless
+  if( ReportReadFailure( *qryReader, queryPath ) )
+    return false;
+
   return true;
 }
 
 // Explicit instantiation
 template bool DoSearch< DNA >( const std::string&, const std::string&,
-                               const std::string&, const SearchParams< DNA >& );
+                               const std::string&, const SearchParams< DNA >&,
+                               const bool, const TSV::Columns& );
 template bool DoSearch< Protein >( const std::string&, const std::string&,
                                    const std::string&,
-                                   const SearchParams< Protein >& );
+                                   const SearchParams< Protein >&, const bool,
+                                   const TSV::Columns& );
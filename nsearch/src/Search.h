@@ -1,6 +1,7 @@
 #pragma once
 
 #include <nsearch/Database/Search.h>
+#include <nsearch/TSV/Writer.h>
 
 #include <string>
 
@@ -8,4 +9,6 @@ template < typename Alphabet >
 extern bool DoSearch( const std::string&              queryPath,
                       const std::string&              databasePath,
                       const std::string&              outputPath,
-                      const SearchParams< Alphabet >& searchParams );
+                      const SearchParams< Alphabet >& searchParams,
+                      const bool                      ordered,
+                      const TSV::Columns&             columns );
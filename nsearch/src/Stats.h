@@ -1,20 +1,59 @@
 #pragma once
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <mutex>
+#include <vector>
 
 class Stats {
 public:
   std::atomic< size_t > numProcessed;
   std::atomic< size_t > numMerged;
   std::atomic< size_t > mergedReadsTotalLength;
+  std::atomic< size_t > numExtensions;
+  std::atomic< size_t > numExtensionsSaved;
 
-  Stats() : numProcessed( 0 ), numMerged( 0 ), mergedReadsTotalLength( 0 ) {}
+  Stats()
+      : numProcessed( 0 ), numMerged( 0 ), mergedReadsTotalLength( 0 ),
+        numExtensions( 0 ), numExtensionsSaved( 0 ) {}
 
   double MeanMergedLength() const {
     return float( mergedReadsTotalLength ) / numMerged;
   }
 
+  double ExtensionsSavedPerQuery() const {
+    return float( numExtensionsSaved ) / numProcessed;
+  }
+
+  // Number of merged pairs by overlap length, summed over the threads
+  void AddOverlapLengths( const std::vector< size_t >& counts ) {
+    std::lock_guard< std::mutex > lock( mOverlapLengthsMutex );
+    if( mOverlapLengths.size() < counts.size() )
+      mOverlapLengths.resize( counts.size(), 0 );
+    for( size_t i = 0; i < counts.size(); i++ )
+      mOverlapLengths[ i ] += counts[ i ];
+  }
+
+  // Most common first, up to max
+  std::vector< std::pair< size_t, size_t > >
+  MostCommonOverlapLengths( const size_t max ) const {
+    std::vector< std::pair< size_t, size_t > > lengths; // length, count
+    for( size_t i = 0; i < mOverlapLengths.size(); i++ ) {
+      if( mOverlapLengths[ i ] > 0 )
+        lengths.emplace_back( i, mOverlapLengths[ i ] );
+    }
+
+    std::stable_sort( lengths.begin(), lengths.end(),
+                      []( const std::pair< size_t, size_t >& a,
+                          const std::pair< size_t, size_t >& b ) {
+                        return a.second > b.second;
+                      } );
+    if( lengths.size() > max )
+      lengths.resize( max );
+    return lengths;
+  }
+
   void StartTimer() {
     mTimerStart = std::chrono::steady_clock::now();
   }
@@ -31,6 +70,9 @@ public:
   }
 
 private:
+  std::vector< size_t > mOverlapLengths;
+  std::mutex            mOverlapLengthsMutex;
+
   std::chrono::time_point< std::chrono::steady_clock > mTimerStart, mTimerStop;
 };
 
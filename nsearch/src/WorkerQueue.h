@@ -1,6 +1,7 @@
 #pragma once
 
 #include <deque>
+#include <map>
 #include <queue>
 #include <thread>
 #include <mutex>
@@ -15,6 +16,24 @@ public:
   }
 };
 
+// Work item numbered by its position in the input
+template < typename T >
+using Numbered = std::pair< size_t, T >;
+
+template < typename T >
+class QueueItemInfo< Numbered< T > > {
+public:
+  static size_t Count( const Numbered< T >& item ) {
+    return QueueItemInfo< T >::Count( item.second );
+  }
+};
+
+/*
+ * Items can be enqueued with their number instead, e.g. by the workers of a
+ * previous stage. In ordered mode, they are handed to the workers in that
+ * order (with a single worker, they are processed in order). At most
+ * maxPending items wait for a missing one, Enqueue blocks beyond that.
+ */
 template < class Worker, class QueueItem, typename... Args >
 class WorkerQueue {
 public:
@@ -22,7 +41,8 @@ public:
     std::function< void( const size_t, const size_t ) >;
 
   WorkerQueue( const int numWorkers = 1, Args... args )
-      : mStop( false ), mWorkingCount( 0 ), mTotalEnqueued( 0 ),
+      : mStop( false ), mWorkingCount( 0 ), mOrdered( false ),
+        mMaxPending( 0 ), mNextNumber( 0 ), mTotalEnqueued( 0 ),
         mTotalProcessed( 0 ) {
     auto actualWorkers =
       numWorkers <= 0 ? std::thread::hardware_concurrency() : numWorkers;
@@ -39,6 +59,7 @@ public:
   ~WorkerQueue() {
     mStop = true;
     mCondition.notify_all();
+    mPendingCondition.notify_all();
     for( auto& worker : mWorkers ) {
       if( worker.joinable() ) {
         worker.join();
@@ -57,8 +78,34 @@ public:
     mCondition.notify_one();
   }
 
+  void Enqueue( QueueItem& queueItem, const size_t number ) {
+    if( !mOrdered ) {
+      Enqueue( queueItem );
+      return;
+    }
+
+    {
+      std::unique_lock< std::mutex > lock( mQueueMutex );
+      while( !mStop && number >= mNextNumber + mMaxPending )
+        mPendingCondition.wait( lock );
+
+      mTotalEnqueued += QueueItemInfo< QueueItem >::Count( queueItem );
+      mPending[ number ] = std::move( queueItem );
+    }
+
+    // The item might be next
+    mCondition.notify_all();
+  }
+
+  // Call before enqueueing anything
+  void SetOrdered( const bool ordered, const size_t maxPending = 256 ) {
+    mOrdered    = ordered;
+    mMaxPending = maxPending;
+  }
+
   bool Done() const {
-    return mWorkingCount == 0 && mQueue.empty();
+    std::unique_lock< std::mutex > lock( mQueueMutex );
+    return mWorkingCount == 0 && mQueue.empty() && mPending.empty();
   }
 
   void WaitTillDone() {
@@ -75,16 +122,27 @@ private:
   std::deque< std::thread > mWorkers;
 
   std::condition_variable mCondition;
-  std::mutex              mQueueMutex;
+  mutable std::mutex      mQueueMutex;
   std::atomic< bool >     mStop;
   std::atomic< int >      mWorkingCount;
 
   std::queue< QueueItem > mQueue;
 
+  // Ordered mode
+  bool                          mOrdered;
+  size_t                        mMaxPending;
+  size_t                        mNextNumber;
+  std::map< size_t, QueueItem > mPending;
+  std::condition_variable       mPendingCondition;
+
   size_t                            mTotalEnqueued;
   size_t                            mTotalProcessed;
   std::deque< OnProcessedCallback > mProcessedCallbacks;
 
+  bool NextPending() const {
+    return !mPending.empty() && mPending.begin()->first == mNextNumber;
+  }
+
   void WorkerLoop( Args&&... args ) {
     QueueItem queueItem;
     Worker    worker( std::forward< Args >( args )... );
@@ -93,14 +151,22 @@ private:
       { // acquire lock
         std::unique_lock< std::mutex > lock( mQueueMutex );
 
-        while( !mStop && mQueue.empty() )
+        while( !mStop && mQueue.empty() && !NextPending() )
           mCondition.wait( lock );
 
         if( mStop )
           break;
 
-        queueItem = std::move( mQueue.front() );
-        mQueue.pop();
+        if( NextPending() ) {
+          auto it   = mPending.begin();
+          queueItem = std::move( it->second );
+          mPending.erase( it );
+          mNextNumber++;
+          mPendingCondition.notify_all();
+        } else {
+          queueItem = std::move( mQueue.front() );
+          mQueue.pop();
+        }
 
         mWorkingCount++;
       } // release lock